@@ -26,7 +26,11 @@
 /* Intrusive, lockless and hardware accelerated cryptography operations. */
 #include <hpc/compiler.h>
 
-#define CIPHER_CTXT_SIZE_MAX 512
+/* Sized for the largest registered context: keyed AES-GCM keeps the expanded
+ * key schedule and the GHASH table next to the record nonce. A backend only
+ * touches the first ctx_size bytes of struct cipher, so a table of per-flow
+ * contexts may pack them crypto_cipher_ctx_size apart instead (see below). */
+#define CIPHER_CTXT_SIZE_MAX 768
 
 enum {
 	C_TYPE_NONE = 0,
@@ -93,6 +97,7 @@ enum {
 	C_KUZNYECHIKCTR,
 	C_MAGMACTR,
 	C_28147CNT,
+	C_XCHACHA20,
 	C_LAST
 };
 
@@ -118,24 +123,86 @@ typedef void
 typedef void
 (*fn_cipher_set_key)(struct cipher *, const u8 *key, unsigned int len);
 
+/* set_key for |n| contexts at once: cipher[i] gets key[i], |len| bytes each */
 typedef void
-(*fn_cipher_set_iv)(struct cipher *, const u8 *iv, unsigned int len);
+(*fn_cipher_set_key_batch)(struct cipher *const *cipher, const u8 *const *key,
+                           unsigned int len, unsigned int n);
 
 typedef void
+(*fn_cipher_set_iv)(struct cipher *, const u8 *iv, unsigned int len);
+
+/*
+ * En/decrypt |len| bytes at |msg| in place, with no second buffer. AEADs
+ * frame it like fn_cipher_crypt: encrypt_inplace appends the mac_size tag
+ * after the payload (|msg| needs room for it), decrypt_inplace takes the
+ * payload plus its trailing tag and leaves the plaintext in the leading
+ * len - mac_size bytes. Returns non-zero if the record is too short or fails
+ * authentication; no plaintext is left in |msg| then.
+ */
+typedef int
 (*fn_cipher_crypt_inplace)(struct cipher *, u8 *msg, unsigned int len);
 
 typedef void
 (*fn_cipher_crypt)(struct cipher *, const u8 *msg, unsigned int len, u8 *out,
                    unsigned int *out_len);
 
+/*
+ * AEAD seal/open with associated data (e.g. the TLS record header). Framing
+ * follows fn_cipher_crypt: seal appends the mac_size tag to |out|, open
+ * expects it trailing |msg|. *out_len is 0 when open fails authentication.
+ */
+typedef void
+(*fn_cipher_aead)(struct cipher *, const u8 *aad, unsigned int aad_len,
+                  const u8 *msg, unsigned int len, u8 *out,
+                  unsigned int *out_len);
+
+/*
+ * AEAD seal/open for TLS 1.2 GCM records (RFC 5288): the 4-byte implicit
+ * salt is the IV given at init/set_iv, |nonce| is the record's 8-byte
+ * explicit nonce (or sequence number). The backend merges the two itself,
+ * so a record needs no set_iv call. Framing follows fn_cipher_aead.
+ */
+typedef void
+(*fn_cipher_aead_explicit)(struct cipher *, u64 nonce,
+                           const u8 *aad, unsigned int aad_len,
+                           const u8 *msg, unsigned int len, u8 *out,
+                           unsigned int *out_len);
+
+/*
+ * Vectored AEAD over a record held as a chain of buffers (e.g. packet
+ * buffers of a capture ring): the payload is read from the |src| segments
+ * and written to the |dst| segments, which carry the same total length but
+ * may be split differently; a dst segment may alias its src bytes for
+ * in-place. The keystream and the MAC run across segment boundaries, so
+ * nothing is linearized. seal_iov writes the mac_size tag to |tag|;
+ * open_iov checks it and returns non-zero (with |dst| zeroed) on failure.
+ */
+struct cipher_iovec {
+	u8 *base;
+	unsigned int len;
+};
+
+typedef int
+(*fn_cipher_aead_iov)(struct cipher *, const u8 *aad, unsigned int aad_len,
+                      const struct cipher_iovec *src, unsigned int src_cnt,
+                      const struct cipher_iovec *dst, unsigned int dst_cnt,
+                      u8 *tag);
+
 struct cipher_algorithm {
 	fn_cipher_init init;
 	fn_cipher_crypt decrypt;
 	fn_cipher_crypt encrypt;
 	fn_cipher_crypt_inplace decrypt_inplace;
 	fn_cipher_crypt_inplace encrypt_inplace;
+	fn_cipher_aead open;
+	fn_cipher_aead seal;
+	fn_cipher_aead_iov open_iov;
+	fn_cipher_aead_iov seal_iov;
+	fn_cipher_aead_explicit open_explicit;
+	fn_cipher_aead_explicit seal_explicit;
 	fn_cipher_set_mac set_mac;
 	fn_cipher_set_key set_key;
+	fn_cipher_set_key_batch set_key_batch;
 	fn_cipher_set_iv set_iv;
 	fn_cipher_set_encrypt_then_mac set_encrypt_then_mac;
 	unsigned int ctx_size;
@@ -159,6 +226,83 @@ void crypto_cipher_register(struct cipher_algorithm *alg);
 struct cipher_algorithm *crypto_cipher_by_id(unsigned int id);
 void crypto_cipher_enum(fn_cipher_enum fn);
 
+/*
+ * Re-key |n| contexts of |alg| in one call, e.g. for the traffic keys
+ * derived by a burst of handshakes. Algorithms with a batched key schedule
+ * (AES-GCM) interleave the expansions; the others take set_key per context.
+ */
+static inline void
+crypto_cipher_setkey_batch(const struct cipher_algorithm *alg,
+                           struct cipher *const *cipher, const u8 *const *key,
+                           unsigned int len, unsigned int n)
+{
+	if (alg->set_key_batch) {
+		alg->set_key_batch(cipher, key, len, n);
+		return;
+	}
+	for (unsigned int i = 0; i < n; i++)
+		alg->set_key(cipher[i], key[i], len);
+}
+
+/*
+ * Compact per-flow state: the bytes to allocate for one context of |alg|,
+ * ctx_size rounded up to the alignment of struct cipher so consecutive
+ * contexts stay aligned. Pass the result of a (struct cipher *) cast to the
+ * algorithm's callbacks as usual; the backends never reach past ctx_size.
+ */
+#define CIPHER_CTXT_ALIGN __alignof__(struct cipher)
+
+static inline unsigned int
+crypto_cipher_ctx_size(const struct cipher_algorithm *alg)
+{
+	return (alg->ctx_size + CIPHER_CTXT_ALIGN - 1) &
+	       ~(unsigned int)(CIPHER_CTXT_ALIGN - 1);
+}
+
+/*
+ * Walk |src| and |dst| side by side for the open_iov/seal_iov backends,
+ * handing |step| the largest run that lies within one segment of each.
+ * Returns the bytes walked, or -1 when the two chains differ in length.
+ */
+typedef void (*fn_cipher_iov_step)(void *state, const u8 *in, u8 *out,
+                                   unsigned int len);
+
+static inline long
+cipher_iov_walk(const struct cipher_iovec *src, unsigned int src_cnt,
+                const struct cipher_iovec *dst, unsigned int dst_cnt,
+                fn_cipher_iov_step step, void *state)
+{
+	unsigned int si = 0, di = 0, soff = 0, doff = 0, n;
+	long total = 0;
+
+	for (;;) {
+		while (si < src_cnt && soff == src[si].len)
+			si++, soff = 0;
+		while (di < dst_cnt && doff == dst[di].len)
+			di++, doff = 0;
+		if (si == src_cnt || di == dst_cnt)
+			break;
+
+		n = src[si].len - soff;
+		if (n > dst[di].len - doff)
+			n = dst[di].len - doff;
+		step(state, src[si].base + soff, dst[di].base + doff, n);
+		soff += n;
+		doff += n;
+		total += n;
+	}
+	return si == src_cnt && di == dst_cnt ? total : -1;
+}
+
+/* Zero the |dst| chain after a failed open_iov. */
+static inline void
+cipher_iov_zero(const struct cipher_iovec *dst, unsigned int dst_cnt)
+{
+	for (unsigned int i = 0; i < dst_cnt; i++)
+		for (unsigned int j = 0; j < dst[i].len; j++)
+			dst[i].base[j] = 0;
+}
+
 #if !defined(CONFIG_MODULES) && !defined(__CRYPTO_CIPHER_MODULE__)
 #define __CRYPTO_CIPHER_BUILT_IN_READY__
 #ifdef CONFIG_CRYPTO_CIPHER_AES
@@ -8,17 +8,27 @@
 #define AES128_keyExpSize 176
 
 /*
- * Accelerated backends (e.g. aws-lc AES-NI / ARMv8) reinterpret the ctx
- * storage below as their own, smaller state (raw key + IV; the key schedule
- * is (re)built by the hardware per operation). The generic table-based
- * implementation only ever touches the named fields. The accelerated glue
- * carries a _Static_assert that its state fits within sizeof(struct aesN_ctx).
+ * The backends on the aws-lc CBC glue (AES-NI / ARMv8, and the constant-time
+ * one) reinterpret the ctx storage below as their own state: the expanded
+ * encrypt and decrypt key schedules, built once by aesN_cbc_init, plus the
+ * chaining IV. The generic table-based implementation only ever touches the
+ * named fields, so the trailing headroom for the two schedules is there only
+ * when one of the others is configured, built in or as a module
+ * (CONFIG_CRYPTO_CIPHER_AES_HW_CTX). The glue carries a _Static_assert that
+ * its state fits within sizeof(struct aesN_ctx).
  */
+#ifdef CONFIG_CRYPTO_CIPHER_AES_HW_CTX
+#define AES_CTX_ACCEL_HEADROOM 304
+#endif
+
 struct aes128_ctx {
 	u8 RoundKey[AES128_keyExpSize];
 	u8 Iv[AES_BLOCKLEN];
 	const u8 *key;
 	const u8 *iv;
+#ifdef AES_CTX_ACCEL_HEADROOM
+	u8 _accel_headroom[AES_CTX_ACCEL_HEADROOM];
+#endif
 };
 
 #define AES256_KEYLEN 32
@@ -29,14 +39,26 @@ struct aes256_ctx {
 	u8 Iv[AES_BLOCKLEN];
 	const u8 *key;
 	const u8 *iv;
+#ifdef AES_CTX_ACCEL_HEADROOM
+	u8 _accel_headroom[AES_CTX_ACCEL_HEADROOM];
+#endif
 };
 
+/*
+ * aesN_cbc_init expands the key; the IV is set separately (set_iv, or both at
+ * once with init_ctx_iv). encrypt/decrypt chain the IV across calls, so a
+ * stream of records under one key only re-runs set_iv per record.
+ */
+
 void
 aes128_cbc_init(struct aes128_ctx *aes, const u8 *key);
 
 void
 aes128_cbc_init_ctx_iv(struct aes128_ctx *ctx, const u8 *key, const u8 *iv);
 
+void
+aes128_cbc_set_iv(struct aes128_ctx *ctx, const u8 *iv);
+
 void
 aes128_cbc_encrypt(struct aes128_ctx *ctx, u8 *buf, u32 length);
 
@@ -49,12 +71,76 @@ aes256_cbc_init(struct aes256_ctx *aes, const u8 *key);
 void
 aes256_cbc_init_ctx_iv(struct aes256_ctx *ctx, const u8 *key, const u8 *iv);
 
+void
+aes256_cbc_set_iv(struct aes256_ctx *ctx, const u8 *iv);
+
 void
 aes256_cbc_encrypt(struct aes256_ctx *ctx, u8 *buf, u32 length);
 
 void
 aes256_cbc_decrypt(struct aes256_ctx *ctx, u8 *buf, u32 length);
 
+/*
+ * AES-CTR keystream (NIST SP800-38A), 128-, 192- or 256-bit keys. The 16-byte
+ * initial counter block is incremented as one 128-bit big-endian integer per
+ * block. aes_ctr_crypt XORs |len| bytes of keystream into |in| -> |out|
+ * (|out| may equal |in|; encrypt and decrypt are the same operation) and
+ * keeps the unused tail of the last keystream block, so a message may be
+ * split across calls at any byte boundary. aes_ctr_set_iv rewinds to a new
+ * counter block and drops that tail.
+ *
+ * The storage is reinterpreted by each backend like struct aes_gcm_key; the
+ * accelerated backends run whole blocks through the hardware ctr32 kernel.
+ */
+#define AES_CTR_CTX_SIZE 384
+
+struct aes_ctr_ctx {
+	u8 data[AES_CTR_CTX_SIZE] _align_max;
+};
+
+/* Returns 0 on success, non-zero for a key length other than 16/24/32. */
+int
+aes_ctr_setkey(struct aes_ctr_ctx *ctx, const u8 *key, size_t key_len);
+
+void
+aes_ctr_set_iv(struct aes_ctr_ctx *ctx, const u8 iv[AES_BLOCKLEN]);
+
+void
+aes_ctr_crypt(struct aes_ctr_ctx *ctx, const u8 *in, u8 *out, size_t len);
+
+/*
+ * Keyed AES-CCM AEAD (NIST SP800-38C, RFC 3610), as used by the TLS
+ * AES_128_CCM and AES_128_CCM_8 suites. aes_ccm_setkey fixes the key and the
+ * tag length (4..16, even: 16 for CCM, 8 for CCM_8). The nonce is 7..13 bytes
+ * (12 in TLS); a shorter nonce leaves a longer message length field, so
+ * records are limited to 2^(8 * (15 - nonce_len)) - 1 bytes.
+ *
+ * Framing and return values follow aes_gcm_seal/aes_gcm_open: seal appends
+ * the tag to |output|, open expects it trailing |input| and returns non-zero
+ * (with |output| zeroed) when it does not verify. |output| may equal |input|.
+ * The storage is reinterpreted by each backend like struct aes_gcm_key.
+ */
+#define AES_CCM_KEY_CTX_SIZE 320
+
+struct aes_ccm_key {
+	u8 data[AES_CCM_KEY_CTX_SIZE] _align_max;
+};
+
+/* Returns 0 on success, non-zero for a bad key or tag length. */
+int
+aes_ccm_setkey(struct aes_ccm_key *ccm, const u8 *key, size_t key_len,
+               size_t tag_len);
+
+int
+aes_ccm_seal(struct aes_ccm_key *ccm, u8 *output, const u8 *input,
+             int input_length, const u8 *nonce, size_t nonce_len,
+             const u8 *aad, size_t aad_len);
+
+int
+aes_ccm_open(struct aes_ccm_key *ccm, u8 *output, const u8 *input,
+             int input_length, const u8 *nonce, size_t nonce_len,
+             const u8 *aad, size_t aad_len);
+
 /*
  * AES-GCM AEAD (no associated data, 12-byte IV, 16-byte tag).
  *
@@ -69,4 +155,156 @@ int
 aes_gcm_decrypt(u8 *output, const u8 *input, int input_length,
          const u8* key, const size_t key_len, const u8 *iv, const size_t iv_len);
 
+/*
+ * Keyed AES-GCM. aes_gcm_setkey expands the AES key schedule and the GHASH
+ * table once; aes_gcm_seal/aes_gcm_open reuse them for every record under
+ * that key, so a record only pays for its payload. Framing and return values
+ * match aes_gcm_encrypt/aes_gcm_decrypt above; |aad| (may be NULL when
+ * |aad_len| is 0) is authenticated but not encrypted.
+ *
+ * Like struct aesN_ctx, the storage is reinterpreted by each backend (the
+ * generic gcm_context, or the aws-lc AES_KEY + Htable); the glue carries a
+ * _Static_assert that its keyed state fits. A key is not shared between
+ * concurrent seal/open calls (the generic backend keeps per-record state in
+ * it).
+ */
+#define AES_GCM_KEY_CTX_SIZE 640
+
+struct aes_gcm_key {
+	u8 data[AES_GCM_KEY_CTX_SIZE] _align_max;
+};
+
+/* Returns 0 on success, non-zero for a key length other than 16/24/32. */
+int
+aes_gcm_setkey(struct aes_gcm_key *gcm, const u8 *key, size_t key_len);
+
+/*
+ * Key |n| contexts at once, e.g. the traffic keys of a burst of handshakes:
+ * gcm[i] gets key[i], each |key_len| bytes. The result is that of n
+ * aes_gcm_setkey calls; the x86_64 aws-lc backends expand several keys and
+ * their hash subkeys in interleaved AES-NI chains. Returns 0 on success,
+ * non-zero for a key length other than 16/24/32.
+ */
+int
+aes_gcm_setkey_batch(struct aes_gcm_key *const *gcm, const u8 *const *key,
+                     size_t key_len, unsigned int n);
+
+/*
+ * aes_gcm_setkey pinned to one GCM bulk kernel rather than the best the CPU
+ * runs, so a benchmark can compare kernels in one build. The generic backend
+ * only has AES_GCM_BULK_GHASH. Returns non-zero for a bad key length, or a
+ * kernel the backend lacks or the CPU cannot run.
+ */
+enum aes_gcm_bulk {
+	AES_GCM_BULK_BEST,	/* what aes_gcm_setkey picks */
+	AES_GCM_BULK_GHASH,	/* separate CTR and GHASH passes */
+	AES_GCM_BULK_AESNI,	/* stitched AES-NI + CLMUL, x86_64 aws-lc */
+	AES_GCM_BULK_VAES,	/* VAES + VPCLMULQDQ, the VAES backend */
+};
+
+int
+aes_gcm_setkey_bulk(struct aes_gcm_key *gcm, const u8 *key, size_t key_len,
+                    enum aes_gcm_bulk bulk);
+
+/*
+ * Bytes of struct aes_gcm_key the linked backend actually uses (eight cache
+ * lines for the aws-lc backends, the gcm_context for the generic one). No
+ * backend reads or writes past it, so a caller packing many keys per flow
+ * may allocate just this much, rounded up to the alignment of the struct.
+ */
+size_t
+aes_gcm_key_size(void);
+
+int
+aes_gcm_seal(struct aes_gcm_key *gcm, u8 *output, const u8 *input,
+             int input_length, const u8 *iv, size_t iv_len,
+             const u8 *aad, size_t aad_len);
+
+int
+aes_gcm_open(struct aes_gcm_key *gcm, u8 *output, const u8 *input,
+             int input_length, const u8 *iv, size_t iv_len,
+             const u8 *aad, size_t aad_len);
+
+/*
+ * TLS 1.2 GCM nonce (RFC 5288): the 4-byte implicit |salt| from the key
+ * block followed by the record's 8-byte explicit nonce, both taken as
+ * integers and written big-endian straight into the counter block, so no
+ * 12-byte IV is assembled or copied per record. Otherwise identical to
+ * aes_gcm_seal/aes_gcm_open.
+ */
+int
+aes_gcm_seal_explicit(struct aes_gcm_key *gcm, u8 *output, const u8 *input,
+                      int input_length, u32 salt, u64 explicit_nonce,
+                      const u8 *aad, size_t aad_len);
+
+int
+aes_gcm_open_explicit(struct aes_gcm_key *gcm, u8 *output, const u8 *input,
+                      int input_length, u32 salt, u64 explicit_nonce,
+                      const u8 *aad, size_t aad_len);
+
+/*
+ * Streaming AES-GCM over a keyed context, for records that arrive in pieces
+ * (e.g. a 16 KiB TLS record split across TCP segments): init takes the nonce
+ * and the associated data, update en/decrypts the next |len| bytes of the
+ * record from |in| to |out| (|out| may equal |in|; any length, each piece is
+ * consumed where it lies instead of being reassembled first), final computes
+ * the tag. After an encrypt stream final writes the 16-byte tag to |tag|;
+ * after a decrypt stream it compares |tag| in constant time and returns
+ * non-zero on mismatch, like aes_gcm_open. Decrypted pieces are released
+ * before the tag is checked: the caller must not act on them until final
+ * returns 0.
+ *
+ * The stream borrows |gcm| until final; the generic backend runs the record
+ * state inside it, so one key feeds one stream at a time.
+ */
+#define AES_GCM_STREAM_CTX_SIZE 128
+
+struct aes_gcm_stream {
+	u8 data[AES_GCM_STREAM_CTX_SIZE] _align_max;
+};
+
+/* |enc| is non-zero to seal, zero to open. Returns 0 on success. */
+int
+aes_gcm_stream_init(struct aes_gcm_stream *st, struct aes_gcm_key *gcm,
+                    int enc, const u8 *iv, size_t iv_len,
+                    const u8 *aad, size_t aad_len);
+
+void
+aes_gcm_stream_update(struct aes_gcm_stream *st, const u8 *in, u8 *out,
+                      size_t len);
+
+int
+aes_gcm_stream_final(struct aes_gcm_stream *st, u8 tag[16]);
+
+/*
+ * Multi-buffer AES-GCM open: verify and decrypt |n| independent records,
+ * each under its own keyed context (several may share one), in one call.
+ * A record of a few blocks cannot keep the AES and carry-less multiply
+ * pipelines full on its own; the x86_64 aws-lc backends decrypt records of
+ * up to 128 bytes block for block side by side, so their dependency chains
+ * overlap. Longer records, and the other backends, go one after another
+ * through the aes_gcm_open path.
+ *
+ * Each record carries its ciphertext (|len| bytes, without the tag) and its
+ * 16-byte |tag| separately; |out| may equal |in|. |status| is set per record
+ * like the aes_gcm_open return value, and a record that fails verification
+ * has its |out| zeroed. Returns the number of records that failed.
+ */
+#define AES_GCM_MB_LANES 8
+
+struct aes_gcm_mb {
+	struct aes_gcm_key *key;
+	const u8 *iv;			/* 12 bytes */
+	const u8 *aad;
+	size_t aad_len;
+	const u8 *in;
+	u8 *out;
+	size_t len;
+	const u8 *tag;			/* 16 bytes */
+	int status;
+};
+
+unsigned int
+aes_gcm_open_mb(struct aes_gcm_mb *rec, unsigned int n);
+
 #endif
@@ -42,4 +42,8 @@ void chacha_keysetup(struct chacha_ctx *x, const u8 *k, u32 kbits);
 void chacha_ivsetup(struct chacha_ctx *x, const u8 *iv, const u8 *ctr);
 void chacha_encrypt_bytes(struct chacha_ctx *x, const u8 *m, u8 *c, u32 bytes);
 
+/* Cipher desc naming the ChaCha20 kernel this CPU runs, e.g.
+ * "ChaCha20-Poly1305 (aws-lc, AVX2)"; the generic backend has just one. */
+const char *chacha_desc(void);
+
 #endif	/* CHACHA_H */
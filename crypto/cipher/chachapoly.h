@@ -31,6 +31,8 @@
 #define CHACHAPOLY_OK           0
 #define CHACHAPOLY_INVALID_MAC  -1
 
+#define XCHACHAPOLY_NONCE_LEN   24
+
 struct chachapoly_ctx {
     struct chacha_ctx cha_ctx;
 };
@@ -46,6 +48,32 @@ struct chachapoly_ctx {
  */
 int chachapoly_init(struct chachapoly_ctx *ctx, const void *key, int key_len);
 
+/**
+ * HChaCha20 (draft-irtf-cfrg-xchacha, section 2.2): the ChaCha20 core with
+ * the counter and nonce words replaced by a 16 byte input, and without the
+ * final feed-forward; words 0-3 and 12-15 of the result form the subkey.
+ *
+ * \param out 32 byte subkey output
+ * \param key 32 bytes of key material
+ * \param nonce first 16 bytes of the extended nonce
+ */
+void hchacha20(void *out, const void *key, const void *nonce);
+
+/**
+ * Initialize XChaCha20-Poly1305 for one extended nonce. The context is keyed
+ * with the HChaCha20 subkey, so chachapoly_crypt and the stream API then run
+ * the record on the same ChaCha20 kernels as the 96-bit nonce AEAD.
+ *
+ * \param ctx context data
+ * \param key 32 bytes of key material
+ * \param nonce extended nonce (24 bytes)
+ * \param nonce12 nonce output (12 bytes) to pass to chachapoly_crypt:
+ *        four zero bytes followed by the last 8 bytes of nonce
+ * \return success if 0
+ */
+int xchachapoly_init(struct chachapoly_ctx *ctx, const void *key,
+        const void *nonce, void *nonce12);
+
 /**
  * Encrypt or decrypt with ChaCha20-Poly1305. The AEAD construction conforms
  * to RFC 7539.
@@ -63,11 +91,98 @@ int chachapoly_init(struct chachapoly_ctx *ctx, const void *key, int key_len);
  * \param encrypt decrypt if 0, else encrypt
  * \return CHACHAPOLY_OK if no error, CHACHAPOLY_INVALID_MAC if auth
  *         failed when decrypting
+ *
+ * output may equal input. The aws-lc backends built with
+ * CONFIG_CRYPTO_CIPHER_CHACHA20_AWS_FUSED decrypt and authenticate in one
+ * pass, so a failed decrypt into a separate output leaves it zeroed rather
+ * than untouched. An in-place decrypt always checks the tag first and leaves
+ * a forged record as it was.
  */
 int chachapoly_crypt(struct chachapoly_ctx *ctx, const void *nonce,
-        const void *ad, int ad_len, void *input, int input_len,
+        const void *ad, int ad_len, const void *input, int input_len,
         void *output, void *tag, int tag_len, int encrypt);
 
+/**
+ * One record of a chachapoly_crypt_mb batch. Records are independent and
+ * several may share a ctx.
+ */
+struct chachapoly_mb {
+    struct chachapoly_ctx *ctx;
+    const void *nonce;      /* 12 bytes */
+    const void *ad;
+    int ad_len;
+    const void *in;
+    void *out;              /* may equal in */
+    int len;
+    void *tag;              /* 16 bytes, written when encrypting */
+    int status;             /* CHACHAPOLY_OK or CHACHAPOLY_INVALID_MAC */
+};
+
+/**
+ * Encrypt or decrypt a batch of short records (QUIC or DTLS packets) with
+ * ChaCha20-Poly1305, as n chachapoly_crypt calls with 16 byte tags would.
+ * The Poly1305 tags of the records are computed together through
+ * poly1305_update_mb, one record per vector lane. As in chachapoly_crypt a
+ * record is authenticated before it is decrypted, so a record that fails
+ * leaves its output untouched.
+ *
+ * \param rec records
+ * \param n number of records
+ * \param encrypt decrypt if 0, else encrypt
+ * \return the number of records that failed authentication
+ */
+unsigned int chachapoly_crypt_mb(struct chachapoly_mb *rec, unsigned int n,
+        int encrypt);
+
+/**
+ * Streaming ChaCha20-Poly1305 (RFC 7539) for a record that is not contiguous
+ * in memory. Unlike chachapoly_crypt, which checks the tag before decrypting,
+ * a decrypt stream releases plaintext as it goes and only reports the tag
+ * at chachapoly_stream_final; callers must discard the output on failure.
+ * The stream runs on ctx's ChaCha state, so one ctx feeds one stream at a
+ * time.
+ */
+struct chachapoly_stream {
+    struct chachapoly_ctx *ctx;
+    struct poly1305_context poly;
+    unsigned char keystream[CHACHA_BLOCKLEN];
+    unsigned int num;       /* keystream bytes used, 0 when block-aligned */
+    uint64_t ad_len;
+    uint64_t len;
+    int encrypt;
+};
+
+/**
+ * Start a record: derive the Poly1305 key and absorb the associated data.
+ *
+ * \param st stream state
+ * \param ctx context data, keyed by chachapoly_init
+ * \param nonce nonce (12 bytes)
+ * \param ad associated data
+ * \param ad_len associated data length in bytes
+ * \param encrypt decrypt if 0, else encrypt
+ */
+void chachapoly_stream_init(struct chachapoly_stream *st,
+        struct chachapoly_ctx *ctx, const void *nonce,
+        const void *ad, int ad_len, int encrypt);
+
+/**
+ * Encrypt or decrypt the next piece of the record. Pieces may have any
+ * length; output may equal input.
+ */
+void chachapoly_stream_update(struct chachapoly_stream *st,
+        const void *input, void *output, size_t len);
+
+/**
+ * Finish the record. Writes the tag when encrypting; compares it when
+ * decrypting.
+ *
+ * \return CHACHAPOLY_OK, or CHACHAPOLY_INVALID_MAC if auth failed when
+ *         decrypting
+ */
+int chachapoly_stream_final(struct chachapoly_stream *st, void *tag,
+        int tag_len);
+
 /**
  * Encrypt or decrypt with Chacha20-Poly1305 for short messages.
  * The AEAD construction is different from chachapoly_crypt, but more
@@ -76,7 +191,7 @@ int chachapoly_crypt(struct chachapoly_ctx *ctx, const void *nonce,
  * chachapoly_crypt.
  */
 int chachapoly_crypt_short(struct chachapoly_ctx *ctx, const void *nonce,
-        const void *ad, int ad_len, void *input, int input_len,
+        const void *ad, int ad_len, const void *input, int input_len,
         void *output, void *tag, int tag_len, int encrypt);
 
 #endif
@@ -15,6 +15,18 @@
 /* use unaligned little-endian load/store (can be faster) */
 #define USE_UNALIGNED       0
 
+/*
+ * The fields are the state of the portable 32-bit donna code (poly1305.c).
+ * The donna-64 and AVX2/NEON backends (CONFIG_CRYPTO_CIPHER_POLY1305_DONNA64)
+ * reinterpret the storage as their own state; the headroom holds the wider
+ * limbs and the powers of r the vector lanes multiply by, and is there only
+ * when one of them is configured. Keep in sync with the _Static_assert in
+ * poly1305-64.h.
+ */
+#ifdef CONFIG_CRYPTO_CIPHER_POLY1305_DONNA64
+#define POLY1305_CTX_ACCEL_HEADROOM 96
+#endif
+
 struct poly1305_context {
     u32 r[5];
     u32 h[5];
@@ -22,6 +34,9 @@ struct poly1305_context {
     size_t leftover;
     u8 buffer[POLY1305_BLOCK_SIZE];
     u8 final;
+#ifdef POLY1305_CTX_ACCEL_HEADROOM
+    u8 _accel_headroom[POLY1305_CTX_ACCEL_HEADROOM];
+#endif
 };
 
 void poly1305_init(struct poly1305_context *ctx, const u8 key[32]);
@@ -29,4 +44,34 @@ void poly1305_update(struct poly1305_context *ctx, const u8 *m, size_t bytes);
 void poly1305_finish(struct poly1305_context *ctx, u8 mac[16]);
 void poly1305_auth(u8 mac[16], const u8 *m, size_t bytes, const u8 key[32]);
 
+/*
+ * Multi-message Poly1305, for many short packets (QUIC, DTLS) where the
+ * per-message work is too little to fill the vector lanes of one message.
+ * The donna-64 AVX2/NEON backends run one message per lane instead, a lane
+ * taking the next message as soon as its own runs out; the other backends
+ * loop over the single-message calls.
+ *
+ * poly1305_update_mb is |n| poly1305_update calls, ctx[i] absorbing len[i]
+ * bytes at m[i]. The contexts are independent and may be mid-message.
+ */
+void poly1305_update_mb(struct poly1305_context *const *ctx,
+                        const u8 *const *m, const size_t *len, unsigned int n);
+
+/*
+ * One (key, message) pair. poly1305_auth_mb writes each tag to |mac|;
+ * poly1305_verify_mb compares |mac| against the computed tag in constant
+ * time, sets |status| to 0 on a match and non-zero otherwise, and returns the
+ * number of mismatches.
+ */
+struct poly1305_mb {
+    const u8 *key;          /* 32-byte one-time key */
+    const u8 *msg;
+    size_t len;
+    u8 *mac;                /* 16 bytes */
+    int status;
+};
+
+void poly1305_auth_mb(struct poly1305_mb *job, unsigned int n);
+unsigned int poly1305_verify_mb(struct poly1305_mb *job, unsigned int n);
+
 #endif /* POLY1305_H */
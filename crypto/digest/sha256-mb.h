@@ -0,0 +1,55 @@
+#ifndef __CRYPTO_DIGEST_SHA256_MB_H__
+#define __CRYPTO_DIGEST_SHA256_MB_H__
+
+#include <hpc/compiler.h>
+#include <stddef.h>
+
+/*
+ * Multi-buffer SHA-256: independent messages hashed side by side, one per
+ * SIMD lane (16 with AVX-512, 8 with AVX2, 4 with NEON or portable C), for
+ * many short messages where the one-stream sha256_update spends its time in
+ * the serial dependency chain of a single block.
+ *
+ * A job handed to sha256_mb_submit belongs to the manager until submit or
+ * sha256_mb_flush returns it with |digest| filled in. Submit only runs the
+ * lanes once they are all taken, and then returns the first job to finish;
+ * flush runs whatever is left and returns one job per call, NULL once the
+ * manager is empty. Jobs come back out of order; |user| is not touched. The
+ * message must stay readable until its job comes back.
+ */
+#define SHA256_MB_LANES_MAX 16
+
+struct sha256_mb_job {
+	const u8 *msg;
+	size_t len;
+	void *user;
+	u8 digest[32];
+};
+
+struct sha256_mb_lane {
+	struct sha256_mb_job *job;
+	const u8 *p;            /* next block to hash */
+	size_t blocks;          /* blocks left at p */
+	unsigned int tail;      /* padding blocks still to run after p */
+	u8 pad[128];            /* message tail, 0x80, zeros, bit length */
+};
+
+struct sha256_mb_mgr {
+	u32 h[8][SHA256_MB_LANES_MAX];  /* state, h[word][lane] */
+	struct sha256_mb_lane lane[SHA256_MB_LANES_MAX];
+	unsigned int lanes;             /* lanes of the picked kernel */
+	unsigned int busy;              /* bit i: lane i holds a job */
+};
+
+void sha256_mb_init(struct sha256_mb_mgr *mgr);
+struct sha256_mb_job *sha256_mb_submit(struct sha256_mb_mgr *mgr,
+                                       struct sha256_mb_job *job);
+struct sha256_mb_job *sha256_mb_flush(struct sha256_mb_mgr *mgr);
+
+/* all |n| jobs through a manager on the stack */
+void sha256_mb(struct sha256_mb_job *job, unsigned int n);
+
+/* kernel picked for this CPU, e.g. "SHA2-256 x8 (AVX2)" */
+const char *sha256_mb_desc(void);
+
+#endif
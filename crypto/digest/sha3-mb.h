@@ -0,0 +1,51 @@
+#ifndef __CRYPTO_DIGEST_SHA3_MB_H__
+#define __CRYPTO_DIGEST_SHA3_MB_H__
+
+#include <hpc/compiler.h>
+#include <stddef.h>
+
+/*
+ * Batched SHA-3 and SHAKE: n independent messages of the same length run
+ * through one parallel Keccak-f[1600], one state per SIMD lane (8 with
+ * AVX-512, 4 with AVX2, otherwise one at a time through the built-in SHA-3
+ * backend's permutation, or portable C with SHA-3 as a module). Meant for
+ * the many short equal-sized inputs of ML-KEM, e.g. the k * k
+ * SHAKE128(rho || j || i) streams of the public matrix.
+ *
+ * The one-shot calls write out[i] = H(in[i][0 .. len)) for i < n.
+ *
+ * shake128_mb_absorb / shake256_mb_absorb leave each sha3[i] holding the
+ * padded state of in[i] with partial == rsiz (nothing left to read), and
+ * shake_mb_squeezeblocks then writes |blocks| whole blocks of rsiz bytes to
+ * each out[i], so rejection sampling can ask for more until it has enough.
+ * All states of one squeeze call must come from the same absorb function
+ * and sit at a block boundary. Any state can also carry on alone with
+ * shake_squeeze (crypto/digest/shake.h).
+ */
+#define SHA3_MB_LANES_MAX 8
+
+#define SHAKE128_RATE   168
+#define SHAKE256_RATE   136
+
+struct sha3;
+
+void sha3_256_mb(u8 *const out[], const u8 *const in[], size_t len,
+                 unsigned int n);
+void sha3_512_mb(u8 *const out[], const u8 *const in[], size_t len,
+                 unsigned int n);
+void shake128_mb(u8 *const out[], size_t outlen, const u8 *const in[],
+                 size_t len, unsigned int n);
+void shake256_mb(u8 *const out[], size_t outlen, const u8 *const in[],
+                 size_t len, unsigned int n);
+
+void shake128_mb_absorb(struct sha3 *const sha3[], const u8 *const in[],
+                        size_t len, unsigned int n);
+void shake256_mb_absorb(struct sha3 *const sha3[], const u8 *const in[],
+                        size_t len, unsigned int n);
+void shake_mb_squeezeblocks(struct sha3 *const sha3[], u8 *const out[],
+                            size_t blocks, unsigned int n);
+
+/* widest kernel picked for this CPU, e.g. "Keccak-f[1600] x4 (AVX2)" */
+const char *sha3_mb_desc(void);
+
+#endif
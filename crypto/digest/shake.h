@@ -0,0 +1,252 @@
+#ifndef __CRYPTO_DIGEST_SHAKE_H__
+#define __CRYPTO_DIGEST_SHAKE_H__
+
+#include <hpc/compiler.h>
+#include <hpc/mem/unaligned.h>
+#include <crypto/digest.h>
+#include <stddef.h>
+
+/*
+ * SHAKE128/SHAKE256 (FIPS 202), cSHAKE and KMAC (SP 800-185) on struct sha3,
+ * permuting with the Keccak-f[1600] of whichever SHA-3 backend is built in
+ * (arch_keccakf1600). Input is XORed straight into the state and output read
+ * straight out of it, so there is no block buffer and nothing is copied per
+ * squeezed block.
+ *
+ * shake_absorb may be called any number of times, then shake_squeeze any
+ * number of times; the first squeeze pads. While absorbing, md_len holds the
+ * domain byte (0x1f SHAKE, 0x04 cSHAKE) and partial the bytes taken of the
+ * current block. Once squeezing, md_len is 0 and partial counts the bytes of
+ * the current block already handed out, rsiz meaning none are left; that is
+ * also the state shake128_mb_absorb (crypto/digest/sha3-mb.h) leaves behind.
+ */
+#define SHAKE128_RATE   168
+#define SHAKE256_RATE   136
+
+#ifdef HAVE_DIGEST_SHA3_BUILT_IN
+
+static inline void
+__shake_init(struct sha3 *x, unsigned int rate, u8 ds)
+{
+	for (unsigned int i = 0; i < 25; i++)
+		x->st[i] = 0;
+	x->md_len = ds;
+	x->rsiz = rate;
+	x->rsizw = rate / 8;
+	x->partial = 0;
+}
+
+static inline void
+shake128_init(struct sha3 *x)
+{
+	__shake_init(x, SHAKE128_RATE, 0x1f);
+}
+
+static inline void
+shake256_init(struct sha3 *x)
+{
+	__shake_init(x, SHAKE256_RATE, 0x1f);
+}
+
+/* state byte |pos| of the rate, lanes being little endian */
+#define __SHAKE_BYTE(x, pos) ((x)->st[(pos) / 8] >> (8 * ((pos) % 8)))
+#define __SHAKE_XOR(x, pos, b) \
+	((x)->st[(pos) / 8] ^= (u64)(b) << (8 * ((pos) % 8)))
+
+static inline void
+shake_absorb(struct sha3 *x, const u8 *data, size_t len)
+{
+	unsigned int pos = x->partial;
+
+	for (; len && pos; len--) {
+		__SHAKE_XOR(x, pos, *data++);
+		if (++pos == x->rsiz) {
+			arch_keccakf1600(x->st);
+			pos = 0;
+		}
+	}
+
+	for (; len >= x->rsiz; len -= x->rsiz, data += x->rsiz) {
+		for (unsigned int i = 0; i < x->rsizw; i++)
+			x->st[i] ^= get_u64_le(data + 8 * i);
+		arch_keccakf1600(x->st);
+	}
+
+	for (; len; len--, pos++)
+		__SHAKE_XOR(x, pos, *data++);
+	x->partial = pos;
+}
+
+static inline void
+shake_squeeze(struct sha3 *x, u8 *out, size_t len)
+{
+	unsigned int pos = x->partial;
+
+	if (x->md_len) {
+		__SHAKE_XOR(x, pos, x->md_len);
+		__SHAKE_XOR(x, x->rsiz - 1, 0x80);
+		x->md_len = 0;
+		pos = x->rsiz;
+	}
+
+	while (len) {
+		if (pos == x->rsiz) {
+			arch_keccakf1600(x->st);
+			pos = 0;
+		}
+		if (!pos && len >= x->rsiz) {
+			for (unsigned int i = 0; i < x->rsizw; i++)
+				put_u64_le(out + 8 * i, x->st[i]);
+			out += x->rsiz;
+			len -= x->rsiz;
+			pos = x->rsiz;
+			continue;
+		}
+		for (; len && pos < x->rsiz; len--, pos++)
+			*out++ = (u8)__SHAKE_BYTE(x, pos);
+	}
+	x->partial = pos;
+}
+
+static inline void
+shake128(u8 *out, size_t outlen, const u8 *in, size_t len)
+{
+	struct sha3 x;
+
+	shake128_init(&x);
+	shake_absorb(&x, in, len);
+	shake_squeeze(&x, out, outlen);
+}
+
+static inline void
+shake256(u8 *out, size_t outlen, const u8 *in, size_t len)
+{
+	struct sha3 x;
+
+	shake256_init(&x);
+	shake_absorb(&x, in, len);
+	shake_squeeze(&x, out, outlen);
+}
+
+/* SP 800-185 left_encode / right_encode of |v|, at most 9 bytes */
+static inline unsigned int
+__sp800_185_encode(u8 out[9], u64 v, int right)
+{
+	unsigned int n = 1;
+	u8 *p = out + !right;
+
+	while (n < 8 && v >> (8 * n))
+		n++;
+	for (unsigned int i = 0; i < n; i++)
+		p[i] = (u8)(v >> (8 * (n - 1 - i)));
+	out[right ? n : 0] = (u8)n;
+	return n + 1;
+}
+
+static inline void
+__shake_absorb_encoded(struct sha3 *x, u64 v, int right)
+{
+	u8 enc[9];
+
+	shake_absorb(x, enc, __sp800_185_encode(enc, v, right));
+}
+
+/* encode_string(s): its bit length, left encoded, then s */
+static inline void
+__shake_absorb_string(struct sha3 *x, const u8 *s, size_t len)
+{
+	__shake_absorb_encoded(x, (u64)len * 8, 0);
+	shake_absorb(x, s, len);
+}
+
+/* end of a bytepad(): the zeros up to the block boundary XOR to nothing */
+static inline void
+__shake_absorb_pad(struct sha3 *x)
+{
+	if (x->partial) {
+		arch_keccakf1600(x->st);
+		x->partial = 0;
+	}
+}
+
+/*
+ * cSHAKE with function name |n| and customization |s|; with both empty it
+ * is plain SHAKE, as the standard defines.
+ */
+static inline void
+__cshake_init(struct sha3 *x, unsigned int rate, const u8 *n, size_t nlen,
+              const u8 *s, size_t slen)
+{
+	if (!nlen && !slen) {
+		__shake_init(x, rate, 0x1f);
+		return;
+	}
+	__shake_init(x, rate, 0x04);
+	__shake_absorb_encoded(x, rate, 0);
+	__shake_absorb_string(x, n, nlen);
+	__shake_absorb_string(x, s, slen);
+	__shake_absorb_pad(x);
+}
+
+static inline void
+cshake128_init(struct sha3 *x, const u8 *n, size_t nlen,
+               const u8 *s, size_t slen)
+{
+	__cshake_init(x, SHAKE128_RATE, n, nlen, s, slen);
+}
+
+static inline void
+cshake256_init(struct sha3 *x, const u8 *n, size_t nlen,
+               const u8 *s, size_t slen)
+{
+	__cshake_init(x, SHAKE256_RATE, n, nlen, s, slen);
+}
+
+/*
+ * KMAC: init with the key and customization, the message through
+ * shake_absorb, then kmac_final for a tag of |len| bytes, or kmac_xof and
+ * shake_squeeze for KMACXOF output of any length.
+ */
+static inline void
+__kmac_init(struct sha3 *x, unsigned int rate, const u8 *key, size_t klen,
+            const u8 *s, size_t slen)
+{
+	__cshake_init(x, rate, (const u8 *)"KMAC", 4, s, slen);
+	__shake_absorb_encoded(x, rate, 0);
+	__shake_absorb_string(x, key, klen);
+	__shake_absorb_pad(x);
+}
+
+static inline void
+kmac128_init(struct sha3 *x, const u8 *key, size_t klen,
+             const u8 *s, size_t slen)
+{
+	__kmac_init(x, SHAKE128_RATE, key, klen, s, slen);
+}
+
+static inline void
+kmac256_init(struct sha3 *x, const u8 *key, size_t klen,
+             const u8 *s, size_t slen)
+{
+	__kmac_init(x, SHAKE256_RATE, key, klen, s, slen);
+}
+
+static inline void
+kmac_final(struct sha3 *x, u8 *out, size_t len)
+{
+	__shake_absorb_encoded(x, (u64)len * 8, 1);
+	shake_squeeze(x, out, len);
+}
+
+static inline void
+kmac_xof(struct sha3 *x)
+{
+	__shake_absorb_encoded(x, 0, 1);
+}
+
+#undef __SHAKE_BYTE
+#undef __SHAKE_XOR
+
+#endif /* HAVE_DIGEST_SHA3_BUILT_IN */
+
+#endif
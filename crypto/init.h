@@ -57,12 +57,94 @@ crypto_init(void)
 }
 
 #elif defined(__x86_64__) && defined(__linux__)
+#include <cpuid.h>
 
-extern unsigned int OPENSSL_ia32cap_P[4];
+/*
+ * OpenSSL / aws-lc x86_64 capability vector in the raw CPUID layout:
+ *   [0] = CPUID leaf 1,        EDX
+ *   [1] = CPUID leaf 1,        ECX
+ *   [2] = CPUID leaf 7 (ECX=0), EBX
+ *   [3] = CPUID leaf 7 (ECX=0), ECX
+ *   [5] = CPUID leaf 7 (ECX=1), EAX -- SHA512 (bit 0) only
+ * Defined (weak, hidden) by modules/cpu/x86-ossl/cap.c in the modules that
+ * read it.
+ */
+extern unsigned int __attribute__((weak)) OPENSSL_ia32cap_P[];
+
+static inline unsigned long long
+crypto_xgetbv0(void)
+{
+	unsigned int lo, hi;
+
+	__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	return ((unsigned long long)hi << 32) | lo;
+}
 
 static inline void
 crypto_init(void)
 {
+	unsigned int *ia32cap = OPENSSL_ia32cap_P;
+	unsigned int eax, ebx, ecx, edx;
+	unsigned int leaf1_ecx, leaf7_max = 0;
+	unsigned long long xcr0 = 0;
+	int ymm_enabled = 0, zmm_enabled = 0;
+
+	if (!ia32cap)
+		return;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		return;
+	leaf1_ecx = ecx;
+	OPENSSL_ia32cap_P[0] = edx;
+	OPENSSL_ia32cap_P[1] = ecx;
+
+	/*
+	 * AVX state is only usable if the OS enabled XSAVE of the YMM registers
+	 * (OSXSAVE = leaf1 ECX bit 27, and XCR0 bits 1:2 set). Mirror OpenSSL's
+	 * OPENSSL_ia32_cpuid so we never advertise AVX/AVX2 the OS hasn't turned
+	 * on — otherwise the AVX code path would fault.
+	 */
+	if ((leaf1_ecx >> 27) & 1) {
+		xcr0 = crypto_xgetbv0();
+		ymm_enabled = (xcr0 & 0x6) == 0x6;
+		/* AVX-512 also needs the opmask and both ZMM halves (bits 5:7). */
+		zmm_enabled = ymm_enabled && (xcr0 & 0xe0) == 0xe0;
+	}
+
+	if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+		OPENSSL_ia32cap_P[2] = ebx;
+		OPENSSL_ia32cap_P[3] = ecx;
+		leaf7_max = eax;
+	}
+
+	/*
+	 * Sub-leaf 1 EAX bit 0 is the SHA512 extension (vsha512rnds2 and
+	 * friends). Only that bit is kept: the rest of the word would turn on
+	 * vendor assembly paths nothing here masks against the OS state.
+	 */
+	if (leaf7_max >= 1 && __get_cpuid_count(7, 1, &eax, &ebx, &ecx, &edx))
+		OPENSSL_ia32cap_P[5] = eax & 1u;
+
+	/*
+	 * OpenSSL's assembly reads ia32cap bit 43 (word 1, bit 11) as the AMD XOP
+	 * flag, which comes from extended CPUID leaf 0x80000001 (ECX bit 11) — not
+	 * leaf-1 ECX bit 11 (SDBG). Copying the raw leaf-1 value there can falsely
+	 * advertise XOP and send the SHA-512 assembly down the XOP path (an illegal
+	 * `vprotq`) on CPUs without it, so derive the bit from the extended leaf.
+	 */
+	OPENSSL_ia32cap_P[1] &= ~(1u << 11);
+	if (__get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx) && (ecx & (1u << 11)))
+		OPENSSL_ia32cap_P[1] |= (1u << 11);
+
+	if (!ymm_enabled) {
+		OPENSSL_ia32cap_P[1] &= ~(1u << 28); /* AVX  (leaf1 ECX) */
+		OPENSSL_ia32cap_P[2] &= ~(1u << 5);  /* AVX2 (leaf7 EBX) */
+		OPENSSL_ia32cap_P[3] &= ~(3u << 9);  /* VAES, VPCLMULQDQ (leaf7 ECX) */
+		OPENSSL_ia32cap_P[5] &= ~1u;         /* SHA512, VEX.256 only */
+	}
+	if (!zmm_enabled) {
+		/* AVX512F (16), AVX512BW (30), AVX512VL (31) in leaf7 EBX. */
+		OPENSSL_ia32cap_P[2] &= ~((1u << 16) | (1u << 30) | (1u << 31));
+	}
 }
 
 #else
@@ -0,0 +1,103 @@
+/*
+ * AES-CTR glue over the aws-lc ctr32 kernel (aes_hw_ctr32_encrypt_blocks),
+ * which keeps several independent counter blocks in flight (8 on x86_64). See
+ * the contract in <crypto/cipher/aes.h>.
+ *
+ * The kernel only increments the low 32 bits of the counter block, so whole
+ * blocks are handed over in runs that end where that word wraps, and the
+ * carry into the upper 96 bits is propagated here (as aws-lc's
+ * CRYPTO_ctr128_encrypt_ctr32 does). A trailing partial block is cut from
+ * one extra keystream block whose unused bytes are kept for the next call.
+ */
+#include <string.h>
+#include <hpc/mem/unaligned.h>
+#include <crypto/cipher/aes.h>
+#include "internal.h"
+
+struct aws_aes_ctr {
+	AES_KEY ks;
+	uint8_t ctr[AES_BLOCKLEN];
+	uint8_t buf[AES_BLOCKLEN];
+	unsigned int num;	/* bytes of buf[] used, 0 when none is left */
+};
+
+_Static_assert(sizeof(struct aws_aes_ctr) <= sizeof(struct aes_ctr_ctx),
+	       "aws AES-CTR state does not fit in struct aes_ctr_ctx");
+
+/* Carry a wrapped low counter word into the upper 96 bits. */
+static inline void
+ctr96_inc(uint8_t ctr[AES_BLOCKLEN])
+{
+	unsigned int i = 12, carry = 1;
+
+	while (i--) {
+		carry += ctr[i];
+		ctr[i] = (uint8_t)carry;
+		carry >>= 8;
+	}
+}
+
+int
+aes_ctr_setkey(struct aes_ctr_ctx *ctx, const u8 *key, size_t key_len)
+{
+	struct aws_aes_ctr *c = (struct aws_aes_ctr *)ctx;
+
+	memset(c, 0, sizeof(*c));
+	if (key_len != 16 && key_len != 24 && key_len != 32)
+		return -1;
+	return aes_hw_set_encrypt_key(key, (int)key_len * 8, &c->ks);
+}
+
+void
+aes_ctr_set_iv(struct aes_ctr_ctx *ctx, const u8 iv[AES_BLOCKLEN])
+{
+	struct aws_aes_ctr *c = (struct aws_aes_ctr *)ctx;
+
+	memcpy(c->ctr, iv, AES_BLOCKLEN);
+	c->num = 0;
+}
+
+void
+aes_ctr_crypt(struct aes_ctr_ctx *ctx, const u8 *in, u8 *out, size_t len)
+{
+	struct aws_aes_ctr *c = (struct aws_aes_ctr *)ctx;
+	size_t blocks;
+	unsigned int i;
+
+	for (; len && c->num; len--) {
+		*out++ = *in++ ^ c->buf[c->num];
+		c->num = (c->num + 1) % AES_BLOCKLEN;
+	}
+
+	blocks = len / AES_BLOCKLEN;
+	while (blocks) {
+		uint32_t ctr32 = get_u32_be(c->ctr + 12);
+		size_t run = blocks;
+
+		/* Stop where the 32-bit word wraps: 2^32 - ctr32 blocks. */
+		if (ctr32 && run > (size_t)(0U - ctr32))
+			run = (size_t)(0U - ctr32);
+		else if (!ctr32 && run > UINT32_MAX)
+			run = UINT32_MAX;
+		aes_hw_ctr32_encrypt_blocks(in, out, run, &c->ks, c->ctr);
+		ctr32 += (uint32_t)run;
+		put_u32_be(c->ctr + 12, ctr32);
+		if (!ctr32)
+			ctr96_inc(c->ctr);
+		in += run * AES_BLOCKLEN;
+		out += run * AES_BLOCKLEN;
+		len -= run * AES_BLOCKLEN;
+		blocks -= run;
+	}
+
+	if (len) {
+		memset(c->buf, 0, AES_BLOCKLEN);
+		aes_hw_ctr32_encrypt_blocks(c->buf, c->buf, 1, &c->ks, c->ctr);
+		put_u32_be(c->ctr + 12, get_u32_be(c->ctr + 12) + 1);
+		if (!get_u32_be(c->ctr + 12))
+			ctr96_inc(c->ctr);
+		for (i = 0; i < len; i++)
+			out[i] = in[i] ^ c->buf[i];
+		c->num = (unsigned int)len;
+	}
+}
@@ -0,0 +1,37 @@
+/*
+ * AES-CCM (NIST SP800-38C, RFC 3610) glue over the aes_hw_* block primitive.
+ * See the contract in <crypto/cipher/aes.h>. aws-lc has no fused CCM kernel;
+ * the mode itself, which keeps the CBC-MAC and CTR chains of a record in
+ * flight together, is ../aes/ccm-mode.h, shared with the generic backend.
+ */
+#include <string.h>
+#include <hpc/mem/unaligned.h>
+#include <crypto/cipher/aes.h>
+#include "internal.h"
+
+struct aws_aes_ccm_key {
+	AES_KEY ks;
+	unsigned int tag_len;
+};
+
+_Static_assert(sizeof(struct aws_aes_ccm_key) <= sizeof(struct aes_ccm_key),
+	       "aws AES-CCM state does not fit in struct aes_ccm_key");
+
+int
+aes_ccm_setkey(struct aes_ccm_key *ccm, const u8 *key, size_t key_len,
+	       size_t tag_len)
+{
+	struct aws_aes_ccm_key *k = (struct aws_aes_ccm_key *)ccm;
+
+	memset(k, 0, sizeof(*k));
+	if (key_len != 16 && key_len != 24 && key_len != 32)
+		return -1;
+	if (tag_len < 4 || tag_len > 16 || (tag_len & 1))
+		return -1;
+	k->tag_len = (unsigned int)tag_len;
+	return aes_hw_set_encrypt_key(key, (int)key_len * 8, &k->ks);
+}
+
+#define CCM_KEY struct aws_aes_ccm_key
+#define CCM_BLOCK(k, in, out) aes_hw_encrypt(in, out, &(k)->ks)
+#include "../aes/ccm-mode.h"
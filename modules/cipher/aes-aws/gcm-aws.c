@@ -1,19 +1,29 @@
 /*
- * AES-128/256-GCM AEAD over the aws-lc AES-NI / ARMv8 assembly. One-shot,
- * 12-byte IV, no associated data, 16-byte tag. Provides the same
- * aes_gcm_encrypt/aes_gcm_decrypt free functions as the generic backend
- * (see the contract in <crypto/cipher/aes/gcm.h>): encrypt appends the tag to
- * the ciphertext, decrypt expects and verifies a trailing tag.
+ * AES-128/256-GCM AEAD over the aws-lc AES-NI / ARMv8 assembly. 12-byte IV,
+ * optional associated data, 16-byte tag. Provides the same one-shot
+ * aes_gcm_encrypt/aes_gcm_decrypt and keyed aes_gcm_setkey/seal/open free
+ * functions as the generic backend (see the contracts in
+ * <crypto/cipher/aes.h> and <crypto/cipher/aes/gcm.h>): encrypt appends the
+ * tag to the ciphertext, decrypt expects and verifies a trailing tag.
  *
  * The counter/GHASH/tag sequence mirrors aws-lc crypto/fipsmodule/modes/gcm.c
  * (CRYPTO_ghash_init / CRYPTO_gcm128_setiv / _encrypt_ctr32 / _finish) so the
  * output is byte-identical to a standard GCM implementation.
+ *
+ * With AES_AWS_GCM_STITCHED (x86_64, CONFIG_CRYPTO_CIPHER_AES_AWS_X86_64_
+ * STITCHED) the bulk of each record goes through aesni_gcm_encrypt/decrypt,
+ * which interleave the AES-CTR and GHASH instruction streams so the data is
+ * read once; only the sub-stride tail takes the separate ctr32 + GHASH path.
+ * AES_AWS_GCM_VAES (the aes-aws-x86_64-vaes module) puts the 512-bit VAES +
+ * VPCLMULQDQ kernel in front of that on CPUs with AVX-512, leaving only the
+ * final partial block to the generic tail.
  */
 #include <hpc/compiler.h>
 #include <hpc/mem/unaligned.h>
 #include <string.h>
 #include <crypto/cipher/aes.h>
 #include <crypto/cipher/aes/gcm.h>
+#include <crypto/init.h>
 #include "internal.h"
 
 #define AES_GCM_TAG_LEN 16
@@ -25,120 +35,710 @@ xor_block(u8 *dst, const u8 *a, const u8 *b)
 		dst[i] = a[i] ^ b[i];
 }
 
+/* Bulk kernel a key's GHASH table was built for (aws_aes_gcm_key.bulk). */
+enum {
+	AWS_GCM_BULK_NONE,	/* separate ctr32 + GHASH passes */
+	AWS_GCM_BULK_AESNI,	/* aesni_gcm_encrypt/decrypt, AVX + MOVBE */
+	AWS_GCM_BULK_VAES,	/* aes_gcm_*_update_vaes_avx512 */
+};
+
 /*
- * CTR-encrypt |len| bytes src->dst and GHASH the ciphertext in |ghash_ct|
- * (== dst for seal, == src for open), producing the authentication tag.
+ * Keyed state: the GHASH table of powers of H = AES_K(0^128) plus the
+ * expanded key schedule. Built once per key by aes_gcm_setkey and reused by
+ * every record; the one-shot entry points build a throwaway copy on the
+ * stack. The table layout depends on the GHASH flavour that built it, so the
+ * bulk kernel it was built for is recorded alongside and selects the matching
+ * gmult/ghash (aws-lc's GCM128_KEY stores the two pointers instead; they
+ * would push the state into a ninth cache line).
+ *
+ * The table leads so it fills cache lines 0-3 exactly and the schedule,
+ * rounds and bulk share lines 4-7: eight lines in all, which is what
+ * aes_gcm_key_size reports and what a compact per-flow context allocates.
  */
-static void
-aes_gcm_core(const u8 *key, int key_bits, const u8 *iv,
-	     const u8 *src, u8 *dst, size_t len,
-	     const u8 *ghash_ct, u8 tag[AES_GCM_TAG_LEN])
-{
-	AES_KEY ks;
+struct aws_aes_gcm_key {
 	u128 Htable[16];
-	u8 H[AES_BLOCKLEN];
-	u8 Yi[AES_BLOCKLEN];
-	u8 EK0[AES_BLOCKLEN];
-	u8 Xi[AES_BLOCKLEN];
-	uint64_t H64[2];
-	uint32_t ctr;
-	size_t full, rem, i;
+	AES_KEY ks;
+	int bulk;
+};
 
-	aes_hw_set_encrypt_key(key, key_bits, &ks);
+_Static_assert(sizeof(struct aws_aes_gcm_key) <= sizeof(struct aes_gcm_key),
+	       "aws AES-GCM keyed state does not fit in struct aes_gcm_key");
+_Static_assert(__builtin_offsetof(struct aws_aes_gcm_key, ks) == 4 * 64,
+	       "aws AES-GCM Htable does not end on a cache line");
+_Static_assert(sizeof(struct aws_aes_gcm_key) <= 8 * 64,
+	       "aws AES-GCM keyed state spills past eight cache lines");
 
-	/* Hash subkey H = AES_K(0^128); passed to gcm_init as two BE words. */
-	memset(H, 0, sizeof(H));
-	aes_hw_encrypt(H, H, &ks);
+size_t
+aes_gcm_key_size(void)
+{
+	return sizeof(struct aws_aes_gcm_key);
+}
+
+static inline void
+gcm_gmult(const struct aws_aes_gcm_key *k, u8 Xi[AES_BLOCKLEN])
+{
+#ifdef AES_AWS_GCM_VAES
+	if (k->bulk == AWS_GCM_BULK_VAES) {
+		gcm_gmult_vpclmulqdq_avx512(Xi, k->Htable);
+		return;
+	}
+#endif
+#ifdef AES_AWS_GCM_STITCHED
+	if (k->bulk == AWS_GCM_BULK_AESNI) {
+		gcm_gmult_avx(Xi, k->Htable);
+		return;
+	}
+#endif
+	AES_AWS_GHASH_GMULT(Xi, k->Htable);
+}
+
+static inline void
+gcm_ghash(const struct aws_aes_gcm_key *k, u8 Xi[AES_BLOCKLEN],
+	  const u8 *in, size_t len)
+{
+#ifdef AES_AWS_GCM_VAES
+	if (k->bulk == AWS_GCM_BULK_VAES) {
+		gcm_ghash_vpclmulqdq_avx512(Xi, k->Htable, in, len);
+		return;
+	}
+#endif
+#ifdef AES_AWS_GCM_STITCHED
+	if (k->bulk == AWS_GCM_BULK_AESNI) {
+		gcm_ghash_avx(Xi, k->Htable, in, len);
+		return;
+	}
+#endif
+	AES_AWS_GHASH_GHASH(Xi, k->Htable, in, len);
+}
+
+#ifdef AES_AWS_GCM_STITCHED
+static int have_avx_movbe(void)
+{
+#if defined(CONFIG_X86_HAS_AVX2)
+	return 1;	/* every AVX2 part also provides MOVBE */
+#else
+	/* leaf1 ECX bit 28 (AVX/OS-enabled YMM) and bit 22 (MOVBE). */
+	return (OPENSSL_ia32cap_P[1] & (1u << 28)) &&
+	       (OPENSSL_ia32cap_P[1] & (1u << 22));
+#endif
+}
+#endif
+
+#ifdef AES_AWS_GCM_VAES
+/*
+ * Checked even in buildtime configs: nothing ties this backend to an
+ * AVX-512 target, so the cap vector is filled here when no runtime cap
+ * constructor has done it.
+ */
+static int have_vaes_avx512(void)
+{
+	/* leaf7 EBX AVX512F (16), AVX512BW (30), AVX512VL (31); leaf7 ECX
+	 * VAES (9), VPCLMULQDQ (10). crypto_init() clears them without OS
+	 * ZMM state. */
+	const unsigned int ebx = (1u << 16) | (1u << 30) | (1u << 31);
+	const unsigned int ecx = (1u << 9) | (1u << 10);
+
+	if (!OPENSSL_ia32cap_P[0] && !OPENSSL_ia32cap_P[1])
+		crypto_init();
+	return (OPENSSL_ia32cap_P[2] & ebx) == ebx &&
+	       (OPENSSL_ia32cap_P[3] & ecx) == ecx;
+}
+#endif
+
+/*
+ * GHASH table from the hash subkey H = AES_K(0^128), for the best kernel or
+ * the one |want| pins; -1 when that one is not built in or not runnable.
+ */
+static int
+aes_gcm_key_hash(struct aws_aes_gcm_key *k, const u8 H[AES_BLOCKLEN],
+		 enum aes_gcm_bulk want)
+{
+	uint64_t H64[2];
+
+	/* passed to gcm_init as two BE words */
 	H64[0] = get_u64_be(H);
 	H64[1] = get_u64_be(H + 8);
-	AES_AWS_GHASH_INIT(Htable, H64);
 
+#ifdef AES_AWS_GCM_VAES
+	if ((want == AES_GCM_BULK_BEST || want == AES_GCM_BULK_VAES) &&
+	    have_vaes_avx512()) {
+		gcm_init_vpclmulqdq_avx512(k->Htable, H64);
+		k->bulk = AWS_GCM_BULK_VAES;
+		return 0;
+	}
+#endif
+#ifdef AES_AWS_GCM_STITCHED
+	if ((want == AES_GCM_BULK_BEST || want == AES_GCM_BULK_AESNI) &&
+	    have_avx_movbe()) {
+		gcm_init_avx(k->Htable, H64);
+		k->bulk = AWS_GCM_BULK_AESNI;
+		return 0;
+	}
+#endif
+	if (want != AES_GCM_BULK_BEST && want != AES_GCM_BULK_GHASH)
+		return -1;
+	AES_AWS_GHASH_INIT(k->Htable, H64);
+	k->bulk = AWS_GCM_BULK_NONE;
+	return 0;
+}
+
+static int
+aes_gcm_key_setup(struct aws_aes_gcm_key *k, const u8 *key, size_t key_len,
+		  enum aes_gcm_bulk want)
+{
+	u8 H[AES_BLOCKLEN];
+
+	if (key_len != 16 && key_len != 24 && key_len != 32)
+		return -1;
+	aes_hw_set_encrypt_key(key, (int)(key_len * 8), &k->ks);
+
+	memset(H, 0, sizeof(H));
+	aes_hw_encrypt(H, H, &k->ks);
+	return aes_gcm_key_hash(k, H, want);
+}
+
+/* GHASH |len| bytes into Xi, zero-padding a trailing partial block. */
+static void
+ghash_padded(const struct aws_aes_gcm_key *k, u8 Xi[AES_BLOCKLEN],
+	     const u8 *in, size_t len)
+{
+	size_t full = len & ~(size_t)(AES_BLOCKLEN - 1);
+	size_t i;
+
+	if (full)
+		gcm_ghash(k, Xi, in, full);
+	if (len - full) {
+		for (i = 0; i < len - full; i++)
+			Xi[i] ^= in[full + i];
+		gcm_gmult(k, Xi);
+	}
+}
+
+/*
+ * A record is split into three steps so the streaming record can feed the
+ * middle one piecewise: aws_gcm_start derives J0/EK0 and absorbs the
+ * associated data, aws_gcm_blocks CTR-encrypts and GHASHes whole blocks (the
+ * ciphertext is dst when |enc|, src otherwise; open hashes its input before
+ * overwriting it, so dst may equal src), and aws_gcm_finish handles the
+ * trailing partial block, the length block and the tag. |Yi|
+ * carries the next counter block between the steps; aws_gcm_start_j0 is the
+ * first step for a caller that has already put the 12-byte nonce there.
+ */
+static void
+aws_gcm_start_j0(const struct aws_aes_gcm_key *k,
+		 const u8 *aad, size_t aad_len,
+		 u8 Yi[AES_BLOCKLEN], u8 EK0[AES_BLOCKLEN], u8 Xi[AES_BLOCKLEN])
+{
 	/* J0 = IV || 0^31 || 1; EK0 = AES_K(J0) is the tag mask. */
-	memcpy(Yi, iv, 12);
 	put_u32_be(Yi + 12, 1);
-	aes_hw_encrypt(Yi, EK0, &ks);
+	aes_hw_encrypt(Yi, EK0, &k->ks);
 
 	/* Data starts at counter 2. */
-	ctr = 2;
-	put_u32_be(Yi + 12, ctr);
+	put_u32_be(Yi + 12, 2);
 
-	full = len & ~(size_t)(AES_BLOCKLEN - 1);
-	rem = len - full;
+	/* GHASH(aad) first: the bulk kernels fold the ciphertext into the
+	 * running Xi as they go. */
+	memset(Xi, 0, AES_BLOCKLEN);
+	if (aad_len)
+		ghash_padded(k, Xi, aad, aad_len);
+}
 
-	if (full) {
-		aes_hw_ctr32_encrypt_blocks(src, dst, full / AES_BLOCKLEN, &ks,
-					    Yi);
-		ctr += (uint32_t)(full / AES_BLOCKLEN);
-		put_u32_be(Yi + 12, ctr);
+static void
+aws_gcm_start(const struct aws_aes_gcm_key *k, const u8 *iv,
+	      const u8 *aad, size_t aad_len,
+	      u8 Yi[AES_BLOCKLEN], u8 EK0[AES_BLOCKLEN], u8 Xi[AES_BLOCKLEN])
+{
+	memcpy(Yi, iv, 12);
+	aws_gcm_start_j0(k, aad, aad_len, Yi, EK0, Xi);
+}
+
+/* Process the whole blocks of |len|; returns the bytes consumed. */
+static size_t
+aws_gcm_blocks(const struct aws_aes_gcm_key *k, int enc,
+	       const u8 *src, u8 *dst, size_t len,
+	       u8 Yi[AES_BLOCKLEN], u8 Xi[AES_BLOCKLEN])
+{
+	size_t done = 0, full;
+
+#ifdef AES_AWS_GCM_VAES
+	if (k->bulk == AWS_GCM_BULK_VAES) {
+		done = len & ~(size_t)(AES_BLOCKLEN - 1);
+		if (!done)
+			return 0;
+		if (enc)
+			aes_gcm_enc_update_vaes_avx512(src, dst, done, &k->ks,
+						       Yi, k->Htable, Xi);
+		else
+			aes_gcm_dec_update_vaes_avx512(src, dst, done, &k->ks,
+						       Yi, k->Htable, Xi);
+		put_u32_be(Yi + 12, get_u32_be(Yi + 12) +
+			   (uint32_t)(done / AES_BLOCKLEN));
+		return done;
 	}
+#endif
+#ifdef AES_AWS_GCM_STITCHED
+	if (k->bulk == AWS_GCM_BULK_AESNI)
+		done = enc ?
+			aesni_gcm_encrypt(src, dst, len, &k->ks, Yi,
+					  k->Htable, Xi) :
+			aesni_gcm_decrypt(src, dst, len, &k->ks, Yi,
+					  k->Htable, Xi);
+#endif
+	full = (len - done) & ~(size_t)(AES_BLOCKLEN - 1);
+	if (!full)
+		return done;
+	src += done;
+	dst += done;
+
+	if (!enc)
+		gcm_ghash(k, Xi, src, full);
+	aes_hw_ctr32_encrypt_blocks(src, dst, full / AES_BLOCKLEN, &k->ks, Yi);
+	if (enc)
+		gcm_ghash(k, Xi, dst, full);
+	put_u32_be(Yi + 12, get_u32_be(Yi + 12) +
+		   (uint32_t)(full / AES_BLOCKLEN));
+	return done + full;
+}
+
+/* Fold in the length block (aad_bits || msg_bits) and mask with EK0. */
+static void
+aws_gcm_tag(const struct aws_aes_gcm_key *k, uint64_t aad_len, uint64_t len,
+	    const u8 EK0[AES_BLOCKLEN], u8 Xi[AES_BLOCKLEN],
+	    u8 tag[AES_GCM_TAG_LEN])
+{
+	u8 lb[AES_BLOCKLEN];
+
+	put_u64_be(lb, aad_len << 3);
+	put_u64_be(lb + 8, len << 3);
+	for (unsigned int i = 0; i < AES_BLOCKLEN; i++)
+		Xi[i] ^= lb[i];
+	gcm_gmult(k, Xi);
+
+	xor_block(tag, Xi, EK0);
+}
+
+/* |rem| < 16 trailing bytes, then the tag. */
+static void
+aws_gcm_finish(const struct aws_aes_gcm_key *k, int enc,
+	       const u8 *src, u8 *dst, size_t rem,
+	       size_t aad_len, size_t len,
+	       const u8 Yi[AES_BLOCKLEN], const u8 EK0[AES_BLOCKLEN],
+	       u8 Xi[AES_BLOCKLEN], u8 tag[AES_GCM_TAG_LEN])
+{
+	size_t i;
+
 	if (rem) {
 		u8 EKi[AES_BLOCKLEN];
 
-		aes_hw_encrypt(Yi, EKi, &ks);
+		if (!enc)
+			ghash_padded(k, Xi, src, rem);
+		aes_hw_encrypt(Yi, EKi, &k->ks);
 		for (i = 0; i < rem; i++)
-			dst[full + i] = src[full + i] ^ EKi[i];
+			dst[i] = src[i] ^ EKi[i];
+		if (enc)
+			ghash_padded(k, Xi, dst, rem);
 	}
 
-	/* GHASH(ciphertext) then the length block (aad_bits=0 || msg_bits). */
-	memset(Xi, 0, sizeof(Xi));
-	if (full)
-		AES_AWS_GHASH_GHASH(Xi, Htable, ghash_ct, full);
-	if (rem) {
-		for (i = 0; i < rem; i++)
-			Xi[i] ^= ghash_ct[full + i];
-		AES_AWS_GHASH_GMULT(Xi, Htable);
-	}
-	{
-		u8 lb[AES_BLOCKLEN];
+	aws_gcm_tag(k, aad_len, len, EK0, Xi, tag);
+}
 
-		put_u64_be(lb, 0);
-		put_u64_be(lb + 8, (uint64_t)len << 3);
-		for (i = 0; i < AES_BLOCKLEN; i++)
-			Xi[i] ^= lb[i];
-		AES_AWS_GHASH_GMULT(Xi, Htable);
-	}
+/*
+ * CTR-encrypt |len| bytes src->dst and GHASH the associated data followed by
+ * the ciphertext, producing the authentication tag.
+ */
+static void
+aes_gcm_core_j0(const struct aws_aes_gcm_key *k, int enc,
+		u8 Yi[AES_BLOCKLEN], const u8 *aad, size_t aad_len,
+		const u8 *src, u8 *dst, size_t len, u8 tag[AES_GCM_TAG_LEN])
+{
+	u8 EK0[AES_BLOCKLEN];
+	u8 Xi[AES_BLOCKLEN];
+	size_t done;
 
-	xor_block(tag, Xi, EK0);
+	aws_gcm_start_j0(k, aad, aad_len, Yi, EK0, Xi);
+	done = aws_gcm_blocks(k, enc, src, dst, len, Yi, Xi);
+	aws_gcm_finish(k, enc, src + done, dst + done, len - done,
+		       aad_len, len, Yi, EK0, Xi, tag);
+}
+
+static void
+aes_gcm_core(const struct aws_aes_gcm_key *k, int enc, const u8 *iv,
+	     const u8 *aad, size_t aad_len,
+	     const u8 *src, u8 *dst, size_t len, u8 tag[AES_GCM_TAG_LEN])
+{
+	u8 Yi[AES_BLOCKLEN];
+
+	memcpy(Yi, iv, 12);
+	aes_gcm_core_j0(k, enc, Yi, aad, aad_len, src, dst, len, tag);
+}
+
+/* Constant-time compare of two tags; returns 0 when they match. */
+static unsigned int
+tag_diff(const u8 *a, const u8 *b)
+{
+	unsigned int diff = 0;
+
+	for (unsigned int i = 0; i < AES_GCM_TAG_LEN; i++)
+		diff |= (unsigned int)(a[i] ^ b[i]);
+	return diff;
 }
 
 int
-aes_gcm_encrypt(u8 *output, const u8 *input, int input_length,
-		const u8 *key, const size_t key_len, const u8 *iv,
-		const size_t iv_len)
+aes_gcm_setkey(struct aes_gcm_key *gcm, const u8 *key, size_t key_len)
 {
-	u8 tag[AES_GCM_TAG_LEN];
+	return aes_gcm_key_setup((struct aws_aes_gcm_key *)gcm, key, key_len,
+				 AES_GCM_BULK_BEST);
+}
+
+int
+aes_gcm_setkey_bulk(struct aes_gcm_key *gcm, const u8 *key, size_t key_len,
+		    enum aes_gcm_bulk bulk)
+{
+	return aes_gcm_key_setup((struct aws_aes_gcm_key *)gcm, key, key_len,
+				 bulk);
+}
+
+/*
+ * With AES_AWS_KEYEXP_BATCH (the x86_64 backends) keys go through the AES-NI
+ * schedule AES_HW_KEY_LANES at a time, H included; the GHASH tables are
+ * built per key after each group. AES-192 and the other backends take one
+ * key at a time.
+ */
+int
+aes_gcm_setkey_batch(struct aes_gcm_key *const *gcm, const u8 *const *key,
+		     size_t key_len, unsigned int n)
+{
+	unsigned int i = 0;
+
+	if (key_len != 16 && key_len != 24 && key_len != 32)
+		return -1;
+#ifdef AES_AWS_KEYEXP_BATCH
+	if (key_len != 24) {
+		AES_KEY *ks[AES_HW_KEY_LANES];
+		u8 H[AES_HW_KEY_LANES][AES_BLOCKLEN];
+		unsigned int j, m;
 
+		for (; i < n; i += m) {
+			m = n - i < AES_HW_KEY_LANES ? n - i : AES_HW_KEY_LANES;
+			for (j = 0; j < m; j++)
+				ks[j] = &((struct aws_aes_gcm_key *)gcm[i + j])->ks;
+			aes_hw_set_encrypt_key_hash_xN(key + i, (int)key_len * 8,
+						       ks, H, m);
+			for (j = 0; j < m; j++)
+				aes_gcm_key_hash((struct aws_aes_gcm_key *)gcm[i + j],
+						 H[j], AES_GCM_BULK_BEST);
+		}
+	}
+#endif
+	for (; i < n; i++)
+		aes_gcm_key_setup((struct aws_aes_gcm_key *)gcm[i], key[i],
+				  key_len, AES_GCM_BULK_BEST);
+	return 0;
+}
+
+int
+aes_gcm_seal(struct aes_gcm_key *gcm, u8 *output, const u8 *input,
+	     int input_length, const u8 *iv, size_t iv_len,
+	     const u8 *aad, size_t aad_len)
+{
 	(void)iv_len;
-	aes_gcm_core(key, (int)(key_len * 8), iv, input, output,
-		     (size_t)input_length, output, tag);
-	memcpy(output + input_length, tag, AES_GCM_TAG_LEN);
+	if (input_length < 0)
+		return -1;
+	aes_gcm_core((const struct aws_aes_gcm_key *)gcm, 1, iv, aad, aad_len,
+		     input, output, (size_t)input_length,
+		     output + input_length);
 	return 0;
 }
 
 int
-aes_gcm_decrypt(u8 *output, const u8 *input, int input_length,
-		const u8 *key, const size_t key_len, const u8 *iv,
-		const size_t iv_len)
+aes_gcm_open(struct aes_gcm_key *gcm, u8 *output, const u8 *input,
+	     int input_length, const u8 *iv, size_t iv_len,
+	     const u8 *aad, size_t aad_len)
 {
 	u8 tag[AES_GCM_TAG_LEN];
 	int ct_len = input_length - AES_GCM_TAG_LEN;
-	unsigned int diff = 0;
-	int i;
 
 	(void)iv_len;
 	if (ct_len < 0)
 		return GCM_AUTH_FAILURE;
 
-	aes_gcm_core(key, (int)(key_len * 8), iv, input, output,
-		     (size_t)ct_len, input, tag);
+	aes_gcm_core((const struct aws_aes_gcm_key *)gcm, 0, iv, aad, aad_len,
+		     input, output, (size_t)ct_len, tag);
 
-	/* Constant-time compare against the trailing tag. */
-	for (i = 0; i < AES_GCM_TAG_LEN; i++)
-		diff |= (unsigned int)(tag[i] ^ input[ct_len + i]);
+	if (tag_diff(tag, input + ct_len) != 0) {
+		memset(output, 0, (size_t)ct_len);
+		return GCM_AUTH_FAILURE;
+	}
+	return 0;
+}
 
-	if (diff != 0) {
+/* TLS 1.2: the salt and the explicit nonce go straight into the counter. */
+int
+aes_gcm_seal_explicit(struct aes_gcm_key *gcm, u8 *output, const u8 *input,
+		      int input_length, u32 salt, u64 explicit_nonce,
+		      const u8 *aad, size_t aad_len)
+{
+	u8 Yi[AES_BLOCKLEN];
+
+	if (input_length < 0)
+		return -1;
+
+	put_u32_be(Yi, salt);
+	put_u64_be(Yi + 4, explicit_nonce);
+	aes_gcm_core_j0((const struct aws_aes_gcm_key *)gcm, 1, Yi, aad,
+			aad_len, input, output, (size_t)input_length,
+			output + input_length);
+	return 0;
+}
+
+int
+aes_gcm_open_explicit(struct aes_gcm_key *gcm, u8 *output, const u8 *input,
+		      int input_length, u32 salt, u64 explicit_nonce,
+		      const u8 *aad, size_t aad_len)
+{
+	u8 Yi[AES_BLOCKLEN];
+	u8 tag[AES_GCM_TAG_LEN];
+	int ct_len = input_length - AES_GCM_TAG_LEN;
+
+	if (ct_len < 0)
+		return GCM_AUTH_FAILURE;
+
+	put_u32_be(Yi, salt);
+	put_u64_be(Yi + 4, explicit_nonce);
+	aes_gcm_core_j0((const struct aws_aes_gcm_key *)gcm, 0, Yi, aad,
+			aad_len, input, output, (size_t)ct_len, tag);
+
+	if (tag_diff(tag, input + ct_len) != 0) {
 		memset(output, 0, (size_t)ct_len);
 		return GCM_AUTH_FAILURE;
 	}
 	return 0;
 }
+
+/*
+ * Streaming record: the same start/blocks/tag steps, fed piecewise. Whole
+ * blocks of a piece go straight through the bulk kernel in place; a piece
+ * that ends mid-block leaves the rest of that counter block's keystream in
+ * EKi, and the bytes already crossed are folded into Xi as they go, so the
+ * next piece finishes the block without the data being copied anywhere.
+ * Xi only gets its multiply once the block is complete (or at final).
+ */
+struct aws_aes_gcm_stream {
+	const struct aws_aes_gcm_key *k;
+	u8 Yi[AES_BLOCKLEN];
+	u8 EK0[AES_BLOCKLEN];
+	u8 Xi[AES_BLOCKLEN];
+	u8 EKi[AES_BLOCKLEN];
+	uint64_t aad_len;
+	uint64_t len;
+	unsigned int num;	/* bytes of EKi used, 0 when block-aligned */
+	int enc;
+};
+
+_Static_assert(sizeof(struct aws_aes_gcm_stream) <=
+	       sizeof(struct aes_gcm_stream),
+	       "aws AES-GCM stream state does not fit in struct aes_gcm_stream");
+
+int
+aes_gcm_stream_init(struct aes_gcm_stream *stream, struct aes_gcm_key *gcm,
+		    int enc, const u8 *iv, size_t iv_len,
+		    const u8 *aad, size_t aad_len)
+{
+	struct aws_aes_gcm_stream *st = (struct aws_aes_gcm_stream *)stream;
+
+	if (iv_len != 12)
+		return -1;
+	st->k = (const struct aws_aes_gcm_key *)gcm;
+	st->aad_len = aad_len;
+	st->len = 0;
+	st->num = 0;
+	st->enc = enc;
+	aws_gcm_start(st->k, iv, aad, aad_len, st->Yi, st->EK0, st->Xi);
+	return 0;
+}
+
+/* XOR |n| bytes against EKi from st->num on, hashing the ciphertext. */
+static void
+stream_partial(struct aws_aes_gcm_stream *st, const u8 *in, u8 *out,
+	       size_t n)
+{
+	for (size_t i = 0; i < n; i++) {
+		u8 c = st->enc ? in[i] ^ st->EKi[st->num] : in[i];
+
+		out[i] = in[i] ^ st->EKi[st->num];
+		st->Xi[st->num++] ^= c;
+	}
+}
+
+void
+aes_gcm_stream_update(struct aes_gcm_stream *stream, const u8 *in, u8 *out,
+		      size_t len)
+{
+	struct aws_aes_gcm_stream *st = (struct aws_aes_gcm_stream *)stream;
+	const struct aws_aes_gcm_key *k = st->k;
+	size_t n;
+
+	st->len += len;
+
+	/* Finish the block the previous piece stopped in. */
+	if (st->num) {
+		n = AES_BLOCKLEN - st->num;
+		if (n > len)
+			n = len;
+		stream_partial(st, in, out, n);
+		in += n;
+		out += n;
+		len -= n;
+		if (st->num < AES_BLOCKLEN)
+			return;
+		gcm_gmult(k, st->Xi);
+		st->num = 0;
+	}
+
+	n = aws_gcm_blocks(k, st->enc, in, out, len, st->Yi, st->Xi);
+	in += n;
+	out += n;
+	len -= n;
+
+	/* Start the next block; the piece ends inside it. */
+	if (len) {
+		aes_hw_encrypt(st->Yi, st->EKi, &k->ks);
+		put_u32_be(st->Yi + 12, get_u32_be(st->Yi + 12) + 1);
+		stream_partial(st, in, out, len);
+	}
+}
+
+int
+aes_gcm_stream_final(struct aes_gcm_stream *stream, u8 tag[AES_GCM_TAG_LEN])
+{
+	struct aws_aes_gcm_stream *st = (struct aws_aes_gcm_stream *)stream;
+	const struct aws_aes_gcm_key *k = st->k;
+	u8 calc[AES_GCM_TAG_LEN];
+	unsigned int diff;
+
+	if (st->num)
+		gcm_gmult(k, st->Xi);
+	aws_gcm_tag(k, st->aad_len, st->len, st->EK0, st->Xi, calc);
+	if (st->enc) {
+		memcpy(tag, calc, AES_GCM_TAG_LEN);
+		diff = 0;
+	} else {
+		diff = tag_diff(calc, tag);
+	}
+	memset(st, 0, sizeof(*st));
+	return diff ? GCM_AUTH_FAILURE : 0;
+}
+
+/* One record of a multi-buffer open: decrypt, then check its tag. */
+static unsigned int
+gcm_open_check(struct aes_gcm_mb *rec, const u8 tag[AES_GCM_TAG_LEN])
+{
+	rec->status = 0;
+	if (tag_diff(tag, rec->tag) != 0) {
+		memset(rec->out, 0, rec->len);
+		rec->status = GCM_AUTH_FAILURE;
+		return 1;
+	}
+	return 0;
+}
+
+static unsigned int
+gcm_open_one(struct aes_gcm_mb *rec)
+{
+	u8 tag[AES_GCM_TAG_LEN];
+
+	aes_gcm_core((const struct aws_aes_gcm_key *)rec->key, 0, rec->iv,
+		     rec->aad, rec->aad_len, rec->in, rec->out, rec->len, tag);
+	return gcm_open_check(rec, tag);
+}
+
+#ifdef AES_AWS_GCM_MB
+/*
+ * Multi-buffer open (AES_AWS_GCM_MB, the x86_64 backends). Records up to
+ * AES_GCM_MB_MAX_LEN bytes are gathered AES_GCM_MB_LANES at a time and
+ * decrypted side by side by aes_hw_gcm_open_xN; longer ones, and a group of
+ * one, are left to the per-record path. Against the stitched AES-NI kernel
+ * the batch wins 1.3-1.7x at 32-64 bytes, breaks even around 128 and loses
+ * beyond, where a record fills the bulk kernel's stride by itself
+ * (tools/testing/perf/cipher.c, "AES-128-GCM open batch").
+ */
+#define AES_GCM_MB_MAX_LEN 128
+
+static unsigned int
+gcm_open_lanes(struct aes_gcm_mb *const *rec, unsigned int n)
+{
+	const AES_KEY *ks[AES_GCM_MB_LANES];
+	u8 tag[AES_GCM_MB_LANES][AES_GCM_TAG_LEN];
+	unsigned int i, failed = 0;
+
+	if (n == 1)
+		return gcm_open_one(rec[0]);
+	for (i = 0; i < n; i++)
+		ks[i] = &((const struct aws_aes_gcm_key *)rec[i]->key)->ks;
+	aes_hw_gcm_open_xN(ks, rec, tag, n);
+	for (i = 0; i < n; i++)
+		failed += gcm_open_check(rec[i], tag[i]);
+	return failed;
+}
+
+unsigned int
+aes_gcm_open_mb(struct aes_gcm_mb *rec, unsigned int n)
+{
+	struct aes_gcm_mb *lane[AES_GCM_MB_LANES];
+	unsigned int i, m = 0, failed = 0;
+
+	for (i = 0; i < n; i++) {
+		if (rec[i].len > AES_GCM_MB_MAX_LEN) {
+			failed += gcm_open_one(&rec[i]);
+			continue;
+		}
+		lane[m++] = &rec[i];
+		if (m == AES_GCM_MB_LANES) {
+			failed += gcm_open_lanes(lane, m);
+			m = 0;
+		}
+	}
+	if (m)
+		failed += gcm_open_lanes(lane, m);
+	return failed;
+}
+#else
+/* ARMv8 and the constant-time backend have no multi-record kernel. */
+unsigned int
+aes_gcm_open_mb(struct aes_gcm_mb *rec, unsigned int n)
+{
+	unsigned int i, failed = 0;
+
+	for (i = 0; i < n; i++)
+		failed += gcm_open_one(&rec[i]);
+	return failed;
+}
+#endif
+
+int
+aes_gcm_encrypt(u8 *output, const u8 *input, int input_length,
+		const u8 *key, const size_t key_len, const u8 *iv,
+		const size_t iv_len)
+{
+	struct aes_gcm_key gcm;
+
+	if (aes_gcm_setkey(&gcm, key, key_len))
+		return -1;
+	return aes_gcm_seal(&gcm, output, input, input_length, iv, iv_len,
+			    NULL, 0);
+}
+
+int
+aes_gcm_decrypt(u8 *output, const u8 *input, int input_length,
+		const u8 *key, const size_t key_len, const u8 *iv,
+		const size_t iv_len)
+{
+	struct aes_gcm_key gcm;
+
+	if (input_length < AES_GCM_TAG_LEN)
+		return GCM_AUTH_FAILURE;
+	if (aes_gcm_setkey(&gcm, key, key_len))
+		return GCM_AUTH_FAILURE;
+	return aes_gcm_open(&gcm, output, input, input_length, iv, iv_len,
+			    NULL, 0);
+}
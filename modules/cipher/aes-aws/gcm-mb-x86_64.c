@@ -0,0 +1,256 @@
+/*
+ * Multi-buffer AES-GCM open for aes_gcm_open_mb on the x86_64 aws-lc
+ * backends. A short record on its own is mostly latency: EK0, the partial
+ * block and each GHASH multiply are single dependent chains, and the bulk
+ * kernels never reach their wide strides. Here up to four records, each
+ * under its own key, go through one loop: every step runs the
+ * next counter block of every record round by round, so the aesenc chains
+ * of different records issue back to back, then folds each record's
+ * ciphertext block into its own GHASH accumulator, again one independent
+ * PCLMULQDQ chain per record.
+ *
+ * GHASH works on byte-reflected blocks with the shift-and-reduce multiply of
+ * Intel's carry-less multiplication paper (Gueron and Kounavis), which only
+ * needs H = AES_K(0^128); it is encrypted together with J0 here instead of
+ * being read back out of the backend's table, whose layout depends on the
+ * GHASH flavour. Open hashes each ciphertext block before writing its
+ * plaintext, so |out| may equal |in|.
+ */
+#include <string.h>
+#include <wmmintrin.h>
+#include <tmmintrin.h>
+#include <crypto/cipher/aes.h>
+#include "internal.h"
+
+static inline __m128i
+bswap128(__m128i x)
+{
+	return _mm_shuffle_epi8(x, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7,
+						8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+/* a * b in GF(2^128), both byte-reflected */
+static inline __m128i
+gfmul(__m128i a, __m128i b)
+{
+	__m128i lo, mid, hi, t, u, v;
+
+	lo = _mm_clmulepi64_si128(a, b, 0x00);
+	hi = _mm_clmulepi64_si128(a, b, 0x11);
+	mid = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10),
+			    _mm_clmulepi64_si128(a, b, 0x01));
+	lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+	hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+
+	/* shifted left by one, for the reflected bits */
+	t = _mm_srli_epi32(lo, 31);
+	u = _mm_srli_epi32(hi, 31);
+	lo = _mm_slli_epi32(lo, 1);
+	hi = _mm_slli_epi32(hi, 1);
+	v = _mm_srli_si128(t, 12);
+	u = _mm_slli_si128(u, 4);
+	t = _mm_slli_si128(t, 4);
+	lo = _mm_or_si128(lo, t);
+	hi = _mm_or_si128(_mm_or_si128(hi, u), v);
+
+	/* modulo x^128 + x^7 + x^2 + x + 1 */
+	t = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo, 31),
+					_mm_slli_epi32(lo, 30)),
+			  _mm_slli_epi32(lo, 25));
+	u = _mm_srli_si128(t, 4);
+	lo = _mm_xor_si128(lo, _mm_slli_si128(t, 12));
+	v = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo, 1),
+					_mm_srli_epi32(lo, 2)),
+			  _mm_xor_si128(_mm_srli_epi32(lo, 7), u));
+	return _mm_xor_si128(hi, _mm_xor_si128(lo, v));
+}
+
+static inline __m128i
+round_key(const AES_KEY *key, unsigned int r)
+{
+	return _mm_loadu_si128((const __m128i *)&key->rd_key[4 * r]);
+}
+
+/*
+ * Encrypt x[l] under key[l] for l < N. The rounds every key has run across
+ * the lanes; an AES-256 key in a batch with AES-128 ones finishes alone.
+ * |rounds| is stored one short, as aes_hw_set_encrypt_key leaves it.
+ */
+static inline __attribute__((always_inline)) void
+aes_encrypt_xN(__m128i *x, const AES_KEY *const *key, unsigned int nr,
+	       const unsigned int N)
+{
+	unsigned int l, r;
+
+#pragma GCC unroll 8
+	for (l = 0; l < N; l++)
+		x[l] = _mm_xor_si128(x[l], round_key(key[l], 0));
+	for (r = 1; r <= nr; r++)
+#pragma GCC unroll 8
+		for (l = 0; l < N; l++)
+			x[l] = _mm_aesenc_si128(x[l], round_key(key[l], r));
+#pragma GCC unroll 8
+	for (l = 0; l < N; l++) {
+		for (r = nr + 1; r <= key[l]->rounds; r++)
+			x[l] = _mm_aesenc_si128(x[l], round_key(key[l], r));
+		x[l] = _mm_aesenclast_si128(x[l],
+					    round_key(key[l], key[l]->rounds + 1));
+	}
+}
+
+/* |left| bytes of |p| zero padded; nothing at all once the record is done */
+static inline __m128i
+load_block(const uint8_t *p, size_t left)
+{
+	uint8_t buf[16] = { 0 };
+
+	if (left >= 16)
+		return _mm_loadu_si128((const __m128i *)p);
+	if (left)
+		memcpy(buf, p, left);
+	return _mm_loadu_si128((const __m128i *)buf);
+}
+
+static inline void
+store_block(uint8_t *p, __m128i x, size_t left)
+{
+	uint8_t buf[16];
+
+	if (left >= 16) {
+		_mm_storeu_si128((__m128i *)p, x);
+	} else if (left) {
+		_mm_storeu_si128((__m128i *)buf, x);
+		memcpy(p, buf, left);
+	}
+}
+
+static inline size_t
+left_of(size_t len, size_t off)
+{
+	return off < len ? len - off : 0;
+}
+
+/*
+ * Fold |b| into Xi, keeping the old Xi in a lane whose data has run out
+ * (|left| zero), so records of different lengths share the steps.
+ */
+static inline __m128i
+ghash_step(__m128i Xi, __m128i b, __m128i H, size_t left)
+{
+	__m128i y = gfmul(_mm_xor_si128(Xi, bswap128(b)), H);
+	__m128i keep = _mm_set1_epi32(left ? 0 : -1);
+
+	return _mm_or_si128(_mm_and_si128(keep, Xi),
+			    _mm_andnot_si128(keep, y));
+}
+
+/*
+ * N records in lockstep, N a constant so the lane loops unroll and the
+ * blocks of a step stay in registers. Every step covers all N lanes; the
+ * lanes of records that have run out compute on nothing.
+ */
+static inline __attribute__((always_inline)) void
+gcm_open_lanes(const AES_KEY *const *key, struct aes_gcm_mb *const *rec,
+	       uint8_t tag[][16], const unsigned int N)
+{
+	const __m128i one = _mm_set_epi32(0, 0, 0, 1);
+	__m128i H[AES_GCM_MB_LANES], Xi[AES_GCM_MB_LANES];
+	__m128i ctr[AES_GCM_MB_LANES], EK0[AES_GCM_MB_LANES];
+	__m128i x[AES_GCM_MB_LANES];
+	size_t aad_max = 0, len_max = 0, off;
+	unsigned int l, nr = AES_AWS_MAXNR;
+
+	/* H, then EK0 = AES_K(J0); the counter is kept byte-reflected, so
+	 * its 32 bits sit in the low dword */
+#pragma GCC unroll 8
+	for (l = 0; l < N; l++) {
+		uint8_t j0[16];
+
+		memcpy(j0, rec[l]->iv, 12);
+		j0[12] = j0[13] = j0[14] = 0;
+		j0[15] = 1;
+		ctr[l] = bswap128(_mm_loadu_si128((const __m128i *)j0));
+		x[l] = _mm_setzero_si128();
+		Xi[l] = _mm_setzero_si128();
+		if (key[l]->rounds < nr)
+			nr = key[l]->rounds;
+		if (rec[l]->aad_len > aad_max)
+			aad_max = rec[l]->aad_len;
+		if (rec[l]->len > len_max)
+			len_max = rec[l]->len;
+	}
+	aes_encrypt_xN(x, key, nr, N);
+#pragma GCC unroll 8
+	for (l = 0; l < N; l++) {
+		H[l] = bswap128(x[l]);
+		x[l] = bswap128(ctr[l]);
+	}
+	aes_encrypt_xN(x, key, nr, N);
+#pragma GCC unroll 8
+	for (l = 0; l < N; l++)
+		EK0[l] = x[l];
+
+	for (off = 0; off < aad_max; off += 16)
+#pragma GCC unroll 8
+		for (l = 0; l < N; l++) {
+			size_t left = left_of(rec[l]->aad_len, off);
+
+			Xi[l] = ghash_step(Xi[l],
+					   load_block(rec[l]->aad + off, left),
+					   H[l], left);
+		}
+
+	for (off = 0; off < len_max; off += 16) {
+#pragma GCC unroll 8
+		for (l = 0; l < N; l++) {
+			ctr[l] = _mm_add_epi32(ctr[l], one);
+			x[l] = bswap128(ctr[l]);
+		}
+		aes_encrypt_xN(x, key, nr, N);
+#pragma GCC unroll 8
+		for (l = 0; l < N; l++) {
+			size_t left = left_of(rec[l]->len, off);
+			__m128i c = load_block(rec[l]->in + off, left);
+
+			Xi[l] = ghash_step(Xi[l], c, H[l], left);
+			store_block(rec[l]->out + off, _mm_xor_si128(c, x[l]),
+				    left);
+		}
+	}
+
+	/* the length block (aad_bits || msg_bits), reflected, then the mask */
+#pragma GCC unroll 8
+	for (l = 0; l < N; l++) {
+		__m128i lb = _mm_set_epi64x((long long)(rec[l]->aad_len << 3),
+					    (long long)(rec[l]->len << 3));
+
+		Xi[l] = gfmul(_mm_xor_si128(Xi[l], lb), H[l]);
+		_mm_storeu_si128((__m128i *)tag[l],
+				 _mm_xor_si128(bswap128(Xi[l]), EK0[l]));
+	}
+}
+
+/*
+ * Four lanes at most: with eight the blocks of a step no longer fit the
+ * sixteen XMM registers and the spills cost more than the overlap gains.
+ */
+void
+aes_hw_gcm_open_xN(const AES_KEY *const *key, struct aes_gcm_mb *const *rec,
+		   uint8_t tag[][16], unsigned int n)
+{
+	unsigned int w;
+
+	for (; n; n -= w, key += w, rec += w, tag += w) {
+		w = n >= 4 ? 4 : n >= 2 ? 2 : 1;
+		switch (w) {
+		case 4:
+			gcm_open_lanes(key, rec, tag, 4);
+			break;
+		case 2:
+			gcm_open_lanes(key, rec, tag, 2);
+			break;
+		default:
+			gcm_open_lanes(key, rec, tag, 1);
+		}
+	}
+}
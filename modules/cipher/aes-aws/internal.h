@@ -2,7 +2,8 @@
  * Shared prototypes for the aws-lc AES-NI / ARMv8 assembly primitives used by
  * the accelerated AES cipher glue. These match the entry points exported by
  * vendor/aws-lc/.../aesni-x86_64.S + ghash-x86_64.S (x86_64) and
- * aesv8-armx.S + ghashv8-armx.S (ARMv8).
+ * aesv8-armx.S + ghashv8-armx.S (ARMv8). The portable constant-time backend
+ * (../aes-ct) implements the same aes_hw_* ABI in C.
  */
 #ifndef __OSS_CRYPTO_CIPHER_AES_AWS_INTERNAL_H__
 #define __OSS_CRYPTO_CIPHER_AES_AWS_INTERNAL_H__
@@ -34,6 +35,34 @@ void aes_hw_cbc_encrypt(const uint8_t *in, uint8_t *out, size_t length,
 void aes_hw_ctr32_encrypt_blocks(const uint8_t *in, uint8_t *out, size_t len,
 				 const AES_KEY *key, const uint8_t ivec[16]);
 
+#ifdef AES_AWS_KEYEXP_BATCH
+/*
+ * Batched key setup (keyexp-x86_64.c): expand |n| <= AES_HW_KEY_LANES
+ * 128- or 256-bit keys into |key| exactly as aes_hw_set_encrypt_key would,
+ * and write each hash subkey AES_K(0^128) to |H|, running the independent
+ * chains side by side. Returns non-zero for any other key size.
+ */
+#define AES_HW_KEY_LANES 4
+
+int aes_hw_set_encrypt_key_hash_xN(const uint8_t *const *user_key, int bits,
+				   AES_KEY *const *key, uint8_t H[][16],
+				   unsigned int n);
+#endif
+
+#ifdef AES_AWS_GCM_MB
+/*
+ * Multi-buffer GCM open (gcm-mb-x86_64.c): decrypt the |n| <=
+ * AES_GCM_MB_LANES records rec[i] under key[i] side by side and write each
+ * computed tag to tag[i]; the caller compares them. Needs AES-NI and
+ * PCLMULQDQ.
+ */
+struct aes_gcm_mb;
+
+void aes_hw_gcm_open_xN(const AES_KEY *const *key,
+			struct aes_gcm_mb *const *rec, uint8_t tag[][16],
+			unsigned int n);
+#endif
+
 /*
  * GHASH primitives. The concrete flavour (CLMUL for x86_64, PMULL/v8 for
  * ARMv8) is selected by the per-architecture Kbuild via -D. |H| is passed as a
@@ -50,4 +79,49 @@ void AES_AWS_GHASH_GMULT(uint8_t Xi[16], const u128 Htable[16]);
 void AES_AWS_GHASH_GHASH(uint8_t Xi[16], const u128 Htable[16],
 			 const uint8_t *inp, size_t len);
 
+#ifdef AES_AWS_GCM_STITCHED
+/*
+ * Stitched AES-NI + PCLMULQDQ GCM bulk kernel (aesni-gcm-x86_64.S). Encrypts
+ * or decrypts whole 96-byte (6-block) strides while folding the ciphertext
+ * into Xi, advancing the counter block |ivec| as it goes. Returns the number
+ * of bytes consumed, which may be zero for short inputs; the caller finishes
+ * the tail with the ctr32/GHASH primitives above. Needs AVX + MOVBE and a
+ * table built by gcm_init_avx, so the AVX GHASH flavour is paired with it.
+ */
+size_t aesni_gcm_encrypt(const uint8_t *in, uint8_t *out, size_t len,
+			 const AES_KEY *key, uint8_t ivec[16],
+			 const u128 Htable[16], uint8_t Xi[16]);
+size_t aesni_gcm_decrypt(const uint8_t *in, uint8_t *out, size_t len,
+			 const AES_KEY *key, uint8_t ivec[16],
+			 const u128 Htable[16], uint8_t Xi[16]);
+
+void gcm_init_avx(u128 Htable[16], const uint64_t H[2]);
+void gcm_gmult_avx(uint8_t Xi[16], const u128 Htable[16]);
+void gcm_ghash_avx(uint8_t Xi[16], const u128 Htable[16],
+		   const uint8_t *inp, size_t len);
+#endif
+
+#ifdef AES_AWS_GCM_VAES
+/*
+ * VAES + VPCLMULQDQ AES-GCM (aes-gcm-avx512-x86_64.S): four counter blocks
+ * per 512-bit VAES instruction and a four-way ZMM GHASH. |len| must be a
+ * multiple of 16; |ivec| is read but not advanced, so the caller steps the
+ * 32-bit counter by len / 16. Needs AVX512F/BW/VL + VAES + VPCLMULQDQ and
+ * a table built by gcm_init_vpclmulqdq_avx512.
+ */
+void aes_gcm_enc_update_vaes_avx512(const uint8_t *in, uint8_t *out,
+				    size_t len, const AES_KEY *key,
+				    const uint8_t ivec[16],
+				    const u128 Htable[16], uint8_t Xi[16]);
+void aes_gcm_dec_update_vaes_avx512(const uint8_t *in, uint8_t *out,
+				    size_t len, const AES_KEY *key,
+				    const uint8_t ivec[16],
+				    const u128 Htable[16], uint8_t Xi[16]);
+
+void gcm_init_vpclmulqdq_avx512(u128 Htable[16], const uint64_t H[2]);
+void gcm_gmult_vpclmulqdq_avx512(uint8_t Xi[16], const u128 Htable[16]);
+void gcm_ghash_vpclmulqdq_avx512(uint8_t Xi[16], const u128 Htable[16],
+				 const uint8_t *inp, size_t len);
+#endif
+
 #endif
@@ -0,0 +1,108 @@
+/*
+ * Batched AES-NI key schedule for aes_gcm_setkey_batch on the x86_64 aws-lc
+ * backends. One key expansion is a chain of ten (AES-128) or thirteen
+ * (AES-256) dependent aeskeygenassist + shuffle/xor steps, and deriving the
+ * hash subkey H = AES_K(0^128) after it is another chain of aesenc; a single
+ * key leaves the AES unit idle most of the time. Here up to AES_HW_KEY_LANES
+ * keys are expanded step for step side by side, so their chains issue back
+ * to back, and the zero block is encrypted under all of them the same way.
+ *
+ * The schedule is stored exactly as aesni_set_encrypt_key (aws-lc
+ * aes_hw_set_encrypt_key) stores it: the round keys as 16-byte blocks in
+ * order and |rounds| one less than the AES round count (9 for AES-128, 13
+ * for AES-256), which is what the aes_hw_* and GCM kernels expect.
+ */
+#include <wmmintrin.h>
+#include "internal.h"
+
+static inline __m128i
+keyexp_mix(__m128i k)
+{
+	k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+	k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+	return _mm_xor_si128(k, _mm_slli_si128(k, 4));
+}
+
+/* rk[i] from rk[i - 1] (the assist input) and rk[i - |back|], all lanes. */
+#define KEYEXP_STEP(rk, n, i, back, rcon, shuf)				\
+	for (unsigned int l = 0; l < (n); l++)				\
+		rk[l][i] = _mm_xor_si128(keyexp_mix(rk[l][(i) - (back)]),	\
+			_mm_shuffle_epi32(_mm_aeskeygenassist_si128(	\
+				rk[l][(i) - 1], rcon), shuf))
+
+static void
+keyexp128(__m128i rk[][15], unsigned int n)
+{
+	KEYEXP_STEP(rk, n, 1, 1, 0x01, 0xff);
+	KEYEXP_STEP(rk, n, 2, 1, 0x02, 0xff);
+	KEYEXP_STEP(rk, n, 3, 1, 0x04, 0xff);
+	KEYEXP_STEP(rk, n, 4, 1, 0x08, 0xff);
+	KEYEXP_STEP(rk, n, 5, 1, 0x10, 0xff);
+	KEYEXP_STEP(rk, n, 6, 1, 0x20, 0xff);
+	KEYEXP_STEP(rk, n, 7, 1, 0x40, 0xff);
+	KEYEXP_STEP(rk, n, 8, 1, 0x80, 0xff);
+	KEYEXP_STEP(rk, n, 9, 1, 0x1b, 0xff);
+	KEYEXP_STEP(rk, n, 10, 1, 0x36, 0xff);
+}
+
+/* Even round keys take RotWord/SubWord with rcon, odd ones SubWord only. */
+static void
+keyexp256(__m128i rk[][15], unsigned int n)
+{
+	KEYEXP_STEP(rk, n, 2, 2, 0x01, 0xff);
+	KEYEXP_STEP(rk, n, 3, 2, 0x00, 0xaa);
+	KEYEXP_STEP(rk, n, 4, 2, 0x02, 0xff);
+	KEYEXP_STEP(rk, n, 5, 2, 0x00, 0xaa);
+	KEYEXP_STEP(rk, n, 6, 2, 0x04, 0xff);
+	KEYEXP_STEP(rk, n, 7, 2, 0x00, 0xaa);
+	KEYEXP_STEP(rk, n, 8, 2, 0x08, 0xff);
+	KEYEXP_STEP(rk, n, 9, 2, 0x00, 0xaa);
+	KEYEXP_STEP(rk, n, 10, 2, 0x10, 0xff);
+	KEYEXP_STEP(rk, n, 11, 2, 0x00, 0xaa);
+	KEYEXP_STEP(rk, n, 12, 2, 0x20, 0xff);
+	KEYEXP_STEP(rk, n, 13, 2, 0x00, 0xaa);
+	KEYEXP_STEP(rk, n, 14, 2, 0x40, 0xff);
+}
+
+int
+aes_hw_set_encrypt_key_hash_xN(const uint8_t *const *user_key, int bits,
+			       AES_KEY *const *key, uint8_t H[][16],
+			       unsigned int n)
+{
+	__m128i rk[AES_HW_KEY_LANES][15], x[AES_HW_KEY_LANES];
+	unsigned int l, r, nr;
+
+	if ((bits != 128 && bits != 256) || n > AES_HW_KEY_LANES)
+		return -1;
+	nr = bits == 128 ? 10 : 14;
+
+	for (l = 0; l < n; l++) {
+		rk[l][0] = _mm_loadu_si128((const __m128i *)user_key[l]);
+		if (bits == 256)
+			rk[l][1] = _mm_loadu_si128(
+				(const __m128i *)(user_key[l] + 16));
+	}
+	if (bits == 128)
+		keyexp128(rk, n);
+	else
+		keyexp256(rk, n);
+
+	/* H = AES_K(0^128): the first AddRoundKey leaves just rk[0]. */
+	for (l = 0; l < n; l++)
+		x[l] = rk[l][0];
+	for (r = 1; r < nr; r++)
+		for (l = 0; l < n; l++)
+			x[l] = _mm_aesenc_si128(x[l], rk[l][r]);
+	for (l = 0; l < n; l++) {
+		x[l] = _mm_aesenclast_si128(x[l], rk[l][nr]);
+		_mm_storeu_si128((__m128i *)H[l], x[l]);
+	}
+
+	for (l = 0; l < n; l++) {
+		for (r = 0; r <= nr; r++)
+			_mm_storeu_si128((__m128i *)&key[l]->rd_key[4 * r],
+					 rk[l][r]);
+		key[l]->rounds = nr - 1;
+	}
+	return 0;
+}
@@ -0,0 +1,667 @@
+/*
+ * Constant-time bitsliced AES for cores without AES instructions, after
+ * BearSSL's aes_ct64 (Thomas Pornin, MIT licence). Four blocks are processed
+ * in parallel, spread over eight 64-bit words; the S-box is the Boyar-Peralta
+ * boolean circuit, so there are no table lookups and no secret-dependent
+ * branches or memory accesses anywhere in the key schedule or the rounds.
+ *
+ * This file exports the aes_hw_* primitive ABI from ../aes-aws/internal.h, so
+ * the shared CBC and GCM glue (aes-cbc.c, gcm-aws.c) runs unchanged on top of
+ * it. AES_KEY.rd_key holds the compressed bitsliced schedule (2 words per
+ * round key, at most 30 words = 240 bytes); it is expanded on the stack per
+ * call. The same schedule serves both directions.
+ */
+#include <string.h>
+#include <hpc/mem/unaligned.h>
+#include "internal.h"
+
+#define CT64_MAX_SKEY (2 * (AES_AWS_MAXNR + 1))
+
+_Static_assert(CT64_MAX_SKEY * sizeof(uint64_t) <=
+	       sizeof(((AES_KEY *)0)->rd_key),
+	       "bitsliced AES schedule does not fit in AES_KEY");
+
+/*
+ * The AES S-box over 8 bitsliced words (Boyar-Peralta, 113 gates). q[7] holds
+ * the most significant bit of each byte.
+ */
+static void
+ct64_sbox(uint64_t *q)
+{
+	uint64_t x0, x1, x2, x3, x4, x5, x6, x7;
+	uint64_t y1, y2, y3, y4, y5, y6, y7, y8, y9;
+	uint64_t y10, y11, y12, y13, y14, y15, y16, y17, y18, y19;
+	uint64_t y20, y21;
+	uint64_t z0, z1, z2, z3, z4, z5, z6, z7, z8, z9;
+	uint64_t z10, z11, z12, z13, z14, z15, z16, z17;
+	uint64_t t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
+	uint64_t t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+	uint64_t t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+	uint64_t t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+	uint64_t t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+	uint64_t t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+	uint64_t t60, t61, t62, t63, t64, t65, t66, t67;
+	uint64_t s0, s1, s2, s3, s4, s5, s6, s7;
+
+	x0 = q[7];
+	x1 = q[6];
+	x2 = q[5];
+	x3 = q[4];
+	x4 = q[3];
+	x5 = q[2];
+	x6 = q[1];
+	x7 = q[0];
+
+	/* Top linear transformation. */
+	y14 = x3 ^ x5;
+	y13 = x0 ^ x6;
+	y9 = x0 ^ x3;
+	y8 = x0 ^ x5;
+	t0 = x1 ^ x2;
+	y1 = t0 ^ x7;
+	y4 = y1 ^ x3;
+	y12 = y13 ^ y14;
+	y2 = y1 ^ x0;
+	y5 = y1 ^ x6;
+	y3 = y5 ^ y8;
+	t1 = x4 ^ y12;
+	y15 = t1 ^ x5;
+	y20 = t1 ^ x1;
+	y6 = y15 ^ x7;
+	y10 = y15 ^ t0;
+	y11 = y20 ^ y9;
+	y7 = x7 ^ y11;
+	y17 = y10 ^ y11;
+	y19 = y10 ^ y8;
+	y16 = t0 ^ y11;
+	y21 = y13 ^ y16;
+	y18 = x0 ^ y16;
+
+	/* Non-linear section. */
+	t2 = y12 & y15;
+	t3 = y3 & y6;
+	t4 = t3 ^ t2;
+	t5 = y4 & x7;
+	t6 = t5 ^ t2;
+	t7 = y13 & y16;
+	t8 = y5 & y1;
+	t9 = t8 ^ t7;
+	t10 = y2 & y7;
+	t11 = t10 ^ t7;
+	t12 = y9 & y11;
+	t13 = y14 & y17;
+	t14 = t13 ^ t12;
+	t15 = y8 & y10;
+	t16 = t15 ^ t12;
+	t17 = t4 ^ t14;
+	t18 = t6 ^ t16;
+	t19 = t9 ^ t14;
+	t20 = t11 ^ t16;
+	t21 = t17 ^ y20;
+	t22 = t18 ^ y19;
+	t23 = t19 ^ y21;
+	t24 = t20 ^ y18;
+
+	t25 = t21 ^ t22;
+	t26 = t21 & t23;
+	t27 = t24 ^ t26;
+	t28 = t25 & t27;
+	t29 = t28 ^ t22;
+	t30 = t23 ^ t24;
+	t31 = t22 ^ t26;
+	t32 = t31 & t30;
+	t33 = t32 ^ t24;
+	t34 = t23 ^ t33;
+	t35 = t27 ^ t33;
+	t36 = t24 & t35;
+	t37 = t36 ^ t34;
+	t38 = t27 ^ t36;
+	t39 = t29 & t38;
+	t40 = t25 ^ t39;
+
+	t41 = t40 ^ t37;
+	t42 = t29 ^ t33;
+	t43 = t29 ^ t40;
+	t44 = t33 ^ t37;
+	t45 = t42 ^ t41;
+	z0 = t44 & y15;
+	z1 = t37 & y6;
+	z2 = t33 & x7;
+	z3 = t43 & y16;
+	z4 = t40 & y1;
+	z5 = t29 & y7;
+	z6 = t42 & y11;
+	z7 = t45 & y17;
+	z8 = t41 & y10;
+	z9 = t44 & y12;
+	z10 = t37 & y3;
+	z11 = t33 & y4;
+	z12 = t43 & y13;
+	z13 = t40 & y5;
+	z14 = t29 & y2;
+	z15 = t42 & y9;
+	z16 = t45 & y14;
+	z17 = t41 & y8;
+
+	/* Bottom linear transformation. */
+	t46 = z15 ^ z16;
+	t47 = z10 ^ z11;
+	t48 = z5 ^ z13;
+	t49 = z9 ^ z10;
+	t50 = z2 ^ z12;
+	t51 = z2 ^ z5;
+	t52 = z7 ^ z8;
+	t53 = z0 ^ z3;
+	t54 = z6 ^ z7;
+	t55 = z16 ^ z17;
+	t56 = z12 ^ t48;
+	t57 = t50 ^ t53;
+	t58 = z4 ^ t46;
+	t59 = z3 ^ t54;
+	t60 = t46 ^ t57;
+	t61 = z14 ^ t57;
+	t62 = t52 ^ t58;
+	t63 = t49 ^ t58;
+	t64 = z4 ^ t59;
+	t65 = t61 ^ t62;
+	t66 = z1 ^ t63;
+	s0 = t59 ^ t63;
+	s6 = t56 ^ ~t62;
+	s7 = t48 ^ ~t60;
+	t67 = t64 ^ t65;
+	s3 = t53 ^ t66;
+	s4 = t51 ^ t66;
+	s5 = t47 ^ t65;
+	s1 = t64 ^ ~s3;
+	s2 = t55 ^ ~t67;
+
+	q[7] = s0;
+	q[6] = s1;
+	q[5] = s2;
+	q[4] = s3;
+	q[3] = s4;
+	q[2] = s5;
+	q[1] = s6;
+	q[0] = s7;
+}
+
+/* The affine map that, wrapped around the forward circuit, inverts it. */
+static void
+ct64_inv_affine(uint64_t *q)
+{
+	uint64_t q0, q1, q2, q3, q4, q5, q6, q7;
+
+	q0 = ~q[0];
+	q1 = ~q[1];
+	q2 = q[2];
+	q3 = q[3];
+	q4 = q[4];
+	q5 = ~q[5];
+	q6 = ~q[6];
+	q7 = q[7];
+	q[7] = q1 ^ q4 ^ q6;
+	q[6] = q0 ^ q3 ^ q5;
+	q[5] = q7 ^ q2 ^ q4;
+	q[4] = q6 ^ q1 ^ q3;
+	q[3] = q5 ^ q0 ^ q2;
+	q[2] = q4 ^ q7 ^ q1;
+	q[1] = q3 ^ q6 ^ q0;
+	q[0] = q2 ^ q5 ^ q7;
+}
+
+static void
+ct64_inv_sbox(uint64_t *q)
+{
+	ct64_inv_affine(q);
+	ct64_sbox(q);
+	ct64_inv_affine(q);
+}
+
+#define SWAPN(cl, ch, s, x, y) do { \
+		uint64_t a_ = (x), b_ = (y); \
+		(x) = (a_ & (uint64_t)(cl)) | ((b_ & (uint64_t)(cl)) << (s)); \
+		(y) = ((a_ & (uint64_t)(ch)) >> (s)) | (b_ & (uint64_t)(ch)); \
+	} while (0)
+
+#define SWAP2(x, y) SWAPN(0x5555555555555555, 0xAAAAAAAAAAAAAAAA, 1, x, y)
+#define SWAP4(x, y) SWAPN(0x3333333333333333, 0xCCCCCCCCCCCCCCCC, 2, x, y)
+#define SWAP8(x, y) SWAPN(0x0F0F0F0F0F0F0F0F, 0xF0F0F0F0F0F0F0F0, 4, x, y)
+
+/* Transpose between the interleaved and the bitsliced representation. */
+static void
+ct64_ortho(uint64_t *q)
+{
+	SWAP2(q[0], q[1]);
+	SWAP2(q[2], q[3]);
+	SWAP2(q[4], q[5]);
+	SWAP2(q[6], q[7]);
+
+	SWAP4(q[0], q[2]);
+	SWAP4(q[1], q[3]);
+	SWAP4(q[4], q[6]);
+	SWAP4(q[5], q[7]);
+
+	SWAP8(q[0], q[4]);
+	SWAP8(q[1], q[5]);
+	SWAP8(q[2], q[6]);
+	SWAP8(q[3], q[7]);
+}
+
+/* Spread one block (four little-endian words) over a pair of words. */
+static void
+ct64_interleave_in(uint64_t *q0, uint64_t *q1, const uint32_t *w)
+{
+	uint64_t x0, x1, x2, x3;
+
+	x0 = w[0];
+	x1 = w[1];
+	x2 = w[2];
+	x3 = w[3];
+	x0 |= (x0 << 16);
+	x1 |= (x1 << 16);
+	x2 |= (x2 << 16);
+	x3 |= (x3 << 16);
+	x0 &= (uint64_t)0x0000FFFF0000FFFF;
+	x1 &= (uint64_t)0x0000FFFF0000FFFF;
+	x2 &= (uint64_t)0x0000FFFF0000FFFF;
+	x3 &= (uint64_t)0x0000FFFF0000FFFF;
+	x0 |= (x0 << 8);
+	x1 |= (x1 << 8);
+	x2 |= (x2 << 8);
+	x3 |= (x3 << 8);
+	x0 &= (uint64_t)0x00FF00FF00FF00FF;
+	x1 &= (uint64_t)0x00FF00FF00FF00FF;
+	x2 &= (uint64_t)0x00FF00FF00FF00FF;
+	x3 &= (uint64_t)0x00FF00FF00FF00FF;
+	*q0 = x0 | (x2 << 8);
+	*q1 = x1 | (x3 << 8);
+}
+
+static void
+ct64_interleave_out(uint32_t *w, uint64_t q0, uint64_t q1)
+{
+	uint64_t x0, x1, x2, x3;
+
+	x0 = q0 & (uint64_t)0x00FF00FF00FF00FF;
+	x1 = q1 & (uint64_t)0x00FF00FF00FF00FF;
+	x2 = (q0 >> 8) & (uint64_t)0x00FF00FF00FF00FF;
+	x3 = (q1 >> 8) & (uint64_t)0x00FF00FF00FF00FF;
+	x0 |= (x0 >> 8);
+	x1 |= (x1 >> 8);
+	x2 |= (x2 >> 8);
+	x3 |= (x3 >> 8);
+	x0 &= (uint64_t)0x0000FFFF0000FFFF;
+	x1 &= (uint64_t)0x0000FFFF0000FFFF;
+	x2 &= (uint64_t)0x0000FFFF0000FFFF;
+	x3 &= (uint64_t)0x0000FFFF0000FFFF;
+	w[0] = (uint32_t)x0 | (uint32_t)(x0 >> 16);
+	w[1] = (uint32_t)x1 | (uint32_t)(x1 >> 16);
+	w[2] = (uint32_t)x2 | (uint32_t)(x2 >> 16);
+	w[3] = (uint32_t)x3 | (uint32_t)(x3 >> 16);
+}
+
+static uint32_t
+ct64_sub_word(uint32_t x)
+{
+	uint64_t q[8];
+
+	memset(q, 0, sizeof(q));
+	q[0] = x;
+	ct64_ortho(q);
+	ct64_sbox(q);
+	ct64_ortho(q);
+	return (uint32_t)q[0];
+}
+
+static const uint8_t ct64_rcon[] = {
+	0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36
+};
+
+/* FIPS-197 key expansion, stored compressed: 2 words per round key. */
+static unsigned int
+ct64_keysched(uint64_t *comp_skey, const uint8_t *key, unsigned int key_len)
+{
+	uint32_t skey[4 * (AES_AWS_MAXNR + 1)];
+	unsigned int rounds, nk, nkf, i, j, k;
+	uint32_t tmp;
+
+	rounds = key_len / 4 + 6;
+	nk = key_len / 4;
+	nkf = (rounds + 1) * 4;
+	for (i = 0; i < nk; i++)
+		skey[i] = get_u32_le(key + 4 * i);
+	tmp = skey[nk - 1];
+	for (i = nk, j = 0, k = 0; i < nkf; i++) {
+		if (j == 0) {
+			tmp = (tmp << 24) | (tmp >> 8);
+			tmp = ct64_sub_word(tmp) ^ ct64_rcon[k];
+		} else if (nk > 6 && j == 4) {
+			tmp = ct64_sub_word(tmp);
+		}
+		tmp ^= skey[i - nk];
+		skey[i] = tmp;
+		if (++j == nk) {
+			j = 0;
+			k++;
+		}
+	}
+
+	for (i = 0, j = 0; i < nkf; i += 4, j += 2) {
+		uint64_t q[8];
+
+		ct64_interleave_in(&q[0], &q[4], skey + i);
+		q[1] = q[0];
+		q[2] = q[0];
+		q[3] = q[0];
+		q[5] = q[4];
+		q[6] = q[4];
+		q[7] = q[4];
+		ct64_ortho(q);
+		comp_skey[j + 0] =
+			  (q[0] & (uint64_t)0x1111111111111111)
+			| (q[1] & (uint64_t)0x2222222222222222)
+			| (q[2] & (uint64_t)0x4444444444444444)
+			| (q[3] & (uint64_t)0x8888888888888888);
+		comp_skey[j + 1] =
+			  (q[4] & (uint64_t)0x1111111111111111)
+			| (q[5] & (uint64_t)0x2222222222222222)
+			| (q[6] & (uint64_t)0x4444444444444444)
+			| (q[7] & (uint64_t)0x8888888888888888);
+	}
+	memset(skey, 0, sizeof(skey));
+	return rounds;
+}
+
+/* Expand the compressed schedule into 8 words per round key. */
+static void
+ct64_skey_expand(uint64_t *skey, const AES_KEY *key)
+{
+	uint64_t comp[CT64_MAX_SKEY];
+	unsigned int u, v, n = (key->rounds + 1) * 2;
+
+	memcpy(comp, key->rd_key, n * sizeof(uint64_t));
+	for (u = 0, v = 0; u < n; u++, v += 4) {
+		uint64_t x0, x1, x2, x3;
+
+		x0 = x1 = x2 = x3 = comp[u];
+		x0 &= (uint64_t)0x1111111111111111;
+		x1 &= (uint64_t)0x2222222222222222;
+		x2 &= (uint64_t)0x4444444444444444;
+		x3 &= (uint64_t)0x8888888888888888;
+		x1 >>= 1;
+		x2 >>= 2;
+		x3 >>= 3;
+		skey[v + 0] = (x0 << 4) - x0;
+		skey[v + 1] = (x1 << 4) - x1;
+		skey[v + 2] = (x2 << 4) - x2;
+		skey[v + 3] = (x3 << 4) - x3;
+	}
+}
+
+static inline void
+add_round_key(uint64_t *q, const uint64_t *sk)
+{
+	for (unsigned int i = 0; i < 8; i++)
+		q[i] ^= sk[i];
+}
+
+static inline void
+shift_rows(uint64_t *q)
+{
+	for (unsigned int i = 0; i < 8; i++) {
+		uint64_t x = q[i];
+
+		q[i] = (x & (uint64_t)0x000000000000FFFF)
+			| ((x & (uint64_t)0x00000000FFF00000) >> 4)
+			| ((x & (uint64_t)0x00000000000F0000) << 12)
+			| ((x & (uint64_t)0x0000FF0000000000) >> 8)
+			| ((x & (uint64_t)0x000000FF00000000) << 8)
+			| ((x & (uint64_t)0xF000000000000000) >> 12)
+			| ((x & (uint64_t)0x0FFF000000000000) << 4);
+	}
+}
+
+static inline void
+inv_shift_rows(uint64_t *q)
+{
+	for (unsigned int i = 0; i < 8; i++) {
+		uint64_t x = q[i];
+
+		q[i] = (x & (uint64_t)0x000000000000FFFF)
+			| ((x & (uint64_t)0x000000000FFF0000) << 4)
+			| ((x & (uint64_t)0x00000000F0000000) >> 12)
+			| ((x & (uint64_t)0x000000FF00000000) << 8)
+			| ((x & (uint64_t)0x0000FF0000000000) >> 8)
+			| ((x & (uint64_t)0x000F000000000000) << 12)
+			| ((x & (uint64_t)0xFFF0000000000000) >> 4);
+	}
+}
+
+static inline uint64_t
+rotr32(uint64_t x)
+{
+	return (x << 32) | (x >> 32);
+}
+
+static inline void
+mix_columns(uint64_t *q)
+{
+	uint64_t q0, q1, q2, q3, q4, q5, q6, q7;
+	uint64_t r0, r1, r2, r3, r4, r5, r6, r7;
+
+	q0 = q[0];
+	q1 = q[1];
+	q2 = q[2];
+	q3 = q[3];
+	q4 = q[4];
+	q5 = q[5];
+	q6 = q[6];
+	q7 = q[7];
+	r0 = (q0 >> 16) | (q0 << 48);
+	r1 = (q1 >> 16) | (q1 << 48);
+	r2 = (q2 >> 16) | (q2 << 48);
+	r3 = (q3 >> 16) | (q3 << 48);
+	r4 = (q4 >> 16) | (q4 << 48);
+	r5 = (q5 >> 16) | (q5 << 48);
+	r6 = (q6 >> 16) | (q6 << 48);
+	r7 = (q7 >> 16) | (q7 << 48);
+
+	q[0] = q7 ^ r7 ^ r0 ^ rotr32(q0 ^ r0);
+	q[1] = q0 ^ r0 ^ q7 ^ r7 ^ r1 ^ rotr32(q1 ^ r1);
+	q[2] = q1 ^ r1 ^ r2 ^ rotr32(q2 ^ r2);
+	q[3] = q2 ^ r2 ^ q7 ^ r7 ^ r3 ^ rotr32(q3 ^ r3);
+	q[4] = q3 ^ r3 ^ q7 ^ r7 ^ r4 ^ rotr32(q4 ^ r4);
+	q[5] = q4 ^ r4 ^ r5 ^ rotr32(q5 ^ r5);
+	q[6] = q5 ^ r5 ^ r6 ^ rotr32(q6 ^ r6);
+	q[7] = q6 ^ r6 ^ r7 ^ rotr32(q7 ^ r7);
+}
+
+static inline void
+inv_mix_columns(uint64_t *q)
+{
+	uint64_t q0, q1, q2, q3, q4, q5, q6, q7;
+	uint64_t r0, r1, r2, r3, r4, r5, r6, r7;
+
+	q0 = q[0];
+	q1 = q[1];
+	q2 = q[2];
+	q3 = q[3];
+	q4 = q[4];
+	q5 = q[5];
+	q6 = q[6];
+	q7 = q[7];
+	r0 = (q0 >> 16) | (q0 << 48);
+	r1 = (q1 >> 16) | (q1 << 48);
+	r2 = (q2 >> 16) | (q2 << 48);
+	r3 = (q3 >> 16) | (q3 << 48);
+	r4 = (q4 >> 16) | (q4 << 48);
+	r5 = (q5 >> 16) | (q5 << 48);
+	r6 = (q6 >> 16) | (q6 << 48);
+	r7 = (q7 >> 16) | (q7 << 48);
+
+	q[0] = q5 ^ q6 ^ q7 ^ r0 ^ r5 ^ r7 ^ rotr32(q0 ^ q5 ^ q6 ^ r0 ^ r5);
+	q[1] = q0 ^ q5 ^ r0 ^ r1 ^ r5 ^ r6 ^ r7 ^
+	       rotr32(q1 ^ q5 ^ q7 ^ r1 ^ r5 ^ r6);
+	q[2] = q0 ^ q1 ^ q6 ^ r1 ^ r2 ^ r6 ^ r7 ^
+	       rotr32(q0 ^ q2 ^ q6 ^ r2 ^ r6 ^ r7);
+	q[3] = q0 ^ q1 ^ q2 ^ q5 ^ q6 ^ r0 ^ r2 ^ r3 ^ r5 ^
+	       rotr32(q0 ^ q1 ^ q3 ^ q5 ^ q6 ^ q7 ^ r0 ^ r3 ^ r5 ^ r7);
+	q[4] = q1 ^ q2 ^ q3 ^ q5 ^ r1 ^ r3 ^ r4 ^ r5 ^ r6 ^ r7 ^
+	       rotr32(q1 ^ q2 ^ q4 ^ q5 ^ q7 ^ r1 ^ r4 ^ r5 ^ r6);
+	q[5] = q2 ^ q3 ^ q4 ^ q6 ^ r2 ^ r4 ^ r5 ^ r6 ^ r7 ^
+	       rotr32(q2 ^ q3 ^ q5 ^ q6 ^ r2 ^ r5 ^ r6 ^ r7);
+	q[6] = q3 ^ q4 ^ q5 ^ q7 ^ r3 ^ r5 ^ r6 ^ r7 ^
+	       rotr32(q3 ^ q4 ^ q6 ^ q7 ^ r3 ^ r6 ^ r7);
+	q[7] = q4 ^ q5 ^ q6 ^ r4 ^ r6 ^ r7 ^ rotr32(q4 ^ q5 ^ q7 ^ r4 ^ r7);
+}
+
+static void
+ct64_encrypt(unsigned int rounds, const uint64_t *skey, uint64_t *q)
+{
+	add_round_key(q, skey);
+	for (unsigned int u = 1; u < rounds; u++) {
+		ct64_sbox(q);
+		shift_rows(q);
+		mix_columns(q);
+		add_round_key(q, skey + (u << 3));
+	}
+	ct64_sbox(q);
+	shift_rows(q);
+	add_round_key(q, skey + (rounds << 3));
+}
+
+static void
+ct64_decrypt(unsigned int rounds, const uint64_t *skey, uint64_t *q)
+{
+	add_round_key(q, skey + (rounds << 3));
+	for (unsigned int u = rounds - 1; u > 0; u--) {
+		inv_shift_rows(q);
+		ct64_inv_sbox(q);
+		add_round_key(q, skey + (u << 3));
+		inv_mix_columns(q);
+	}
+	inv_shift_rows(q);
+	ct64_inv_sbox(q);
+	add_round_key(q, skey);
+}
+
+/* Run |n| <= 4 blocks from |in| to |out| through the cipher in one pass. */
+static void
+ct64_blocks(const AES_KEY *key, const uint64_t *skey, int enc,
+	    const uint8_t *in, uint8_t *out, unsigned int n)
+{
+	uint32_t w[16];
+	uint64_t q[8];
+	unsigned int i;
+
+	memset(w, 0, sizeof(w));
+	for (i = 0; i < 4 * n; i++)
+		w[i] = get_u32_le(in + 4 * i);
+	for (i = 0; i < 4; i++)
+		ct64_interleave_in(&q[i], &q[i + 4], w + (i << 2));
+	ct64_ortho(q);
+	if (enc)
+		ct64_encrypt(key->rounds, skey, q);
+	else
+		ct64_decrypt(key->rounds, skey, q);
+	ct64_ortho(q);
+	for (i = 0; i < 4; i++)
+		ct64_interleave_out(w + (i << 2), q[i], q[i + 4]);
+	for (i = 0; i < 4 * n; i++)
+		put_u32_le(out + 4 * i, w[i]);
+}
+
+int
+aes_hw_set_encrypt_key(const uint8_t *user_key, int bits, AES_KEY *key)
+{
+	uint64_t comp[CT64_MAX_SKEY];
+
+	if (bits != 128 && bits != 192 && bits != 256)
+		return -1;
+	key->rounds = ct64_keysched(comp, user_key, (unsigned int)bits / 8);
+	memcpy(key->rd_key, comp, (key->rounds + 1) * 2 * sizeof(uint64_t));
+	return 0;
+}
+
+/* The bitsliced inverse cipher walks the encryption schedule backwards. */
+int
+aes_hw_set_decrypt_key(const uint8_t *user_key, int bits, AES_KEY *key)
+{
+	return aes_hw_set_encrypt_key(user_key, bits, key);
+}
+
+void
+aes_hw_encrypt(const uint8_t *in, uint8_t *out, const AES_KEY *key)
+{
+	uint64_t skey[8 * (AES_AWS_MAXNR + 1)];
+
+	ct64_skey_expand(skey, key);
+	ct64_blocks(key, skey, 1, in, out, 1);
+}
+
+void
+aes_hw_ctr32_encrypt_blocks(const uint8_t *in, uint8_t *out, size_t len,
+			    const AES_KEY *key, const uint8_t ivec[16])
+{
+	uint64_t skey[8 * (AES_AWS_MAXNR + 1)];
+	uint8_t ctr[4 * 16], ks[4 * 16];
+	uint32_t c = get_u32_be(ivec + 12);
+
+	ct64_skey_expand(skey, key);
+	while (len) {
+		unsigned int n = len < 4 ? (unsigned int)len : 4;
+		unsigned int i;
+
+		for (i = 0; i < n; i++) {
+			memcpy(ctr + 16 * i, ivec, 12);
+			put_u32_be(ctr + 16 * i + 12, c++);
+		}
+		ct64_blocks(key, skey, 1, ctr, ks, n);
+		for (i = 0; i < 16 * n; i++)
+			out[i] = in[i] ^ ks[i];
+		in += 16 * n;
+		out += 16 * n;
+		len -= n;
+	}
+}
+
+/*
+ * CBC. Encryption is inherently one block at a time; decryption has no
+ * chaining dependency through the cipher, so it takes four blocks per pass.
+ */
+void
+aes_hw_cbc_encrypt(const uint8_t *in, uint8_t *out, size_t length,
+		   const AES_KEY *key, uint8_t *ivec, int enc)
+{
+	uint64_t skey[8 * (AES_AWS_MAXNR + 1)];
+	uint8_t buf[4 * 16];
+	unsigned int i;
+
+	ct64_skey_expand(skey, key);
+	length &= ~(size_t)15;
+	if (enc) {
+		for (; length; length -= 16, in += 16, out += 16) {
+			for (i = 0; i < 16; i++)
+				buf[i] = in[i] ^ ivec[i];
+			ct64_blocks(key, skey, 1, buf, out, 1);
+			memcpy(ivec, out, 16);
+		}
+		return;
+	}
+
+	while (length) {
+		unsigned int n = length < 64 ? (unsigned int)(length / 16) : 4;
+		uint8_t ct[16 + 4 * 16];
+
+		/* Keep the ciphertext: |out| may alias |in|. */
+		memcpy(ct, ivec, 16);
+		memcpy(ct + 16, in, 16 * n);
+		ct64_blocks(key, skey, 0, in, buf, n);
+		for (i = 0; i < 16 * n; i++)
+			out[i] = buf[i] ^ ct[i];
+		memcpy(ivec, ct + 16 * n, 16);
+		in += 16 * n;
+		out += 16 * n;
+		length -= 16 * n;
+	}
+}
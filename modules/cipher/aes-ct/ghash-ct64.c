@@ -0,0 +1,140 @@
+/*
+ * Constant-time GHASH on plain 64-bit integer multiplies, after BearSSL's
+ * ghash_ctmul64 (Thomas Pornin, MIT licence). Carry-less products are built
+ * from ordinary multiplies on operands with "holes" (one bit in four kept),
+ * so no carry can spill into a bit that is later used; the GF(2^128) product
+ * uses Karatsuba on bit-reversed halves. No tables, no secret-dependent
+ * branches or memory accesses.
+ *
+ * Exported with the aws-lc GHASH signatures so gcm-aws.c picks it up through
+ * the AES_AWS_GHASH_* selection. Htable[0] holds H, Htable[1] its bit-reversed
+ * halves; the remaining entries are unused.
+ */
+#include <hpc/mem/unaligned.h>
+#include "internal.h"
+
+void gcm_init_ct64(u128 Htable[16], const uint64_t H[2]);
+void gcm_gmult_ct64(uint8_t Xi[16], const u128 Htable[16]);
+void gcm_ghash_ct64(uint8_t Xi[16], const u128 Htable[16],
+		    const uint8_t *inp, size_t len);
+
+static inline uint64_t
+bmul64(uint64_t x, uint64_t y)
+{
+	uint64_t x0, x1, x2, x3;
+	uint64_t y0, y1, y2, y3;
+	uint64_t z0, z1, z2, z3;
+
+	x0 = x & (uint64_t)0x1111111111111111;
+	x1 = x & (uint64_t)0x2222222222222222;
+	x2 = x & (uint64_t)0x4444444444444444;
+	x3 = x & (uint64_t)0x8888888888888888;
+	y0 = y & (uint64_t)0x1111111111111111;
+	y1 = y & (uint64_t)0x2222222222222222;
+	y2 = y & (uint64_t)0x4444444444444444;
+	y3 = y & (uint64_t)0x8888888888888888;
+	z0 = (x0 * y0) ^ (x1 * y3) ^ (x2 * y2) ^ (x3 * y1);
+	z1 = (x0 * y1) ^ (x1 * y0) ^ (x2 * y3) ^ (x3 * y2);
+	z2 = (x0 * y2) ^ (x1 * y1) ^ (x2 * y0) ^ (x3 * y3);
+	z3 = (x0 * y3) ^ (x1 * y2) ^ (x2 * y1) ^ (x3 * y0);
+	z0 &= (uint64_t)0x1111111111111111;
+	z1 &= (uint64_t)0x2222222222222222;
+	z2 &= (uint64_t)0x4444444444444444;
+	z3 &= (uint64_t)0x8888888888888888;
+	return z0 | z1 | z2 | z3;
+}
+
+static inline uint64_t
+rev64(uint64_t x)
+{
+#define RMS(m, s) \
+	x = ((x & (uint64_t)(m)) << (s)) | ((x >> (s)) & (uint64_t)(m))
+	RMS(0x5555555555555555, 1);
+	RMS(0x3333333333333333, 2);
+	RMS(0x0F0F0F0F0F0F0F0F, 4);
+	RMS(0x00FF00FF00FF00FF, 8);
+	RMS(0x0000FFFF0000FFFF, 16);
+#undef RMS
+	return (x << 32) | (x >> 32);
+}
+
+void
+gcm_init_ct64(u128 Htable[16], const uint64_t H[2])
+{
+	Htable[0].hi = H[0];
+	Htable[0].lo = H[1];
+	Htable[1].hi = rev64(H[0]);
+	Htable[1].lo = rev64(H[1]);
+}
+
+void
+gcm_ghash_ct64(uint8_t Xi[16], const u128 Htable[16], const uint8_t *inp,
+	       size_t len)
+{
+	uint64_t y0, y1, h0, h1, h2, h0r, h1r, h2r;
+
+	y1 = get_u64_be(Xi);
+	y0 = get_u64_be(Xi + 8);
+	h1 = Htable[0].hi;
+	h0 = Htable[0].lo;
+	h1r = Htable[1].hi;
+	h0r = Htable[1].lo;
+	h2 = h0 ^ h1;
+	h2r = h0r ^ h1r;
+
+	for (len &= ~(size_t)15; len; len -= 16, inp += 16) {
+		uint64_t y0r, y1r, y2, y2r;
+		uint64_t z0, z1, z2, z0h, z1h, z2h;
+		uint64_t v0, v1, v2, v3;
+
+		y1 ^= get_u64_be(inp);
+		y0 ^= get_u64_be(inp + 8);
+
+		y0r = rev64(y0);
+		y1r = rev64(y1);
+		y2 = y0 ^ y1;
+		y2r = y0r ^ y1r;
+
+		z0 = bmul64(y0, h0);
+		z1 = bmul64(y1, h1);
+		z2 = bmul64(y2, h2);
+		z0h = bmul64(y0r, h0r);
+		z1h = bmul64(y1r, h1r);
+		z2h = bmul64(y2r, h2r);
+		z2 ^= z0 ^ z1;
+		z2h ^= z0h ^ z1h;
+		z0h = rev64(z0h) >> 1;
+		z1h = rev64(z1h) >> 1;
+		z2h = rev64(z2h) >> 1;
+
+		v0 = z0;
+		v1 = z0h ^ z2;
+		v2 = z1 ^ z2h;
+		v3 = z1h;
+
+		/* GHASH is bit-reflected: shift the 256-bit product, reduce. */
+		v3 = (v3 << 1) | (v2 >> 63);
+		v2 = (v2 << 1) | (v1 >> 63);
+		v1 = (v1 << 1) | (v0 >> 63);
+		v0 = (v0 << 1);
+
+		v2 ^= v0 ^ (v0 >> 1) ^ (v0 >> 2) ^ (v0 >> 7);
+		v1 ^= (v0 << 63) ^ (v0 << 62) ^ (v0 << 57);
+		v3 ^= v1 ^ (v1 >> 1) ^ (v1 >> 2) ^ (v1 >> 7);
+		v2 ^= (v1 << 63) ^ (v1 << 62) ^ (v1 << 57);
+
+		y0 = v2;
+		y1 = v3;
+	}
+
+	put_u64_be(Xi, y1);
+	put_u64_be(Xi + 8, y0);
+}
+
+void
+gcm_gmult_ct64(uint8_t Xi[16], const u128 Htable[16])
+{
+	static const uint8_t zero[16];
+
+	gcm_ghash_ct64(Xi, Htable, zero, 16);
+}
@@ -0,0 +1,4 @@
+/* AES cipher registration is backend-independent (it only uses the AES
+ * free-function API), so the constant-time bitsliced backend reuses the
+ * canonical registration glue verbatim. */
+#include "../aes/module.c"
@@ -240,7 +240,7 @@ aes128_cbc_init_ctx_iv(struct aes128_ctx* ctx, const u8* key, const u8* iv)
 	memcpy (ctx->Iv, iv, AES_BLOCKLEN);
 }
 
-void aes128_set_iv(struct aes128_ctx* ctx, const u8* iv)
+void aes128_cbc_set_iv(struct aes128_ctx* ctx, const u8* iv)
 {
 	memcpy (ctx->Iv, iv, AES_BLOCKLEN);
 }
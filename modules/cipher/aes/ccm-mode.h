@@ -0,0 +1,198 @@
+/*
+ * AES-CCM (NIST SP800-38C, RFC 3610) over one block cipher call, shared by
+ * the generic backend (ccm.c) and the aes_hw_* glue (../aes-aws/ccm-aws.c).
+ * See the contract in <crypto/cipher/aes.h>. Included after the backend
+ * defines its keyed state and block function:
+ *
+ *   CCM_KEY               key struct, with an unsigned int tag_len member
+ *   CCM_BLOCK(k, in, out) one AES block encryption under CCM_KEY *k
+ *
+ * aes_ccm_setkey, which fills in the key, stays with the backend.
+ *
+ * CCM runs two AES chains over every payload block: the serial CBC-MAC and
+ * the CTR keystream. The payload loop issues the MAC block for block i and
+ * the counter block for block i + 1 back to back. The two have no data
+ * dependency, so with an AES instruction the out-of-order core overlaps them
+ * and the keystream comes for free under the MAC chain's latency instead of
+ * doubling it; on the table code nothing is gained, and nothing lost. On
+ * decrypt the keystream is therefore always one block ahead of the MAC, which
+ * needs the plaintext.
+ */
+
+/* XOR |len| bytes into the CBC-MAC state at |*pos|, encrypting full blocks. */
+static void
+ccm_mac_bytes(CCM_KEY *k, u8 mac[AES_BLOCKLEN], unsigned int *pos,
+	      const u8 *p, size_t len)
+{
+	while (len--) {
+		mac[(*pos)++] ^= *p++;
+		if (*pos == AES_BLOCKLEN) {
+			CCM_BLOCK(k, mac, mac);
+			*pos = 0;
+		}
+	}
+}
+
+/*
+ * B0 and the associated data with its length prefix (SP800-38C A.2.2: two
+ * bytes below 2^16 - 2^8, 0xff 0xfe and four bytes below 2^32, 0xff 0xff and
+ * eight bytes above), leaving the MAC state block-aligned for the payload;
+ * also returns counter block A0 in |ctr|.
+ */
+static int
+ccm_start(CCM_KEY *k, u8 mac[AES_BLOCKLEN], u8 ctr[AES_BLOCKLEN],
+	  const u8 *nonce, size_t nonce_len, const u8 *aad, size_t aad_len,
+	  size_t len)
+{
+	unsigned int L, i, pos = 0;
+	u8 hdr[10];
+
+	if (nonce_len < 7 || nonce_len > 13)
+		return -1;
+	L = 15 - (unsigned int)nonce_len;
+	if (L < sizeof(size_t) && (len >> (8 * L)))
+		return -1;
+
+	mac[0] = (u8)((aad_len ? 0x40 : 0) |
+		      ((k->tag_len - 2) / 2) << 3 | (L - 1));
+	memcpy(mac + 1, nonce, nonce_len);
+	for (i = 0; i < L; i++)
+		mac[15 - i] = (u8)(len >> (8 * i));
+	CCM_BLOCK(k, mac, mac);
+
+	if (aad_len) {
+		if (aad_len < 0xff00) {
+			hdr[0] = (u8)(aad_len >> 8);
+			hdr[1] = (u8)aad_len;
+			ccm_mac_bytes(k, mac, &pos, hdr, 2);
+		} else if (!((u64)aad_len >> 32)) {
+			hdr[0] = 0xff;
+			hdr[1] = 0xfe;
+			put_u32_be(hdr + 2, (u32)aad_len);
+			ccm_mac_bytes(k, mac, &pos, hdr, 6);
+		} else {
+			hdr[0] = 0xff;
+			hdr[1] = 0xff;
+			put_u64_be(hdr + 2, (u64)aad_len);
+			ccm_mac_bytes(k, mac, &pos, hdr, 10);
+		}
+		ccm_mac_bytes(k, mac, &pos, aad, aad_len);
+		if (pos)
+			CCM_BLOCK(k, mac, mac);
+	}
+
+	memset(ctr, 0, AES_BLOCKLEN);
+	ctr[0] = (u8)(L - 1);
+	memcpy(ctr + 1, nonce, nonce_len);
+	return 0;
+}
+
+/* The counter field is at least 2 bytes and never wraps for a valid length,
+ * so bumping the trailing word is enough. */
+static inline void
+ccm_ctr_inc(u8 ctr[AES_BLOCKLEN])
+{
+	put_u32_be(ctr + 12, get_u32_be(ctr + 12) + 1);
+}
+
+/* CTR-encrypt |len| payload bytes from counter 1 and fold the plaintext into
+ * the MAC, pipelining the two chains as described at the top. */
+static void
+ccm_crypt(CCM_KEY *k, u8 mac[AES_BLOCKLEN], u8 ctr[AES_BLOCKLEN],
+	  const u8 *in, u8 *out, size_t len, int enc)
+{
+	u8 pad[AES_BLOCKLEN];
+	unsigned int i;
+
+	if (!len)
+		return;
+	ccm_ctr_inc(ctr);
+	CCM_BLOCK(k, ctr, pad);
+
+	for (; len >= AES_BLOCKLEN; len -= AES_BLOCKLEN) {
+		for (i = 0; i < AES_BLOCKLEN; i++) {
+			u8 p = enc ? in[i] : in[i] ^ pad[i];
+
+			out[i] = in[i] ^ pad[i];
+			mac[i] ^= p;
+		}
+		in += AES_BLOCKLEN;
+		out += AES_BLOCKLEN;
+
+		CCM_BLOCK(k, mac, mac);
+		if (len > AES_BLOCKLEN) {
+			ccm_ctr_inc(ctr);
+			CCM_BLOCK(k, ctr, pad);
+		}
+	}
+
+	if (len) {
+		for (i = 0; i < len; i++) {
+			u8 p = enc ? in[i] : in[i] ^ pad[i];
+
+			out[i] = in[i] ^ pad[i];
+			mac[i] ^= p;
+		}
+		CCM_BLOCK(k, mac, mac);
+	}
+}
+
+/* MAC ^ E(A0), truncated to the tag length by the caller. */
+static void
+ccm_tag(CCM_KEY *k, u8 mac[AES_BLOCKLEN], const u8 a0[AES_BLOCKLEN])
+{
+	u8 s0[AES_BLOCKLEN];
+	unsigned int i;
+
+	CCM_BLOCK(k, a0, s0);
+	for (i = 0; i < AES_BLOCKLEN; i++)
+		mac[i] ^= s0[i];
+}
+
+int
+aes_ccm_seal(struct aes_ccm_key *ccm, u8 *output, const u8 *input,
+	     int input_length, const u8 *nonce, size_t nonce_len,
+	     const u8 *aad, size_t aad_len)
+{
+	CCM_KEY *k = (CCM_KEY *)ccm;
+	u8 mac[AES_BLOCKLEN], ctr[AES_BLOCKLEN], a0[AES_BLOCKLEN];
+	size_t len = (size_t)input_length;
+
+	if (input_length < 0 ||
+	    ccm_start(k, mac, ctr, nonce, nonce_len, aad, aad_len, len))
+		return -1;
+	memcpy(a0, ctr, AES_BLOCKLEN);
+	ccm_crypt(k, mac, ctr, input, output, len, 1);
+	ccm_tag(k, mac, a0);
+	memcpy(output + len, mac, k->tag_len);
+	return 0;
+}
+
+int
+aes_ccm_open(struct aes_ccm_key *ccm, u8 *output, const u8 *input,
+	     int input_length, const u8 *nonce, size_t nonce_len,
+	     const u8 *aad, size_t aad_len)
+{
+	CCM_KEY *k = (CCM_KEY *)ccm;
+	u8 mac[AES_BLOCKLEN], ctr[AES_BLOCKLEN], a0[AES_BLOCKLEN];
+	u8 diff = 0;
+	size_t len;
+	unsigned int i;
+
+	if (input_length < (int)k->tag_len)
+		return -1;
+	len = (size_t)input_length - k->tag_len;
+	if (ccm_start(k, mac, ctr, nonce, nonce_len, aad, aad_len, len))
+		return -1;
+	memcpy(a0, ctr, AES_BLOCKLEN);
+	ccm_crypt(k, mac, ctr, input, output, len, 0);
+	ccm_tag(k, mac, a0);
+
+	for (i = 0; i < k->tag_len; i++)
+		diff |= mac[i] ^ input[len + i];
+	if (diff) {
+		memset(output, 0, len);
+		return -1;
+	}
+	return 0;
+}
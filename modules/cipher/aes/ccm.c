@@ -0,0 +1,36 @@
+/*
+ * AES-CCM (NIST SP800-38C, RFC 3610) over the table-based block cipher in
+ * gcm.c. See the contract in <crypto/cipher/aes.h>; the mode is ccm-mode.h,
+ * shared with the accelerated glue (aes-aws/ccm-aws.c).
+ */
+#include <string.h>
+#include <hpc/mem/unaligned.h>
+#include <crypto/cipher/aes.h>
+#include <crypto/cipher/aes/gcm.h>
+
+struct generic_aes_ccm_key {
+	aes_context aes;
+	unsigned int tag_len;
+};
+
+_Static_assert(sizeof(struct generic_aes_ccm_key) <= sizeof(struct aes_ccm_key),
+	       "generic AES-CCM state does not fit in struct aes_ccm_key");
+
+int
+aes_ccm_setkey(struct aes_ccm_key *ccm, const u8 *key, size_t key_len,
+	       size_t tag_len)
+{
+	struct generic_aes_ccm_key *k = (struct generic_aes_ccm_key *)ccm;
+
+	memset(k, 0, sizeof(*k));
+	if (key_len != 16 && key_len != 24 && key_len != 32)
+		return -1;
+	if (tag_len < 4 || tag_len > 16 || (tag_len & 1))
+		return -1;
+	k->tag_len = (unsigned int)tag_len;
+	return aes_setkey(&k->aes, ENCRYPT, key, (uint)key_len);
+}
+
+#define CCM_KEY struct generic_aes_ccm_key
+#define CCM_BLOCK(k, in, out) aes_cipher(&(k)->aes, in, out)
+#include "ccm-mode.h"
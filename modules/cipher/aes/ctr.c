@@ -0,0 +1,77 @@
+/*
+ * AES-CTR (NIST SP800-38A) over the table-based block cipher in gcm.c. See
+ * the contract in <crypto/cipher/aes.h>: a 128-bit big-endian counter block,
+ * with the unused tail of the last keystream block carried across calls.
+ */
+#include <string.h>
+#include <crypto/cipher/aes.h>
+#include <crypto/cipher/aes/gcm.h>
+
+struct generic_aes_ctr {
+	aes_context aes;
+	u8 ctr[AES_BLOCKLEN];
+	u8 ks[AES_BLOCKLEN];
+	unsigned int num;	/* bytes of ks[] used, 0 when none is left */
+};
+
+_Static_assert(sizeof(struct generic_aes_ctr) <= sizeof(struct aes_ctr_ctx),
+	       "generic AES-CTR state does not fit in struct aes_ctr_ctx");
+
+static inline void
+ctr128_inc(u8 ctr[AES_BLOCKLEN])
+{
+	unsigned int i = AES_BLOCKLEN, carry = 1;
+
+	while (i--) {
+		carry += ctr[i];
+		ctr[i] = (u8)carry;
+		carry >>= 8;
+	}
+}
+
+int
+aes_ctr_setkey(struct aes_ctr_ctx *ctx, const u8 *key, size_t key_len)
+{
+	struct generic_aes_ctr *c = (struct generic_aes_ctr *)ctx;
+
+	memset(c, 0, sizeof(*c));
+	return aes_setkey(&c->aes, ENCRYPT, key, (uint)key_len);
+}
+
+void
+aes_ctr_set_iv(struct aes_ctr_ctx *ctx, const u8 iv[AES_BLOCKLEN])
+{
+	struct generic_aes_ctr *c = (struct generic_aes_ctr *)ctx;
+
+	memcpy(c->ctr, iv, AES_BLOCKLEN);
+	c->num = 0;
+}
+
+void
+aes_ctr_crypt(struct aes_ctr_ctx *ctx, const u8 *in, u8 *out, size_t len)
+{
+	struct generic_aes_ctr *c = (struct generic_aes_ctr *)ctx;
+	unsigned int i;
+
+	for (; len && c->num; len--) {
+		*out++ = *in++ ^ c->ks[c->num];
+		c->num = (c->num + 1) % AES_BLOCKLEN;
+	}
+
+	for (; len >= AES_BLOCKLEN; len -= AES_BLOCKLEN) {
+		aes_cipher(&c->aes, c->ctr, c->ks);
+		ctr128_inc(c->ctr);
+		for (i = 0; i < AES_BLOCKLEN; i++)
+			out[i] = in[i] ^ c->ks[i];
+		in += AES_BLOCKLEN;
+		out += AES_BLOCKLEN;
+	}
+
+	if (len) {
+		aes_cipher(&c->aes, c->ctr, c->ks);
+		ctr128_inc(c->ctr);
+		for (i = 0; i < len; i++)
+			out[i] = in[i] ^ c->ks[i];
+		c->num = (unsigned int)len;
+	}
+}
@@ -24,6 +24,7 @@
 #include <hpc/compiler.h>
 #include <stddef.h>
 #include <string.h>
+#include <crypto/cipher/aes.h>
 #include <crypto/cipher/aes/gcm.h>
 
 /******************************************************************************
@@ -973,24 +974,212 @@ void gcm_zero_ctx(gcm_context *ctx)
 /*
  * AEAD front-ends: encrypt appends a 16-byte tag after the ciphertext;
  * decrypt expects that tag trailing the ciphertext and verifies it. See the
- * contract in <crypto/cipher/aes/gcm.h>. No associated data is authenticated.
+ * contract in <crypto/cipher/aes/gcm.h>. The one-shot pair authenticates no
+ * associated data; the keyed seal/open pass theirs to GCM_START.
+ *
+ * The keyed variants keep the whole gcm_context (AES round keys and the
+ * HL/HH tables) in struct aes_gcm_key, so GCM_SETKEY runs once per key
+ * rather than once per record.
  */
 #define AES_GCM_TAG_LEN 16
 
+_Static_assert(sizeof(gcm_context) <= sizeof(struct aes_gcm_key),
+               "gcm_context does not fit in struct aes_gcm_key");
+
+int aes_gcm_setkey(struct aes_gcm_key *gcm, const u8 *key, size_t key_len)
+{
+    return( gcm_setkey( (gcm_context *)gcm, key, (const uint)key_len ) );
+}
+
+int aes_gcm_setkey_batch(struct aes_gcm_key *const *gcm, const u8 *const *key,
+                         size_t key_len, unsigned int n)
+{
+    unsigned int i;
+
+    for( i = 0; i < n; i++ )
+        if( gcm_setkey( (gcm_context *)gcm[i], key[i], (const uint)key_len ) )
+            return( -1 );
+    return( 0 );
+}
+
+int aes_gcm_setkey_bulk(struct aes_gcm_key *gcm, const u8 *key,
+                        size_t key_len, enum aes_gcm_bulk bulk)
+{
+    if( bulk != AES_GCM_BULK_BEST && bulk != AES_GCM_BULK_GHASH )
+        return( -1 );
+    return( aes_gcm_setkey( gcm, key, key_len ) );
+}
+
+size_t aes_gcm_key_size( void )
+{
+    return( sizeof( gcm_context ) );
+}
+
+int aes_gcm_seal(struct aes_gcm_key *gcm, u8 *output, const u8 *input,
+         int input_length, const u8 *iv, size_t iv_len,
+         const u8 *aad, size_t aad_len)
+{
+    if( input_length < 0 )
+        return( -1 );
+    return( gcm_crypt_and_tag( (gcm_context *)gcm, ENCRYPT, iv, iv_len,
+                               aad, aad_len, input, output, input_length,
+                               output + input_length, AES_GCM_TAG_LEN ) );
+}
+
+int aes_gcm_open(struct aes_gcm_key *gcm, u8 *output, const u8 *input,
+         int input_length, const u8 *iv, size_t iv_len,
+         const u8 *aad, size_t aad_len)
+{
+    int ct_len = input_length - AES_GCM_TAG_LEN;
+
+    if ( ct_len < 0 )           // must carry at least a full tag
+        return( GCM_AUTH_FAILURE );
+
+    return( gcm_auth_decrypt( (gcm_context *)gcm, iv, iv_len, aad, aad_len,
+                              input, output, ct_len,
+                              input + ct_len, AES_GCM_TAG_LEN ) );
+}
+
+/*
+ * TLS 1.2 explicit nonce: salt || explicit_nonce, big-endian. The table-based
+ * GCM_START wants the IV in memory, so it is assembled on the stack here.
+ */
+static void gcm_explicit_iv( uchar iv[12], u32 salt, u64 explicit_nonce )
+{
+    PUT_UINT32_BE( salt, iv, 0 );
+    PUT_UINT32_BE( (uint32_t)( explicit_nonce >> 32 ), iv, 4 );
+    PUT_UINT32_BE( (uint32_t)( explicit_nonce       ), iv, 8 );
+}
+
+int aes_gcm_seal_explicit(struct aes_gcm_key *gcm, u8 *output,
+         const u8 *input, int input_length, u32 salt, u64 explicit_nonce,
+         const u8 *aad, size_t aad_len)
+{
+    uchar iv[12];
+
+    if( input_length < 0 )
+        return( -1 );
+    gcm_explicit_iv( iv, salt, explicit_nonce );
+    return( aes_gcm_seal( gcm, output, input, input_length, iv, 12,
+                          aad, aad_len ) );
+}
+
+int aes_gcm_open_explicit(struct aes_gcm_key *gcm, u8 *output,
+         const u8 *input, int input_length, u32 salt, u64 explicit_nonce,
+         const u8 *aad, size_t aad_len)
+{
+    uchar iv[12];
+
+    gcm_explicit_iv( iv, salt, explicit_nonce );
+    return( aes_gcm_open( gcm, output, input, input_length, iv, 12,
+                          aad, aad_len ) );
+}
+
+/*
+ * Streaming front-end over GCM_START / GCM_FINISH. GCM_UPDATE wants every
+ * piece but the last to be a whole number of blocks, so the update step is
+ * done here byte-wise instead: the keystream block for the current counter
+ * is kept in the stream and the ciphertext is folded into the context's
+ * GHASH buffer as it goes, letting a piece end anywhere.
+ */
+typedef struct {
+    gcm_context *ctx;       // the keyed context, running this record
+    uchar ectr[16];         // keystream for the current counter block
+    uint num;               // bytes of ectr used, 0 when block-aligned
+} gcm_stream;
+
+_Static_assert(sizeof(gcm_stream) <= sizeof(struct aes_gcm_stream),
+               "gcm_stream does not fit in struct aes_gcm_stream");
+
+int aes_gcm_stream_init(struct aes_gcm_stream *stream, struct aes_gcm_key *gcm,
+         int enc, const u8 *iv, size_t iv_len, const u8 *aad, size_t aad_len)
+{
+    gcm_stream *st = (gcm_stream *)stream;
+
+    st->ctx = (gcm_context *)gcm;
+    st->num = 0;
+    return( gcm_start( st->ctx, enc ? ENCRYPT : DECRYPT, iv, iv_len,
+                       aad, aad_len ) );
+}
+
+void aes_gcm_stream_update(struct aes_gcm_stream *stream, const u8 *in,
+         u8 *out, size_t len)
+{
+    gcm_stream *st = (gcm_stream *)stream;
+    gcm_context *ctx = st->ctx;
+    uchar c;                // the ciphertext byte that goes into GHASH
+    size_t i;
+
+    ctx->len += len;
+    while( len-- > 0 ) {
+        if( st->num == 0 ) {
+            // next counter block, exactly as GCM_UPDATE does it
+            for( i = 16; i > 12; i-- ) if( ++ctx->y[i - 1] != 0 ) break;
+            aes_cipher( &ctx->aes_ctx, ctx->y, st->ectr );
+        }
+        // read the input before writing: |out| may alias |in|
+        c = ( ctx->mode == ENCRYPT ) ? (uchar)( *in ^ st->ectr[st->num] )
+                                     : *in;
+        *out++ = (uchar)( *in++ ^ st->ectr[st->num] );
+        ctx->buf[st->num] ^= c;
+        if( ++st->num == 16 ) {
+            gcm_mult( ctx, ctx->buf, ctx->buf );
+            st->num = 0;
+        }
+    }
+}
+
+int aes_gcm_stream_final(struct aes_gcm_stream *stream, u8 tag[16])
+{
+    gcm_stream *st = (gcm_stream *)stream;
+    gcm_context *ctx = st->ctx;
+    uchar check_tag[16];
+    int diff = 0;
+    size_t i;
+
+    if( st->num != 0 )      // the last block was partial: GHASH it now
+        gcm_mult( ctx, ctx->buf, ctx->buf );
+    gcm_finish( ctx, check_tag, AES_GCM_TAG_LEN );
+
+    if( ctx->mode == ENCRYPT )
+        memcpy( tag, check_tag, AES_GCM_TAG_LEN );
+    else                    // verify in 'constant time'
+        for( i = 0; i < AES_GCM_TAG_LEN; i++ )
+            diff |= tag[i] ^ check_tag[i];
+
+    memset( st, 0, sizeof( *st ) );
+    return( diff ? GCM_AUTH_FAILURE : 0 );
+}
+
+unsigned int aes_gcm_open_mb(struct aes_gcm_mb *rec, unsigned int n)
+{
+    unsigned int i, failed = 0;
+
+    // no interleaving here: one record after the other
+    for( i = 0; i < n; i++ ) {
+        rec[i].status = gcm_auth_decrypt( (gcm_context *)rec[i].key,
+                                          rec[i].iv, 12,
+                                          rec[i].aad, rec[i].aad_len,
+                                          rec[i].in, rec[i].out, rec[i].len,
+                                          rec[i].tag, AES_GCM_TAG_LEN );
+        if( rec[i].status )
+            failed++;
+    }
+    return( failed );
+}
+
 int aes_gcm_encrypt(u8 *output, const u8 *input, int input_length,
          const u8* key, const size_t key_len, const u8 *iv, const size_t iv_len)
 {
 
     int ret = 0;                // our return value
-    gcm_context ctx;            // includes the AES context structure
+    struct aes_gcm_key gcm;     // includes the gcm and AES context structures
 
-    gcm_setkey( &ctx, key, (const uint)key_len );
+    aes_gcm_setkey( &gcm, key, key_len );
+    ret = aes_gcm_seal( &gcm, output, input, input_length, iv, iv_len,
+                        NULL, 0 );
 
-    ret = gcm_crypt_and_tag( &ctx, ENCRYPT, iv, iv_len, NULL, 0,
-                            input, output, input_length,
-                            output + input_length, AES_GCM_TAG_LEN );
-
-    gcm_zero_ctx( &ctx );
+    gcm_zero_ctx( (gcm_context *)&gcm );
     return( ret );
 }
 
@@ -1000,19 +1189,16 @@ aes_gcm_decrypt(u8 * output, const u8 *input, int input_length,
 {
 
     int ret = 0;                // our return value
-    gcm_context ctx;            // includes the AES context structure
-    int ct_len = input_length - AES_GCM_TAG_LEN;
+    struct aes_gcm_key gcm;     // includes the gcm and AES context structures
 
-    if ( ct_len < 0 )           // must carry at least a full tag
+    if ( input_length < AES_GCM_TAG_LEN )   // must carry at least a full tag
         return( GCM_AUTH_FAILURE );
 
-    gcm_setkey( &ctx, key, (const uint)key_len );
-
-    ret = gcm_auth_decrypt( &ctx, iv, iv_len, NULL, 0,
-                            input, output, ct_len,
-                            input + ct_len, AES_GCM_TAG_LEN );
+    aes_gcm_setkey( &gcm, key, key_len );
+    ret = aes_gcm_open( &gcm, output, input, input_length, iv, iv_len,
+                        NULL, 0 );
 
-    gcm_zero_ctx( &ctx );
+    gcm_zero_ctx( (gcm_context *)&gcm );
     return( ret );
 
 }
@@ -1,15 +1,18 @@
 #define __CRYPTO_CIPHER_MODULE__
+#include <stddef.h>
 #include <string.h>
+#include <hpc/mem/unaligned.h>
 #include <crypto/cipher.h>
 #include <crypto/cipher/aes.h>
 #include <crypto/cipher/aes/gcm.h>
 
-/* AES-128/256-CBC */
+/* AES-128/256-CBC: the context is the expanded key schedules and the
+ * chaining IV only; the raw key is not kept once it is expanded. */
+
+static const u8 aes_cbc_zero_key[AES256_KEYLEN];
 
 struct cipher_aes128_cbc {
 	struct aes128_ctx ctx;
-	u8 key[AES128_KEYLEN];
-	unsigned int key_len;
 };
 
 _Static_assert(sizeof(struct cipher_aes128_cbc) <= CIPHER_CTXT_SIZE_MAX,
@@ -25,12 +28,11 @@ aes128_cbc_algorithm_init(struct cipher *cipher,
 
 	(void)mac; (void)mac_len; (void)iv_len;
 	memset(c, 0, sizeof(*c));
-	if (key && key_len == AES128_KEYLEN) {
-		memcpy(c->key, key, key_len);
-		c->key_len = key_len;
-	}
+	if (!key || key_len != AES128_KEYLEN)
+		key = aes_cbc_zero_key;
+	aes128_cbc_init(&c->ctx, key);
 	if (iv)
-		aes128_cbc_init_ctx_iv(&c->ctx, c->key, iv);
+		aes128_cbc_set_iv(&c->ctx, iv);
 }
 
 static void
@@ -41,8 +43,7 @@ aes128_cbc_algorithm_set_key(struct cipher *cipher, const u8 *key,
 
 	if (len != AES128_KEYLEN)
 		return;
-	memcpy(c->key, key, len);
-	c->key_len = len;
+	aes128_cbc_init(&c->ctx, key);
 }
 
 static void
@@ -52,7 +53,7 @@ aes128_cbc_algorithm_set_iv(struct cipher *cipher, const u8 *iv,
 	struct cipher_aes128_cbc *c = (struct cipher_aes128_cbc *)cipher;
 
 	(void)len;
-	aes128_cbc_init_ctx_iv(&c->ctx, c->key, iv);
+	aes128_cbc_set_iv(&c->ctx, iv);
 }
 
 static void
@@ -77,22 +78,24 @@ aes128_cbc_algorithm_encrypt(struct cipher *cipher, const u8 *msg,
 	*out_len = len;
 }
 
-static void
+static int
 aes128_cbc_algorithm_decrypt_inplace(struct cipher *cipher, u8 *msg,
 				     unsigned int len)
 {
 	struct cipher_aes128_cbc *c = (struct cipher_aes128_cbc *)cipher;
 
 	aes128_cbc_decrypt(&c->ctx, msg, len);
+	return 0;
 }
 
-static void
+static int
 aes128_cbc_algorithm_encrypt_inplace(struct cipher *cipher, u8 *msg,
 				     unsigned int len)
 {
 	struct cipher_aes128_cbc *c = (struct cipher_aes128_cbc *)cipher;
 
 	aes128_cbc_encrypt(&c->ctx, msg, len);
+	return 0;
 }
 
 static struct cipher_algorithm aes128_cbc_algorithm = {
@@ -117,8 +120,6 @@ static struct cipher_algorithm aes128_cbc_algorithm = {
 
 struct cipher_aes256_cbc {
 	struct aes256_ctx ctx;
-	u8 key[AES256_KEYLEN];
-	unsigned int key_len;
 };
 
 _Static_assert(sizeof(struct cipher_aes256_cbc) <= CIPHER_CTXT_SIZE_MAX,
@@ -134,12 +135,11 @@ aes256_cbc_algorithm_init(struct cipher *cipher,
 
 	(void)mac; (void)mac_len; (void)iv_len;
 	memset(c, 0, sizeof(*c));
-	if (key && key_len == AES256_KEYLEN) {
-		memcpy(c->key, key, key_len);
-		c->key_len = key_len;
-	}
+	if (!key || key_len != AES256_KEYLEN)
+		key = aes_cbc_zero_key;
+	aes256_cbc_init(&c->ctx, key);
 	if (iv)
-		aes256_cbc_init_ctx_iv(&c->ctx, c->key, iv);
+		aes256_cbc_set_iv(&c->ctx, iv);
 }
 
 static void
@@ -150,8 +150,7 @@ aes256_cbc_algorithm_set_key(struct cipher *cipher, const u8 *key,
 
 	if (len != AES256_KEYLEN)
 		return;
-	memcpy(c->key, key, len);
-	c->key_len = len;
+	aes256_cbc_init(&c->ctx, key);
 }
 
 static void
@@ -161,7 +160,7 @@ aes256_cbc_algorithm_set_iv(struct cipher *cipher, const u8 *iv,
 	struct cipher_aes256_cbc *c = (struct cipher_aes256_cbc *)cipher;
 
 	(void)len;
-	aes256_cbc_init_ctx_iv(&c->ctx, c->key, iv);
+	aes256_cbc_set_iv(&c->ctx, iv);
 }
 
 static void
@@ -186,22 +185,24 @@ aes256_cbc_algorithm_encrypt(struct cipher *cipher, const u8 *msg,
 	*out_len = len;
 }
 
-static void
+static int
 aes256_cbc_algorithm_decrypt_inplace(struct cipher *cipher, u8 *msg,
 				     unsigned int len)
 {
 	struct cipher_aes256_cbc *c = (struct cipher_aes256_cbc *)cipher;
 
 	aes256_cbc_decrypt(&c->ctx, msg, len);
+	return 0;
 }
 
-static void
+static int
 aes256_cbc_algorithm_encrypt_inplace(struct cipher *cipher, u8 *msg,
 				     unsigned int len)
 {
 	struct cipher_aes256_cbc *c = (struct cipher_aes256_cbc *)cipher;
 
 	aes256_cbc_encrypt(&c->ctx, msg, len);
+	return 0;
 }
 
 static struct cipher_algorithm aes256_cbc_algorithm = {
@@ -224,23 +225,347 @@ static struct cipher_algorithm aes256_cbc_algorithm = {
 	.encrypt_inplace = aes256_cbc_algorithm_encrypt_inplace,
 };
 
+/* AES-128/256-CTR (NIST SP800-38A): raw keystream over a 16-byte initial
+ * counter block, e.g. for QUIC header protection masks or SRTP payloads.
+ * encrypt and decrypt are the same XOR; consecutive calls continue one
+ * keystream at byte granularity until set_iv starts the next message. */
+
+struct cipher_aes_ctr {
+	struct aes_ctr_ctx ctx;
+};
+
+_Static_assert(sizeof(struct cipher_aes_ctr) <= CIPHER_CTXT_SIZE_MAX,
+	       "AES-CTR context is too large");
+
+static void
+aes_ctr_algorithm_init(struct cipher *cipher,
+		       const u8 *key, unsigned int key_len,
+		       const u8 *iv, unsigned int iv_len,
+		       const u8 *mac, unsigned int mac_len)
+{
+	struct cipher_aes_ctr *c = (struct cipher_aes_ctr *)cipher;
+
+	(void)mac; (void)mac_len;
+	memset(c, 0, sizeof(*c));
+	if (key)
+		aes_ctr_setkey(&c->ctx, key, key_len);
+	if (iv && iv_len == AES_BLOCKLEN)
+		aes_ctr_set_iv(&c->ctx, iv);
+}
+
+static void
+aes_ctr_algorithm_set_key(struct cipher *cipher, const u8 *key,
+			  unsigned int len)
+{
+	struct cipher_aes_ctr *c = (struct cipher_aes_ctr *)cipher;
+
+	aes_ctr_setkey(&c->ctx, key, len);
+}
+
+static void
+aes_ctr_algorithm_set_iv(struct cipher *cipher, const u8 *iv, unsigned int len)
+{
+	struct cipher_aes_ctr *c = (struct cipher_aes_ctr *)cipher;
+
+	if (len != AES_BLOCKLEN)
+		return;
+	aes_ctr_set_iv(&c->ctx, iv);
+}
+
+static void
+aes_ctr_algorithm_crypt(struct cipher *cipher, const u8 *msg,
+			unsigned int len, u8 *out, unsigned int *out_len)
+{
+	struct cipher_aes_ctr *c = (struct cipher_aes_ctr *)cipher;
+
+	aes_ctr_crypt(&c->ctx, msg, out, len);
+	*out_len = len;
+}
+
+static int
+aes_ctr_algorithm_crypt_inplace(struct cipher *cipher, u8 *msg,
+				unsigned int len)
+{
+	struct cipher_aes_ctr *c = (struct cipher_aes_ctr *)cipher;
+
+	aes_ctr_crypt(&c->ctx, msg, msg, len);
+	return 0;
+}
+
+static struct cipher_algorithm aes128_ctr_algorithm = {
+	.name = "aes-128-ctr",
+	.desc = "AES-128-CTR",
+	.id = C_AES128,
+	.mode = M_CTR,
+	.type = C_TYPE_STREAM,
+	.dialect = C_DIALECT_NONE,
+	.ctx_size = sizeof(struct cipher_aes_ctr),
+	.key_size = AES128_KEYLEN,
+	.block_size = AES_BLOCKLEN,
+	.iv_size = AES_BLOCKLEN,
+	.init = aes_ctr_algorithm_init,
+	.set_key = aes_ctr_algorithm_set_key,
+	.set_iv = aes_ctr_algorithm_set_iv,
+	.decrypt = aes_ctr_algorithm_crypt,
+	.encrypt = aes_ctr_algorithm_crypt,
+	.decrypt_inplace = aes_ctr_algorithm_crypt_inplace,
+	.encrypt_inplace = aes_ctr_algorithm_crypt_inplace,
+};
+
+static struct cipher_algorithm aes256_ctr_algorithm = {
+	.name = "aes-256-ctr",
+	.desc = "AES-256-CTR",
+	.id = C_AES256,
+	.mode = M_CTR,
+	.type = C_TYPE_STREAM,
+	.dialect = C_DIALECT_NONE,
+	.ctx_size = sizeof(struct cipher_aes_ctr),
+	.key_size = AES256_KEYLEN,
+	.block_size = AES_BLOCKLEN,
+	.iv_size = AES_BLOCKLEN,
+	.init = aes_ctr_algorithm_init,
+	.set_key = aes_ctr_algorithm_set_key,
+	.set_iv = aes_ctr_algorithm_set_iv,
+	.decrypt = aes_ctr_algorithm_crypt,
+	.encrypt = aes_ctr_algorithm_crypt,
+	.decrypt_inplace = aes_ctr_algorithm_crypt_inplace,
+	.encrypt_inplace = aes_ctr_algorithm_crypt_inplace,
+};
+
+/* AES-128/256-CCM and CCM_8 AEAD (RFC 3610, RFC 6655 / TLS 1.3
+ * AES_128_CCM[_8]): same framing as GCM below, with a 16- or 8-byte tag
+ * fixed by the algorithm. The key is expanded once in init/set_key. */
+
+#define AES_CCM_NONCE_MAX 13
+
+struct cipher_aes_ccm {
+	struct aes_ccm_key key;
+	u8 iv[AES_CCM_NONCE_MAX];
+	unsigned int iv_len;
+	unsigned int tag_len;
+};
+
+_Static_assert(sizeof(struct cipher_aes_ccm) <= CIPHER_CTXT_SIZE_MAX,
+	       "AES-CCM context is too large");
+
+static void
+aes_ccm_algorithm_setup(struct cipher *cipher, const u8 *key,
+			unsigned int key_len, const u8 *iv,
+			unsigned int iv_len, unsigned int tag_len)
+{
+	struct cipher_aes_ccm *c = (struct cipher_aes_ccm *)cipher;
+
+	memset(c, 0, sizeof(*c));
+	c->tag_len = tag_len;
+	if (key)
+		aes_ccm_setkey(&c->key, key, key_len, tag_len);
+	if (iv && iv_len <= AES_CCM_NONCE_MAX) {
+		memcpy(c->iv, iv, iv_len);
+		c->iv_len = iv_len;
+	}
+}
+
+static void
+aes_ccm_algorithm_init(struct cipher *cipher,
+		       const u8 *key, unsigned int key_len,
+		       const u8 *iv, unsigned int iv_len,
+		       const u8 *mac, unsigned int mac_len)
+{
+	(void)mac; (void)mac_len;
+	aes_ccm_algorithm_setup(cipher, key, key_len, iv, iv_len, 16);
+}
+
+static void
+aes_ccm8_algorithm_init(struct cipher *cipher,
+			const u8 *key, unsigned int key_len,
+			const u8 *iv, unsigned int iv_len,
+			const u8 *mac, unsigned int mac_len)
+{
+	(void)mac; (void)mac_len;
+	aes_ccm_algorithm_setup(cipher, key, key_len, iv, iv_len, 8);
+}
+
+static void
+aes_ccm_algorithm_set_key(struct cipher *cipher, const u8 *key,
+			  unsigned int len)
+{
+	struct cipher_aes_ccm *c = (struct cipher_aes_ccm *)cipher;
+
+	aes_ccm_setkey(&c->key, key, len, c->tag_len);
+}
+
+static void
+aes_ccm_algorithm_set_iv(struct cipher *cipher, const u8 *iv, unsigned int len)
+{
+	struct cipher_aes_ccm *c = (struct cipher_aes_ccm *)cipher;
+
+	if (len > AES_CCM_NONCE_MAX)
+		return;
+	memcpy(c->iv, iv, len);
+	c->iv_len = len;
+}
+
+static void
+aes_ccm_algorithm_open(struct cipher *cipher, const u8 *aad,
+		       unsigned int aad_len, const u8 *msg, unsigned int len,
+		       u8 *out, unsigned int *out_len)
+{
+	struct cipher_aes_ccm *c = (struct cipher_aes_ccm *)cipher;
+	int rv;
+
+	if (len < c->tag_len) {
+		*out_len = 0;
+		return;
+	}
+
+	rv = aes_ccm_open(&c->key, out, msg, (int)len, c->iv, c->iv_len,
+			  aad, aad_len);
+	*out_len = rv ? 0 : len - c->tag_len;
+}
+
+static void
+aes_ccm_algorithm_seal(struct cipher *cipher, const u8 *aad,
+		       unsigned int aad_len, const u8 *msg, unsigned int len,
+		       u8 *out, unsigned int *out_len)
+{
+	struct cipher_aes_ccm *c = (struct cipher_aes_ccm *)cipher;
+	int rv;
+
+	rv = aes_ccm_seal(&c->key, out, msg, (int)len, c->iv, c->iv_len,
+			  aad, aad_len);
+	*out_len = rv ? 0 : len + c->tag_len;
+}
+
+static void
+aes_ccm_algorithm_decrypt(struct cipher *cipher, const u8 *msg,
+			  unsigned int len, u8 *out, unsigned int *out_len)
+{
+	aes_ccm_algorithm_open(cipher, NULL, 0, msg, len, out, out_len);
+}
+
+static void
+aes_ccm_algorithm_encrypt(struct cipher *cipher, const u8 *msg,
+			  unsigned int len, u8 *out, unsigned int *out_len)
+{
+	aes_ccm_algorithm_seal(cipher, NULL, 0, msg, len, out, out_len);
+}
+
+static struct cipher_algorithm aes128_ccm_algorithm = {
+	.name = "aes-128-ccm",
+	.desc = "AES-128-CCM",
+	.id = C_AES128,
+	.mode = M_CCM,
+	.type = C_TYPE_AEAD,
+	.dialect = C_DIALECT_NONE,
+	.ctx_size = sizeof(struct cipher_aes_ccm),
+	.key_size = AES128_KEYLEN,
+	.block_size = AES_BLOCKLEN,
+	.iv_size = 12,
+	.mac_size = 16,
+	.init = aes_ccm_algorithm_init,
+	.set_key = aes_ccm_algorithm_set_key,
+	.set_iv = aes_ccm_algorithm_set_iv,
+	.decrypt = aes_ccm_algorithm_decrypt,
+	.encrypt = aes_ccm_algorithm_encrypt,
+	.open = aes_ccm_algorithm_open,
+	.seal = aes_ccm_algorithm_seal,
+};
+
+static struct cipher_algorithm aes128_ccm8_algorithm = {
+	.name = "aes-128-ccm-8",
+	.desc = "AES-128-CCM-8",
+	.id = C_AES128,
+	.mode = M_CCM_8,
+	.type = C_TYPE_AEAD,
+	.dialect = C_DIALECT_NONE,
+	.ctx_size = sizeof(struct cipher_aes_ccm),
+	.key_size = AES128_KEYLEN,
+	.block_size = AES_BLOCKLEN,
+	.iv_size = 12,
+	.mac_size = 8,
+	.init = aes_ccm8_algorithm_init,
+	.set_key = aes_ccm_algorithm_set_key,
+	.set_iv = aes_ccm_algorithm_set_iv,
+	.decrypt = aes_ccm_algorithm_decrypt,
+	.encrypt = aes_ccm_algorithm_encrypt,
+	.open = aes_ccm_algorithm_open,
+	.seal = aes_ccm_algorithm_seal,
+};
+
+static struct cipher_algorithm aes256_ccm_algorithm = {
+	.name = "aes-256-ccm",
+	.desc = "AES-256-CCM",
+	.id = C_AES256,
+	.mode = M_CCM,
+	.type = C_TYPE_AEAD,
+	.dialect = C_DIALECT_NONE,
+	.ctx_size = sizeof(struct cipher_aes_ccm),
+	.key_size = AES256_KEYLEN,
+	.block_size = AES_BLOCKLEN,
+	.iv_size = 12,
+	.mac_size = 16,
+	.init = aes_ccm_algorithm_init,
+	.set_key = aes_ccm_algorithm_set_key,
+	.set_iv = aes_ccm_algorithm_set_iv,
+	.decrypt = aes_ccm_algorithm_decrypt,
+	.encrypt = aes_ccm_algorithm_encrypt,
+	.open = aes_ccm_algorithm_open,
+	.seal = aes_ccm_algorithm_seal,
+};
+
+static struct cipher_algorithm aes256_ccm8_algorithm = {
+	.name = "aes-256-ccm-8",
+	.desc = "AES-256-CCM-8",
+	.id = C_AES256,
+	.mode = M_CCM_8,
+	.type = C_TYPE_AEAD,
+	.dialect = C_DIALECT_NONE,
+	.ctx_size = sizeof(struct cipher_aes_ccm),
+	.key_size = AES256_KEYLEN,
+	.block_size = AES_BLOCKLEN,
+	.iv_size = 12,
+	.mac_size = 8,
+	.init = aes_ccm8_algorithm_init,
+	.set_key = aes_ccm_algorithm_set_key,
+	.set_iv = aes_ccm_algorithm_set_iv,
+	.decrypt = aes_ccm_algorithm_decrypt,
+	.encrypt = aes_ccm_algorithm_encrypt,
+	.open = aes_ccm_algorithm_open,
+	.seal = aes_ccm_algorithm_seal,
+};
+
 /* AES-128/256-GCM AEAD (RFC 5116): encrypt appends the 16-byte tag to the
  * ciphertext, decrypt expects the tag trailing the ciphertext and verifies
- * it. No associated data is authenticated. Mirrors the ChaCha20-Poly1305
- * convention used elsewhere in this subsystem. */
+ * it. decrypt/encrypt authenticate no associated data; open/seal take the
+ * AAD (e.g. the TLS record header). Mirrors the ChaCha20-Poly1305 convention
+ * used elsewhere in this subsystem. The key is expanded once in
+ * init/set_key (struct aes_gcm_key); records only set the nonce, and TLS
+ * 1.2 records not even that: open/seal_explicit merge their explicit nonce
+ * with the 4-byte salt given as the IV at init.
+ *
+ * The nonce leads the context and the keyed state follows at the next
+ * aligned offset; ctx_size stops where the linked backend's state does
+ * (aes_gcm_key_size), so a compact per-flow context is the nonce line plus
+ * eight lines with the aws-lc backends rather than all of struct cipher. */
 
 #define AES_GCM_NONCE_MAX 16
 #define AES_GCM_TAG_LEN   16
+#define AES_GCM_SALT_LEN  4
 
 struct cipher_aes_gcm {
-	u8 key[AES256_KEYLEN];
 	u8 iv[AES_GCM_NONCE_MAX];
-	unsigned int key_len;
 	unsigned int iv_len;
+	u32 salt;		/* TLS 1.2 implicit nonce, from iv[0..3] */
+	struct aes_gcm_key key;
 };
 
 _Static_assert(sizeof(struct cipher_aes_gcm) <= CIPHER_CTXT_SIZE_MAX,
 	       "AES-GCM context is too large");
+_Static_assert(offsetof(struct cipher_aes_gcm, key) <= 64,
+	       "AES-GCM nonce spills past one cache line");
+
+/* Set from the backend at registration; never more than sizeof. */
+static unsigned int aes_gcm_ctx_size = sizeof(struct cipher_aes_gcm);
 
 static void
 aes_gcm_algorithm_init(struct cipher *cipher,
@@ -251,14 +576,14 @@ aes_gcm_algorithm_init(struct cipher *cipher,
 	struct cipher_aes_gcm *c = (struct cipher_aes_gcm *)cipher;
 
 	(void)mac; (void)mac_len;
-	memset(c, 0, sizeof(*c));
-	if (key && key_len <= AES256_KEYLEN) {
-		memcpy(c->key, key, key_len);
-		c->key_len = key_len;
-	}
+	memset(c, 0, aes_gcm_ctx_size);
+	if (key)
+		aes_gcm_setkey(&c->key, key, key_len);
 	if (iv && iv_len <= AES_GCM_NONCE_MAX) {
 		memcpy(c->iv, iv, iv_len);
 		c->iv_len = iv_len;
+		if (iv_len >= AES_GCM_SALT_LEN)
+			c->salt = get_u32_be(iv);
 	}
 }
 
@@ -268,10 +593,26 @@ aes_gcm_algorithm_set_key(struct cipher *cipher, const u8 *key,
 {
 	struct cipher_aes_gcm *c = (struct cipher_aes_gcm *)cipher;
 
-	if (len > AES256_KEYLEN)
-		return;
-	memcpy(c->key, key, len);
-	c->key_len = len;
+	aes_gcm_setkey(&c->key, key, len);
+}
+
+/* Keys per aes_gcm_setkey_batch call; the backend groups them further. */
+#define AES_GCM_KEY_BATCH 16
+
+static void
+aes_gcm_algorithm_set_key_batch(struct cipher *const *cipher,
+				const u8 *const *key, unsigned int len,
+				unsigned int n)
+{
+	struct aes_gcm_key *gcm[AES_GCM_KEY_BATCH];
+	unsigned int i, m;
+
+	for (; n; n -= m, cipher += m, key += m) {
+		m = n < AES_GCM_KEY_BATCH ? n : AES_GCM_KEY_BATCH;
+		for (i = 0; i < m; i++)
+			gcm[i] = &((struct cipher_aes_gcm *)cipher[i])->key;
+		aes_gcm_setkey_batch(gcm, key, len, m);
+	}
 }
 
 static void
@@ -283,11 +624,14 @@ aes_gcm_algorithm_set_iv(struct cipher *cipher, const u8 *iv, unsigned int len)
 		return;
 	memcpy(c->iv, iv, len);
 	c->iv_len = len;
+	if (len >= AES_GCM_SALT_LEN)
+		c->salt = get_u32_be(iv);
 }
 
 static void
-aes_gcm_algorithm_decrypt(struct cipher *cipher, const u8 *msg,
-			  unsigned int len, u8 *out, unsigned int *out_len)
+aes_gcm_algorithm_open(struct cipher *cipher, const u8 *aad,
+		       unsigned int aad_len, const u8 *msg, unsigned int len,
+		       u8 *out, unsigned int *out_len)
 {
 	struct cipher_aes_gcm *c = (struct cipher_aes_gcm *)cipher;
 	int rv;
@@ -297,23 +641,146 @@ aes_gcm_algorithm_decrypt(struct cipher *cipher, const u8 *msg,
 		return;
 	}
 
-	rv = aes_gcm_decrypt(out, msg, len, c->key, c->key_len,
-			     c->iv, c->iv_len);
+	rv = aes_gcm_open(&c->key, out, msg, len, c->iv, c->iv_len,
+			  aad, aad_len);
 	*out_len = rv ? 0 : len - AES_GCM_TAG_LEN;
 }
 
+static void
+aes_gcm_algorithm_seal(struct cipher *cipher, const u8 *aad,
+		       unsigned int aad_len, const u8 *msg, unsigned int len,
+		       u8 *out, unsigned int *out_len)
+{
+	struct cipher_aes_gcm *c = (struct cipher_aes_gcm *)cipher;
+	int rv;
+
+	rv = aes_gcm_seal(&c->key, out, msg, len, c->iv, c->iv_len,
+			  aad, aad_len);
+	*out_len = rv ? 0 : len + AES_GCM_TAG_LEN;
+}
+
+static void
+aes_gcm_algorithm_decrypt(struct cipher *cipher, const u8 *msg,
+			  unsigned int len, u8 *out, unsigned int *out_len)
+{
+	aes_gcm_algorithm_open(cipher, NULL, 0, msg, len, out, out_len);
+}
+
 static void
 aes_gcm_algorithm_encrypt(struct cipher *cipher, const u8 *msg,
 			  unsigned int len, u8 *out, unsigned int *out_len)
+{
+	aes_gcm_algorithm_seal(cipher, NULL, 0, msg, len, out, out_len);
+}
+
+/* Every backend's open hashes each ciphertext block before overwriting it
+ * and zeroes the payload on a tag mismatch, so the record stays in place. */
+static int
+aes_gcm_algorithm_decrypt_inplace(struct cipher *cipher, u8 *msg,
+				  unsigned int len)
+{
+	struct cipher_aes_gcm *c = (struct cipher_aes_gcm *)cipher;
+
+	return aes_gcm_open(&c->key, msg, msg, (int)len, c->iv, c->iv_len,
+			    NULL, 0);
+}
+
+static int
+aes_gcm_algorithm_encrypt_inplace(struct cipher *cipher, u8 *msg,
+				  unsigned int len)
+{
+	struct cipher_aes_gcm *c = (struct cipher_aes_gcm *)cipher;
+
+	return aes_gcm_seal(&c->key, msg, msg, (int)len, c->iv, c->iv_len,
+			    NULL, 0);
+}
+
+static void
+aes_gcm_algorithm_open_explicit(struct cipher *cipher, u64 nonce,
+				const u8 *aad, unsigned int aad_len,
+				const u8 *msg, unsigned int len,
+				u8 *out, unsigned int *out_len)
 {
 	struct cipher_aes_gcm *c = (struct cipher_aes_gcm *)cipher;
 	int rv;
 
-	rv = aes_gcm_encrypt(out, msg, len, c->key, c->key_len,
-			     c->iv, c->iv_len);
+	if (len < AES_GCM_TAG_LEN) {
+		*out_len = 0;
+		return;
+	}
+
+	rv = aes_gcm_open_explicit(&c->key, out, msg, len, c->salt, nonce,
+				   aad, aad_len);
+	*out_len = rv ? 0 : len - AES_GCM_TAG_LEN;
+}
+
+static void
+aes_gcm_algorithm_seal_explicit(struct cipher *cipher, u64 nonce,
+				const u8 *aad, unsigned int aad_len,
+				const u8 *msg, unsigned int len,
+				u8 *out, unsigned int *out_len)
+{
+	struct cipher_aes_gcm *c = (struct cipher_aes_gcm *)cipher;
+	int rv;
+
+	rv = aes_gcm_seal_explicit(&c->key, out, msg, len, c->salt, nonce,
+				   aad, aad_len);
 	*out_len = rv ? 0 : len + AES_GCM_TAG_LEN;
 }
 
+static void
+aes_gcm_iov_step(void *st, const u8 *in, u8 *out, unsigned int len)
+{
+	aes_gcm_stream_update((struct aes_gcm_stream *)st, in, out, len);
+}
+
+static int
+aes_gcm_algorithm_crypt_iov(struct cipher *cipher, int enc, const u8 *aad,
+			    unsigned int aad_len,
+			    const struct cipher_iovec *src, unsigned int src_cnt,
+			    const struct cipher_iovec *dst, unsigned int dst_cnt,
+			    u8 *tag)
+{
+	struct cipher_aes_gcm *c = (struct cipher_aes_gcm *)cipher;
+	struct aes_gcm_stream st;
+	long len;
+	int rv;
+
+	if (aes_gcm_stream_init(&st, &c->key, enc, c->iv, c->iv_len,
+				aad, aad_len))
+		return -1;
+	len = cipher_iov_walk(src, src_cnt, dst, dst_cnt, aes_gcm_iov_step, &st);
+	rv = aes_gcm_stream_final(&st, tag);
+	if (len < 0 || rv) {
+		if (!enc)
+			cipher_iov_zero(dst, dst_cnt);
+		return -1;
+	}
+	return 0;
+}
+
+static int
+aes_gcm_algorithm_open_iov(struct cipher *cipher, const u8 *aad,
+			   unsigned int aad_len,
+			   const struct cipher_iovec *src, unsigned int src_cnt,
+			   const struct cipher_iovec *dst, unsigned int dst_cnt,
+			   u8 *tag)
+{
+	return aes_gcm_algorithm_crypt_iov(cipher, 0, aad, aad_len, src,
+					   src_cnt, dst, dst_cnt, tag);
+}
+
+static int
+aes_gcm_algorithm_seal_iov(struct cipher *cipher, const u8 *aad,
+			   unsigned int aad_len,
+			   const struct cipher_iovec *src, unsigned int src_cnt,
+			   const struct cipher_iovec *dst, unsigned int dst_cnt,
+			   u8 *tag)
+{
+	return aes_gcm_algorithm_crypt_iov(cipher, 1, aad, aad_len, src,
+					   src_cnt, dst, dst_cnt, tag);
+}
+
 static struct cipher_algorithm aes128_gcm_algorithm = {
 	.name = "aes-128-gcm",
 	.desc = "AES-128-GCM",
@@ -328,9 +795,18 @@ static struct cipher_algorithm aes128_gcm_algorithm = {
 	.mac_size = 16,
 	.init = aes_gcm_algorithm_init,
 	.set_key = aes_gcm_algorithm_set_key,
+	.set_key_batch = aes_gcm_algorithm_set_key_batch,
 	.set_iv = aes_gcm_algorithm_set_iv,
 	.decrypt = aes_gcm_algorithm_decrypt,
 	.encrypt = aes_gcm_algorithm_encrypt,
+	.decrypt_inplace = aes_gcm_algorithm_decrypt_inplace,
+	.encrypt_inplace = aes_gcm_algorithm_encrypt_inplace,
+	.open = aes_gcm_algorithm_open,
+	.seal = aes_gcm_algorithm_seal,
+	.open_iov = aes_gcm_algorithm_open_iov,
+	.seal_iov = aes_gcm_algorithm_seal_iov,
+	.open_explicit = aes_gcm_algorithm_open_explicit,
+	.seal_explicit = aes_gcm_algorithm_seal_explicit,
 };
 
 static struct cipher_algorithm aes256_gcm_algorithm = {
@@ -347,16 +823,35 @@ static struct cipher_algorithm aes256_gcm_algorithm = {
 	.mac_size = 16,
 	.init = aes_gcm_algorithm_init,
 	.set_key = aes_gcm_algorithm_set_key,
+	.set_key_batch = aes_gcm_algorithm_set_key_batch,
 	.set_iv = aes_gcm_algorithm_set_iv,
 	.decrypt = aes_gcm_algorithm_decrypt,
 	.encrypt = aes_gcm_algorithm_encrypt,
+	.decrypt_inplace = aes_gcm_algorithm_decrypt_inplace,
+	.encrypt_inplace = aes_gcm_algorithm_encrypt_inplace,
+	.open = aes_gcm_algorithm_open,
+	.seal = aes_gcm_algorithm_seal,
+	.open_iov = aes_gcm_algorithm_open_iov,
+	.seal_iov = aes_gcm_algorithm_seal_iov,
+	.open_explicit = aes_gcm_algorithm_open_explicit,
+	.seal_explicit = aes_gcm_algorithm_seal_explicit,
 };
 
 static void __init__ cipher_aes_init(void)
 {
 	aes_init_keygen_tables();
+	aes_gcm_ctx_size = offsetof(struct cipher_aes_gcm, key) +
+			   aes_gcm_key_size();
+	aes128_gcm_algorithm.ctx_size = aes_gcm_ctx_size;
+	aes256_gcm_algorithm.ctx_size = aes_gcm_ctx_size;
 	crypto_cipher_register(&aes128_cbc_algorithm);
 	crypto_cipher_register(&aes256_cbc_algorithm);
+	crypto_cipher_register(&aes128_ctr_algorithm);
+	crypto_cipher_register(&aes256_ctr_algorithm);
+	crypto_cipher_register(&aes128_ccm_algorithm);
+	crypto_cipher_register(&aes128_ccm8_algorithm);
+	crypto_cipher_register(&aes256_ccm_algorithm);
+	crypto_cipher_register(&aes256_ccm8_algorithm);
 	crypto_cipher_register(&aes128_gcm_algorithm);
 	crypto_cipher_register(&aes256_gcm_algorithm);
 }
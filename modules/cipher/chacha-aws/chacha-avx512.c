@@ -0,0 +1,129 @@
+/*
+ * ChaCha20_ctr32_avx512: sixteen ChaCha20 blocks per pass in ZMM registers,
+ * for the x86_64 aws-lc glue (aws-lc ships no AVX-512 ChaCha20 kernel). The
+ * state is kept transposed, one register per state word with block j in
+ * lane j, so every quarter-round step is a single vpaddd/vpxord/vprold over
+ * all sixteen blocks; the result is transposed back to sixteen 64-byte
+ * blocks before the XOR. Runs shorter than 1 KiB (and the tail of a long
+ * one) go to ChaCha20_ctr32_avx2, which every AVX-512 CPU can run.
+ *
+ * Built with -mavx512f; only called once the glue has seen AVX512F and an
+ * OS that saves the ZMM state.
+ */
+#include <immintrin.h>
+#include "internal.h"
+
+#define CHACHA_X16_LEN (16 * 64)
+
+#define QR(a, b, c, d)							\
+	do {								\
+		a = _mm512_add_epi32(a, b);				\
+		d = _mm512_rol_epi32(_mm512_xor_si512(d, a), 16);	\
+		c = _mm512_add_epi32(c, d);				\
+		b = _mm512_rol_epi32(_mm512_xor_si512(b, c), 12);	\
+		a = _mm512_add_epi32(a, b);				\
+		d = _mm512_rol_epi32(_mm512_xor_si512(d, a), 8);	\
+		c = _mm512_add_epi32(c, d);				\
+		b = _mm512_rol_epi32(_mm512_xor_si512(b, c), 7);	\
+	} while (0)
+
+/*
+ * x[i] lane j is word i of block j. Transpose 4x4 words within each 128-bit
+ * lane, then 4x4 128-bit lanes across registers, and XOR block j of |in|
+ * into |out|.
+ */
+static inline void
+chacha_x16_xor(uint8_t *out, const uint8_t *in, __m512i x[16])
+{
+	__m512i y[16], t0, t1, t2, t3, u0, u1, u2, u3;
+	unsigned int k, m;
+
+	for (k = 0; k < 16; k += 4) {
+		t0 = _mm512_unpacklo_epi32(x[k + 0], x[k + 1]);
+		t1 = _mm512_unpackhi_epi32(x[k + 0], x[k + 1]);
+		t2 = _mm512_unpacklo_epi32(x[k + 2], x[k + 3]);
+		t3 = _mm512_unpackhi_epi32(x[k + 2], x[k + 3]);
+		/* y[k + m] lane L: words k..k+3 of block 4L + m */
+		y[k + 0] = _mm512_unpacklo_epi64(t0, t2);
+		y[k + 1] = _mm512_unpackhi_epi64(t0, t2);
+		y[k + 2] = _mm512_unpacklo_epi64(t1, t3);
+		y[k + 3] = _mm512_unpackhi_epi64(t1, t3);
+	}
+
+	for (m = 0; m < 4; m++) {
+		u0 = _mm512_shuffle_i32x4(y[m], y[m + 4], 0x44);
+		u1 = _mm512_shuffle_i32x4(y[m], y[m + 4], 0xee);
+		u2 = _mm512_shuffle_i32x4(y[m + 8], y[m + 12], 0x44);
+		u3 = _mm512_shuffle_i32x4(y[m + 8], y[m + 12], 0xee);
+		/* block 4L + m: lane L of y[m], y[m + 4], y[m + 8], y[m + 12] */
+		t0 = _mm512_shuffle_i32x4(u0, u2, 0x88);
+		t1 = _mm512_shuffle_i32x4(u0, u2, 0xdd);
+		t2 = _mm512_shuffle_i32x4(u1, u3, 0x88);
+		t3 = _mm512_shuffle_i32x4(u1, u3, 0xdd);
+
+#define XOR_BLOCK(b, v)							\
+	_mm512_storeu_si512((void *)(out + 64 * (b)), _mm512_xor_si512(v,	\
+		_mm512_loadu_si512((const void *)(in + 64 * (b)))))
+		XOR_BLOCK(m + 0, t0);
+		XOR_BLOCK(m + 4, t1);
+		XOR_BLOCK(m + 8, t2);
+		XOR_BLOCK(m + 12, t3);
+#undef XOR_BLOCK
+	}
+}
+
+void
+ChaCha20_ctr32_avx512(uint8_t *out, const uint8_t *in, size_t in_len,
+		      const uint32_t key[8], const uint32_t counter[4])
+{
+	static const uint32_t sigma[4] = {
+		0x61707865, 0x3320646e, 0x79622d32, 0x6b206574 };
+	__m512i s[16], x[16];
+	uint32_t tail[4];
+	unsigned int i;
+
+	if (in_len >= CHACHA_X16_LEN) {
+		for (i = 0; i < 4; i++)
+			s[i] = _mm512_set1_epi32((int)sigma[i]);
+		for (i = 0; i < 8; i++)
+			s[4 + i] = _mm512_set1_epi32((int)key[i]);
+		s[12] = _mm512_add_epi32(_mm512_set1_epi32((int)counter[0]),
+			_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10,
+					  11, 12, 13, 14, 15));
+		for (i = 1; i < 4; i++)
+			s[12 + i] = _mm512_set1_epi32((int)counter[i]);
+
+		do {
+			for (i = 0; i < 16; i++)
+				x[i] = s[i];
+			for (i = 0; i < 10; i++) {
+				QR(x[0], x[4], x[8],  x[12]);
+				QR(x[1], x[5], x[9],  x[13]);
+				QR(x[2], x[6], x[10], x[14]);
+				QR(x[3], x[7], x[11], x[15]);
+				QR(x[0], x[5], x[10], x[15]);
+				QR(x[1], x[6], x[11], x[12]);
+				QR(x[2], x[7], x[8],  x[13]);
+				QR(x[3], x[4], x[9],  x[14]);
+			}
+			for (i = 0; i < 16; i++)
+				x[i] = _mm512_add_epi32(x[i], s[i]);
+			chacha_x16_xor(out, in, x);
+
+			s[12] = _mm512_add_epi32(s[12], _mm512_set1_epi32(16));
+			out += CHACHA_X16_LEN;
+			in += CHACHA_X16_LEN;
+			in_len -= CHACHA_X16_LEN;
+		} while (in_len >= CHACHA_X16_LEN);
+
+		/* lane 0 holds the next block's counter */
+		tail[0] = (uint32_t)_mm_cvtsi128_si32(_mm512_castsi512_si128(s[12]));
+		tail[1] = counter[1];
+		tail[2] = counter[2];
+		tail[3] = counter[3];
+		counter = tail;
+	}
+
+	if (in_len)
+		ChaCha20_ctr32_avx2(out, in, in_len, key, counter);
+}
@@ -10,6 +10,8 @@
  */
 #include <string.h>
 #include <crypto/cipher/chacha.h>
+#include <crypto/cipher/chachapoly.h>
+#include <crypto/init.h>
 #include "internal.h"
 
 struct aws_chacha {
@@ -29,8 +31,35 @@ load_le32(const uint8_t *p)
 	       ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
 }
 
+/*
+ * The bulk kernel is picked once, on the first call (or by the constructor
+ * below), from the CPU capability vector and kept in chacha_kernel; runs
+ * shorter than its min_len take ChaCha20_ctr32_nohw. crypto_init() fills the
+ * vector first if no cap constructor has run yet.
+ */
+typedef void (*fn_chacha20_ctr32)(uint8_t *out, const uint8_t *in,
+				  size_t in_len, const uint32_t key[8],
+				  const uint32_t counter[4]);
+
+struct chacha_kernel {
+	fn_chacha20_ctr32 ctr32;
+	size_t min_len;
+	int (*usable)(void);
+	const char *desc;
+};
+
+static int cpu_any(void)
+{
+	return 1;
+}
+
 #if defined(__x86_64__)
-extern unsigned int OPENSSL_ia32cap_P[4];
+static int have_avx512(void)
+{
+	/* leaf7 EBX bit 16 (AVX512F); cleared unless the OS saves ZMM state */
+	return (OPENSSL_ia32cap_P[2] & (1u << 16)) &&
+	       (OPENSSL_ia32cap_P[2] & (1u << 5));
+}
 
 static int have_avx2(void)
 {
@@ -52,37 +81,132 @@ static int have_ssse3(void)
 #endif
 }
 
+#ifdef CHACHA_AWS_FUSED
+static int have_fused(void)
+{
+#if defined(CONFIG_X86_HAS_AVX)
+	return 1;	/* AVX-capable parts all provide SSE4.1 */
+#else
+	return OPENSSL_ia32cap_P[1] & (1u << 19);	/* leaf1 ECX bit 19 */
+#endif
+}
+#endif
+
+static int cpu_caps_empty(void)
+{
+	return !OPENSSL_ia32cap_P[0] && !OPENSSL_ia32cap_P[1];
+}
+
+/* best first */
+static const struct chacha_kernel chacha_kernels[] = {
+	{ ChaCha20_ctr32_avx512, 129, have_avx512,
+	  "ChaCha20-Poly1305 (aws-lc, AVX-512)" },
+	{ ChaCha20_ctr32_avx2, 129, have_avx2,
+	  "ChaCha20-Poly1305 (aws-lc, AVX2)" },
+	{ ChaCha20_ctr32_ssse3_4x, 129, have_ssse3,
+	  "ChaCha20-Poly1305 (aws-lc, SSSE3)" },
+	{ ChaCha20_ctr32_nohw, 0, cpu_any,
+	  "ChaCha20-Poly1305 (aws-lc, x86_64)" },
+};
+#elif defined(__aarch64__)
+static int have_neon(void)
+{
+	return OPENSSL_armcap_P & ARMV7_NEON;
+}
+
+#ifdef CHACHA_AWS_FUSED
+static int have_fused(void)
+{
+	return have_neon();
+}
+#endif
+
+static int cpu_caps_empty(void)
+{
+	return !OPENSSL_armcap_P;
+}
+
+/* best first; the neon path wants >= 192B */
+static const struct chacha_kernel chacha_kernels[] = {
+	{ ChaCha20_ctr32_neon, 192, have_neon,
+	  "ChaCha20-Poly1305 (aws-lc, NEON)" },
+	{ ChaCha20_ctr32_nohw, 0, cpu_any,
+	  "ChaCha20-Poly1305 (aws-lc, ARMv8)" },
+};
+#else
+#error "unsupported architecture for aws-lc ChaCha20 glue"
+#endif
+
 static void
-chacha20_ctr32(uint8_t *out, const uint8_t *in, size_t len,
-	       const uint32_t key[8], const uint32_t counter[4])
+chacha20_ctr32_resolve(uint8_t *out, const uint8_t *in, size_t len,
+		       const uint32_t key[8], const uint32_t counter[4]);
+
+static const struct chacha_kernel chacha_kernel_unresolved = {
+	chacha20_ctr32_resolve, 0, cpu_any, NULL
+};
+
+static const struct chacha_kernel *chacha_kernel = &chacha_kernel_unresolved;
+#ifdef CHACHA_AWS_FUSED
+static int chacha_fused;
+#endif
+
+static const struct chacha_kernel *
+chacha_kernel_select(void)
 {
-	if (len == 0)
-		return;
-	if (len > 128 && have_avx2())
-		ChaCha20_ctr32_avx2(out, in, len, key, counter);
-	else if (len > 128 && have_ssse3())
-		ChaCha20_ctr32_ssse3_4x(out, in, len, key, counter);
+	const struct chacha_kernel *k = chacha_kernels;
+
+	if (cpu_caps_empty())
+		crypto_init();
+	while (!k->usable())
+		k++;
+#ifdef CHACHA_AWS_FUSED
+	chacha_fused = have_fused();
+#endif
+	chacha_kernel = k;
+	return k;
+}
+
+static void
+chacha20_ctr32_resolve(uint8_t *out, const uint8_t *in, size_t len,
+		       const uint32_t key[8], const uint32_t counter[4])
+{
+	const struct chacha_kernel *k = chacha_kernel_select();
+
+	if (len >= k->min_len)
+		k->ctr32(out, in, len, key, counter);
 	else
 		ChaCha20_ctr32_nohw(out, in, len, key, counter);
 }
-#elif defined(__aarch64__)
-extern unsigned int OPENSSL_armcap_P;
 
-static void
+static void __init__
+chacha_kernel_init(void)
+{
+	chacha_kernel_select();
+}
+
+static inline void
 chacha20_ctr32(uint8_t *out, const uint8_t *in, size_t len,
 	       const uint32_t key[8], const uint32_t counter[4])
 {
+	const struct chacha_kernel *k = chacha_kernel;
+
 	if (len == 0)
 		return;
-	/* ARMV7_NEON == bit 0 of OPENSSL_armcap_P; the neon path wants >= 192B. */
-	if (len >= 192 && (OPENSSL_armcap_P & 1u))
-		ChaCha20_ctr32_neon(out, in, len, key, counter);
+	if (len >= k->min_len)
+		k->ctr32(out, in, len, key, counter);
 	else
 		ChaCha20_ctr32_nohw(out, in, len, key, counter);
 }
-#else
-#error "unsupported architecture for aws-lc ChaCha20 glue"
-#endif
+
+const char *
+chacha_desc(void)
+{
+	const struct chacha_kernel *k = chacha_kernel;
+
+	if (k == &chacha_kernel_unresolved)
+		k = chacha_kernel_select();
+	return k->desc;
+}
 
 void
 chacha_keysetup(struct chacha_ctx *x, const u8 *k, u32 kbits)
@@ -152,3 +276,55 @@ chacha_encrypt_bytes(struct chacha_ctx *x, const u8 *m, u8 *c_out, u32 bytes)
 		c->ks_used = bytes;
 	}
 }
+
+#ifdef CHACHA_AWS_FUSED
+/*
+ * One-pass AEAD (CONFIG_CRYPTO_CIPHER_CHACHA20_AWS_FUSED): the two-pass
+ * chachapoly_crypt reads every record twice, once for Poly1305 and once for
+ * the keystream; the fused kernel keeps each block in registers for both.
+ * The key words are stored little-endian, so they are the key bytes the
+ * kernel wants on both targets.
+ */
+int
+chachapoly_crypt_fused(struct chacha_ctx *x, const void *nonce,
+		       const void *ad, int ad_len, const void *input,
+		       int input_len, void *output, void *tag, int tag_len,
+		       int encrypt)
+{
+	struct aws_chacha *c = (struct aws_chacha *)x;
+	union chacha20_poly1305_open_data open;
+	union chacha20_poly1305_seal_data seal;
+	uint8_t diff = 0;
+	int i;
+
+	if (chacha_kernel == &chacha_kernel_unresolved)
+		chacha_kernel_select();
+	if (!tag_len || tag_len > 16 || !chacha_fused)
+		return 1;
+
+	if (encrypt) {
+		memcpy(seal.in.key, c->key, sizeof(seal.in.key));
+		seal.in.counter = 0;
+		memcpy(seal.in.nonce, nonce, sizeof(seal.in.nonce));
+		seal.in.extra_ciphertext = NULL;
+		seal.in.extra_ciphertext_len = 0;
+		chacha20_poly1305_seal(output, input, (size_t)input_len, ad,
+				       (size_t)ad_len, &seal);
+		memcpy(tag, seal.out.tag, (size_t)tag_len);
+		return CHACHAPOLY_OK;
+	}
+
+	memcpy(open.in.key, c->key, sizeof(open.in.key));
+	open.in.counter = 0;
+	memcpy(open.in.nonce, nonce, sizeof(open.in.nonce));
+	chacha20_poly1305_open(output, input, (size_t)input_len, ad,
+			       (size_t)ad_len, &open);
+	for (i = 0; i < tag_len; i++)
+		diff |= open.out.tag[i] ^ ((const uint8_t *)tag)[i];
+	if (diff) {
+		memset(output, 0, (size_t)input_len);
+		return CHACHAPOLY_INVALID_MAC;
+	}
+	return CHACHAPOLY_OK;
+}
+#endif
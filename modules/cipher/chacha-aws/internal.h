@@ -21,9 +21,69 @@ void ChaCha20_ctr32_ssse3_4x(uint8_t *out, const uint8_t *in, size_t in_len,
 			     const uint32_t key[8], const uint32_t counter[4]);
 void ChaCha20_ctr32_avx2(uint8_t *out, const uint8_t *in, size_t in_len,
 			 const uint32_t key[8], const uint32_t counter[4]);
+/* C intrinsics (chacha-avx512.c), not aws-lc assembly */
+void ChaCha20_ctr32_avx512(uint8_t *out, const uint8_t *in, size_t in_len,
+			   const uint32_t key[8], const uint32_t counter[4]);
 #elif defined(__aarch64__)
 void ChaCha20_ctr32_neon(uint8_t *out, const uint8_t *in, size_t in_len,
 			 const uint32_t key[8], const uint32_t counter[4]);
 #endif
 
+#ifdef CHACHA_AWS_FUSED
+/*
+ * Fused ChaCha20-Poly1305 (chacha20_poly1305_x86_64.S / _armv8.S): one pass
+ * over the data that encrypts and authenticates as it goes. |in| carries the
+ * 256-bit key, the initial block counter (0: block 0 keys Poly1305, the
+ * payload starts at block 1) and the nonce; the kernel overwrites it with
+ * the computed tag, which open leaves for the caller to compare. Layouts
+ * match aws-lc crypto/cipher_extra/internal.h. The x86_64 kernel needs
+ * SSE4.1 (and picks its AVX2 path itself), the ARMv8 one NEON.
+ */
+union chacha20_poly1305_open_data {
+	struct {
+		_Alignas(16) uint8_t key[32];
+		uint32_t counter;
+		uint8_t nonce[12];
+	} in;
+	struct {
+		uint8_t tag[16];
+	} out;
+};
+
+union chacha20_poly1305_seal_data {
+	struct {
+		_Alignas(16) uint8_t key[32];
+		uint32_t counter;
+		uint8_t nonce[12];
+		const uint8_t *extra_ciphertext;
+		size_t extra_ciphertext_len;
+	} in;
+	struct {
+		uint8_t tag[16];
+	} out;
+};
+
+void chacha20_poly1305_open(uint8_t *out_plaintext, const uint8_t *ciphertext,
+			    size_t plaintext_len, const uint8_t *ad,
+			    size_t ad_len,
+			    union chacha20_poly1305_open_data *data);
+void chacha20_poly1305_seal(uint8_t *out_ciphertext, const uint8_t *plaintext,
+			    size_t plaintext_len, const uint8_t *ad,
+			    size_t ad_len,
+			    union chacha20_poly1305_seal_data *data);
+
+/*
+ * chachapoly_crypt over the fused kernel (chacha-aws.c). Returns
+ * CHACHAPOLY_OK or CHACHAPOLY_INVALID_MAC (with |output| zeroed: the kernel
+ * decrypts before the tag is known), or 1 when the CPU lacks the kernel's
+ * SIMD baseline and the caller should take the two-pass path.
+ */
+struct chacha_ctx;
+
+int chachapoly_crypt_fused(struct chacha_ctx *x, const void *nonce,
+			   const void *ad, int ad_len, const void *input,
+			   int input_len, void *output, void *tag, int tag_len,
+			   int encrypt);
+#endif
+
 #endif
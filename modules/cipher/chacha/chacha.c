@@ -226,3 +226,9 @@ chacha_encrypt_bytes(struct chacha_ctx *x,const u8 *m,u8 *c,u32 bytes)
     m += 64;
   }
 }
+
+const char *
+chacha_desc(void)
+{
+  return "ChaCha20-Poly1305";
+}
@@ -28,6 +28,9 @@
 #include <assert.h>
 
 #include <crypto/cipher/chachapoly.h>
+#ifdef CHACHA_AWS_FUSED
+#include "internal.h"
+#endif
 
 /**
  * Constant-time memory compare. This should help to protect against
@@ -106,14 +109,99 @@ int chachapoly_init(struct chachapoly_ctx *ctx, const void *key, int key_len)
     return CHACHAPOLY_OK;
 }
 
+#define HCHACHA_ROTL(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+#define HCHACHA_QR(a, b, c, d) \
+    do { \
+        a += b; d = HCHACHA_ROTL(d ^ a, 16); \
+        c += d; b = HCHACHA_ROTL(b ^ c, 12); \
+        a += b; d = HCHACHA_ROTL(d ^ a, 8); \
+        c += d; b = HCHACHA_ROTL(b ^ c, 7); \
+    } while (0)
+
+static uint32_t load32_le(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void store32_le(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+void hchacha20(void *out, const void *key, const void *nonce)
+{
+    static const unsigned char sigma[16] = "expand 32-byte k";
+    const unsigned char *k = (const unsigned char *)key;
+    const unsigned char *n = (const unsigned char *)nonce;
+    unsigned char *o = (unsigned char *)out;
+    uint32_t x[16];
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        x[i] = load32_le(sigma + 4 * i);
+        x[12 + i] = load32_le(n + 4 * i);
+    }
+    for (i = 0; i < 8; i++)
+        x[4 + i] = load32_le(k + 4 * i);
+
+    /* a single block, not worth a trip through the vector kernels */
+    for (i = 0; i < 10; i++) {
+        HCHACHA_QR(x[0], x[4], x[8],  x[12]);
+        HCHACHA_QR(x[1], x[5], x[9],  x[13]);
+        HCHACHA_QR(x[2], x[6], x[10], x[14]);
+        HCHACHA_QR(x[3], x[7], x[11], x[15]);
+        HCHACHA_QR(x[0], x[5], x[10], x[15]);
+        HCHACHA_QR(x[1], x[6], x[11], x[12]);
+        HCHACHA_QR(x[2], x[7], x[8],  x[13]);
+        HCHACHA_QR(x[3], x[4], x[9],  x[14]);
+    }
+
+    for (i = 0; i < 4; i++) {
+        store32_le(o + 4 * i, x[i]);
+        store32_le(o + 16 + 4 * i, x[12 + i]);
+    }
+    memset(x, 0, sizeof(x));
+}
+
+int xchachapoly_init(struct chachapoly_ctx *ctx, const void *key,
+        const void *nonce, void *nonce12)
+{
+    unsigned char subkey[32];
+
+    hchacha20(subkey, key, nonce);
+    chachapoly_init(ctx, subkey, 256);
+    memset(subkey, 0, sizeof(subkey));
+
+    memset(nonce12, 0, 4);
+    memcpy((unsigned char *)nonce12 + 4, (const unsigned char *)nonce + 16, 8);
+    return CHACHAPOLY_OK;
+}
+
 int chachapoly_crypt(struct chachapoly_ctx *ctx, const void *nonce,
-        const void *ad, int ad_len, void *input, int input_len,
+        const void *ad, int ad_len, const void *input, int input_len,
         void *output, void *tag, int tag_len, int encrypt)
 {
     unsigned char poly_key[CHACHA_BLOCKLEN];
     unsigned char calc_tag[POLY1305_TAGLEN];
     const unsigned char one[4] = { 1, 0, 0, 0 };
 
+#ifdef CHACHA_AWS_FUSED
+    /* single pass over the record when the CPU runs the fused kernel; not for
+     * an in-place decrypt, which must leave a forged record untouched, so it
+     * takes the verify-first two passes below */
+    if (encrypt || input != output) {
+        int rv = chachapoly_crypt_fused(&ctx->cha_ctx, nonce, ad, ad_len,
+                                        input, input_len, output, tag,
+                                        tag_len, encrypt);
+        if (rv <= 0)
+            return rv;
+    }
+#endif
+
     /* initialize keystream and generate poly1305 key */
     memset(poly_key, 0, sizeof(poly_key));
     chacha_ivsetup(&ctx->cha_ctx, nonce, NULL);
@@ -129,7 +217,7 @@ int chachapoly_crypt(struct chachapoly_ctx *ctx, const void *nonce,
 
     /* crypt data */
     chacha_ivsetup(&ctx->cha_ctx, nonce, one);
-    chacha_encrypt_bytes(&ctx->cha_ctx, (unsigned char *)input,
+    chacha_encrypt_bytes(&ctx->cha_ctx, (const unsigned char *)input,
                          (unsigned char *)output, input_len);
 
     /* add tag if encrypting */
@@ -142,7 +230,7 @@ int chachapoly_crypt(struct chachapoly_ctx *ctx, const void *nonce,
 }
 
 int chachapoly_crypt_short(struct chachapoly_ctx *ctx, const void *nonce,
-        const void *ad, int ad_len, void *input, int input_len,
+        const void *ad, int ad_len, const void *input, int input_len,
         void *output, void *tag, int tag_len, int encrypt)
 {
     unsigned char keystream[CHACHA_BLOCKLEN];
@@ -168,7 +256,7 @@ int chachapoly_crypt_short(struct chachapoly_ctx *ctx, const void *nonce,
     /* crypt data */
     for (i = 0; i < input_len; i++) {
         ((unsigned char *)output)[i] =
-            ((unsigned char *)input)[i] ^ keystream[32 + i];
+            ((const unsigned char *)input)[i] ^ keystream[32 + i];
     }
 
     /* add tag if encrypting */
@@ -179,3 +267,185 @@ int chachapoly_crypt_short(struct chachapoly_ctx *ctx, const void *nonce,
 
     return CHACHAPOLY_OK;
 }
+
+static const unsigned char zero_pad[16];
+
+void chachapoly_stream_init(struct chachapoly_stream *st,
+        struct chachapoly_ctx *ctx, const void *nonce,
+        const void *ad, int ad_len, int encrypt)
+{
+    unsigned char poly_key[CHACHA_BLOCKLEN];
+    const unsigned char one[4] = { 1, 0, 0, 0 };
+
+    st->ctx = ctx;
+    st->num = 0;
+    st->ad_len = (uint64_t)ad_len;
+    st->len = 0;
+    st->encrypt = encrypt;
+
+    /* block 0 keys poly1305, the payload starts at block 1 */
+    memset(poly_key, 0, sizeof(poly_key));
+    chacha_ivsetup(&ctx->cha_ctx, nonce, NULL);
+    chacha_encrypt_bytes(&ctx->cha_ctx, poly_key, poly_key, sizeof(poly_key));
+    chacha_ivsetup(&ctx->cha_ctx, nonce, one);
+
+    poly1305_init(&st->poly, poly_key);
+    poly1305_update(&st->poly, ad, ad_len);
+    if (ad_len % 16)
+        poly1305_update(&st->poly, zero_pad, 16 - ad_len % 16);
+}
+
+/* XOR n bytes against the buffered keystream block, hashing the ciphertext */
+static void stream_partial(struct chachapoly_stream *st,
+        const unsigned char *in, unsigned char *out, size_t n)
+{
+    if (!st->encrypt)
+        poly1305_update(&st->poly, in, n);
+    for (size_t i = 0; i < n; i++)
+        out[i] = in[i] ^ st->keystream[st->num++];
+    if (st->encrypt)
+        poly1305_update(&st->poly, out, n);
+}
+
+void chachapoly_stream_update(struct chachapoly_stream *st,
+        const void *input, void *output, size_t len)
+{
+    const unsigned char *in = (const unsigned char *)input;
+    unsigned char *out = (unsigned char *)output;
+    size_t n;
+
+    st->len += len;
+
+    /* use up the keystream block the previous piece stopped in */
+    if (st->num) {
+        n = CHACHA_BLOCKLEN - st->num;
+        if (n > len)
+            n = len;
+        stream_partial(st, in, out, n);
+        in += n;
+        out += n;
+        len -= n;
+        if (st->num < CHACHA_BLOCKLEN)
+            return;
+        st->num = 0;
+    }
+
+    /* whole blocks straight through the cipher; hash ciphertext in place */
+    n = len & ~(size_t)(CHACHA_BLOCKLEN - 1);
+    if (n) {
+        if (!st->encrypt)
+            poly1305_update(&st->poly, in, n);
+        chacha_encrypt_bytes(&st->ctx->cha_ctx, in, out, (u32)n);
+        if (st->encrypt)
+            poly1305_update(&st->poly, out, n);
+        in += n;
+        out += n;
+        len -= n;
+    }
+
+    /* the piece ends inside the next block: keep the rest of it */
+    if (len) {
+        memset(st->keystream, 0, sizeof(st->keystream));
+        chacha_encrypt_bytes(&st->ctx->cha_ctx, st->keystream,
+                             st->keystream, sizeof(st->keystream));
+        stream_partial(st, in, out, len);
+    }
+}
+
+int chachapoly_stream_final(struct chachapoly_stream *st, void *tag,
+        int tag_len)
+{
+    unsigned char calc_tag[POLY1305_TAGLEN];
+    int rv = CHACHAPOLY_OK;
+
+    if (st->len % 16)
+        poly1305_update(&st->poly, zero_pad, 16 - st->len % 16);
+    poly1305_update(&st->poly, (unsigned char *)&st->ad_len, 8);
+    poly1305_update(&st->poly, (unsigned char *)&st->len, 8);
+    poly1305_finish(&st->poly, calc_tag);
+
+    if (st->encrypt)
+        memcpy(tag, calc_tag, tag_len);
+    else if (memcmp_eq(calc_tag, tag, tag_len) != 0)
+        rv = CHACHAPOLY_INVALID_MAC;
+
+    memset(st, 0, sizeof(*st));
+    return rv;
+}
+
+/* records per poly1305_update_mb call, kept on the stack */
+#define CHACHAPOLY_MB_CHUNK 16
+
+unsigned int chachapoly_crypt_mb(struct chachapoly_mb *rec, unsigned int n,
+        int encrypt)
+{
+    struct poly1305_context poly[CHACHAPOLY_MB_CHUNK];
+    struct poly1305_context *pp[CHACHAPOLY_MB_CHUNK];
+    const unsigned char *m[CHACHAPOLY_MB_CHUNK];
+    size_t len[CHACHAPOLY_MB_CHUNK];
+    unsigned char poly_key[CHACHA_BLOCKLEN];
+    unsigned char calc_tag[POLY1305_TAGLEN];
+    const unsigned char one[4] = { 1, 0, 0, 0 };
+    uint64_t lens[2];
+    unsigned int i, j, c, failed = 0;
+
+    for (i = 0; i < n; i += c) {
+        c = n - i < CHACHAPOLY_MB_CHUNK ? n - i : CHACHAPOLY_MB_CHUNK;
+
+        /* per record: poly1305 key, ciphertext when sealing, and the AD */
+        for (j = 0; j < c; j++) {
+            struct chachapoly_mb *r = &rec[i + j];
+            struct chacha_ctx *x = &r->ctx->cha_ctx;
+
+            memset(poly_key, 0, sizeof(poly_key));
+            chacha_ivsetup(x, r->nonce, NULL);
+            chacha_encrypt_bytes(x, poly_key, poly_key, sizeof(poly_key));
+            if (encrypt) {
+                chacha_ivsetup(x, r->nonce, one);
+                chacha_encrypt_bytes(x, (const unsigned char *)r->in,
+                                     (unsigned char *)r->out, r->len);
+            }
+
+            poly1305_init(&poly[j], poly_key);
+            poly1305_update(&poly[j], r->ad, r->ad_len);
+            if (r->ad_len % 16)
+                poly1305_update(&poly[j], zero_pad, 16 - r->ad_len % 16);
+            pp[j] = &poly[j];
+            m[j] = encrypt ? r->out : r->in;
+            len[j] = (size_t)r->len;
+        }
+
+        /* the ciphertexts, a record per lane */
+        poly1305_update_mb(pp, m, len, c);
+
+        for (j = 0; j < c; j++) {
+            struct chachapoly_mb *r = &rec[i + j];
+            struct chacha_ctx *x = &r->ctx->cha_ctx;
+
+            if (r->len % 16)
+                poly1305_update(&poly[j], zero_pad, 16 - r->len % 16);
+            lens[0] = (uint64_t)r->ad_len;
+            lens[1] = (uint64_t)r->len;
+            poly1305_update(&poly[j], (unsigned char *)lens, sizeof(lens));
+            poly1305_finish(&poly[j], calc_tag);
+
+            if (encrypt) {
+                memcpy(r->tag, calc_tag, POLY1305_TAGLEN);
+                r->status = CHACHAPOLY_OK;
+                continue;
+            }
+            if (memcmp_eq(calc_tag, r->tag, POLY1305_TAGLEN) != 0) {
+                r->status = CHACHAPOLY_INVALID_MAC;
+                failed++;
+                continue;
+            }
+            r->status = CHACHAPOLY_OK;
+            chacha_ivsetup(x, r->nonce, one);
+            chacha_encrypt_bytes(x, (const unsigned char *)r->in,
+                                 (unsigned char *)r->out, r->len);
+        }
+    }
+
+    memset(poly_key, 0, sizeof(poly_key));
+    return failed;
+}
@@ -4,7 +4,8 @@
 #include <crypto/cipher/chachapoly.h>
 
 /* ChaCha20-Poly1305 AEAD (RFC 7539): decrypt expects the 16-byte tag
- * appended to the ciphertext, encrypt appends it to the output. */
+ * appended to the ciphertext, encrypt appends it to the output. open/seal
+ * additionally authenticate associated data. */
 
 #define CHACHAPOLY_NONCE_LEN 12
 
@@ -57,8 +58,9 @@ chachapoly_algorithm_set_iv(struct cipher *cipher, const u8 *iv,
 }
 
 static void
-chachapoly_algorithm_decrypt(struct cipher *cipher, const u8 *msg,
-			     unsigned int len, u8 *out, unsigned int *out_len)
+chachapoly_algorithm_open(struct cipher *cipher, const u8 *aad,
+			  unsigned int aad_len, const u8 *msg,
+			  unsigned int len, u8 *out, unsigned int *out_len)
 {
 	struct cipher_chachapoly *c = (struct cipher_chachapoly *)cipher;
 	int rv;
@@ -68,26 +70,122 @@ chachapoly_algorithm_decrypt(struct cipher *cipher, const u8 *msg,
 		return;
 	}
 
-	rv = chachapoly_crypt(&c->ctx, c->iv, NULL, 0,
-			      (void *)msg, len - POLY1305_TAGLEN, out,
+	rv = chachapoly_crypt(&c->ctx, c->iv, aad, (int)aad_len,
+			      msg, len - POLY1305_TAGLEN, out,
 			      (void *)(msg + len - POLY1305_TAGLEN),
 			      POLY1305_TAGLEN, 0);
 	*out_len = rv ? 0 : len - POLY1305_TAGLEN;
 }
 
 static void
-chachapoly_algorithm_encrypt(struct cipher *cipher, const u8 *msg,
-			     unsigned int len, u8 *out, unsigned int *out_len)
+chachapoly_algorithm_seal(struct cipher *cipher, const u8 *aad,
+			  unsigned int aad_len, const u8 *msg,
+			  unsigned int len, u8 *out, unsigned int *out_len)
 {
 	struct cipher_chachapoly *c = (struct cipher_chachapoly *)cipher;
 	int rv;
 
-	rv = chachapoly_crypt(&c->ctx, c->iv, NULL, 0,
-			      (void *)msg, len, out,
+	rv = chachapoly_crypt(&c->ctx, c->iv, aad, (int)aad_len,
+			      msg, len, out,
 			      out + len, POLY1305_TAGLEN, 1);
 	*out_len = rv ? 0 : len + POLY1305_TAGLEN;
 }
 
+static void
+chachapoly_algorithm_decrypt(struct cipher *cipher, const u8 *msg,
+			     unsigned int len, u8 *out, unsigned int *out_len)
+{
+	chachapoly_algorithm_open(cipher, NULL, 0, msg, len, out, out_len);
+}
+
+static void
+chachapoly_algorithm_encrypt(struct cipher *cipher, const u8 *msg,
+			     unsigned int len, u8 *out, unsigned int *out_len)
+{
+	chachapoly_algorithm_seal(cipher, NULL, 0, msg, len, out, out_len);
+}
+
+/* chachapoly_crypt checks the tag before it decrypts a byte in place, also
+ * with the fused aws-lc open configured, so a forged record is left as it
+ * was. */
+static int
+chachapoly_algorithm_decrypt_inplace(struct cipher *cipher, u8 *msg,
+				     unsigned int len)
+{
+	struct cipher_chachapoly *c = (struct cipher_chachapoly *)cipher;
+
+	if (len < POLY1305_TAGLEN)
+		return -1;
+	return chachapoly_crypt(&c->ctx, c->iv, NULL, 0, msg,
+				len - POLY1305_TAGLEN, msg,
+				msg + len - POLY1305_TAGLEN, POLY1305_TAGLEN, 0);
+}
+
+static int
+chachapoly_algorithm_encrypt_inplace(struct cipher *cipher, u8 *msg,
+				     unsigned int len)
+{
+	struct cipher_chachapoly *c = (struct cipher_chachapoly *)cipher;
+
+	return chachapoly_crypt(&c->ctx, c->iv, NULL, 0, msg, len, msg,
+				msg + len, POLY1305_TAGLEN, 1);
+}
+
+static void
+chachapoly_iov_step(void *st, const u8 *in, u8 *out, unsigned int len)
+{
+	chachapoly_stream_update((struct chachapoly_stream *)st, in, out, len);
+}
+
+static int
+chachapoly_algorithm_crypt_iov(struct cipher *cipher, int enc, const u8 *aad,
+			       unsigned int aad_len,
+			       const struct cipher_iovec *src,
+			       unsigned int src_cnt,
+			       const struct cipher_iovec *dst,
+			       unsigned int dst_cnt, u8 *tag)
+{
+	struct cipher_chachapoly *c = (struct cipher_chachapoly *)cipher;
+	struct chachapoly_stream st;
+	long len;
+	int rv;
+
+	chachapoly_stream_init(&st, &c->ctx, c->iv, aad, (int)aad_len, enc);
+	len = cipher_iov_walk(src, src_cnt, dst, dst_cnt, chachapoly_iov_step,
+			      &st);
+	rv = chachapoly_stream_final(&st, tag, POLY1305_TAGLEN);
+	if (len < 0 || rv) {
+		if (!enc)
+			cipher_iov_zero(dst, dst_cnt);
+		return -1;
+	}
+	return 0;
+}
+
+static int
+chachapoly_algorithm_open_iov(struct cipher *cipher, const u8 *aad,
+			      unsigned int aad_len,
+			      const struct cipher_iovec *src,
+			      unsigned int src_cnt,
+			      const struct cipher_iovec *dst,
+			      unsigned int dst_cnt, u8 *tag)
+{
+	return chachapoly_algorithm_crypt_iov(cipher, 0, aad, aad_len, src,
+					      src_cnt, dst, dst_cnt, tag);
+}
+
+static int
+chachapoly_algorithm_seal_iov(struct cipher *cipher, const u8 *aad,
+			      unsigned int aad_len,
+			      const struct cipher_iovec *src,
+			      unsigned int src_cnt,
+			      const struct cipher_iovec *dst,
+			      unsigned int dst_cnt, u8 *tag)
+{
+	return chachapoly_algorithm_crypt_iov(cipher, 1, aad, aad_len, src,
+					      src_cnt, dst, dst_cnt, tag);
+}
+
 static struct cipher_algorithm chachapoly_algorithm = {
 	.name = "chacha20-poly1305",
 	.desc = "ChaCha20-Poly1305",
@@ -105,9 +203,110 @@ static struct cipher_algorithm chachapoly_algorithm = {
 	.set_iv = chachapoly_algorithm_set_iv,
 	.decrypt = chachapoly_algorithm_decrypt,
 	.encrypt = chachapoly_algorithm_encrypt,
+	.decrypt_inplace = chachapoly_algorithm_decrypt_inplace,
+	.encrypt_inplace = chachapoly_algorithm_encrypt_inplace,
+	.open = chachapoly_algorithm_open,
+	.seal = chachapoly_algorithm_seal,
+	.open_iov = chachapoly_algorithm_open_iov,
+	.seal_iov = chachapoly_algorithm_seal_iov,
+};
+
+/* XChaCha20-Poly1305 (draft-irtf-cfrg-xchacha): a 24-byte nonce. Once both
+ * the key and the nonce are set, the HChaCha20 subkey and the derived 12-byte
+ * nonce go into the embedded ChaCha20-Poly1305 context, and the record runs
+ * through the functions above. */
+
+struct cipher_xchachapoly {
+	struct cipher_chachapoly base;
+	u8 key[32];
+	u8 nonce[XCHACHAPOLY_NONCE_LEN];
+	unsigned int has_key:1;
+	unsigned int has_nonce:1;
+};
+
+_Static_assert(sizeof(struct cipher_xchachapoly) <= CIPHER_CTXT_SIZE_MAX,
+	       "XChaCha20-Poly1305 context is too large");
+
+static void
+xchachapoly_derive(struct cipher_xchachapoly *x)
+{
+	if (!x->has_key || !x->has_nonce)
+		return;
+	xchachapoly_init(&x->base.ctx, x->key, x->nonce, x->base.iv);
+	x->base.iv_len = CHACHAPOLY_NONCE_LEN;
+}
+
+static void
+xchachapoly_algorithm_set_key(struct cipher *cipher, const u8 *key,
+			      unsigned int len)
+{
+	struct cipher_xchachapoly *x = (struct cipher_xchachapoly *)cipher;
+
+	if (len != sizeof(x->key))
+		return;
+	memcpy(x->key, key, len);
+	x->has_key = 1;
+	xchachapoly_derive(x);
+}
+
+static void
+xchachapoly_algorithm_set_iv(struct cipher *cipher, const u8 *iv,
+			     unsigned int len)
+{
+	struct cipher_xchachapoly *x = (struct cipher_xchachapoly *)cipher;
+
+	if (len != XCHACHAPOLY_NONCE_LEN)
+		return;
+	memcpy(x->nonce, iv, len);
+	x->has_nonce = 1;
+	xchachapoly_derive(x);
+}
+
+static void
+xchachapoly_algorithm_init(struct cipher *cipher,
+			   const u8 *key, unsigned int key_len,
+			   const u8 *iv, unsigned int iv_len,
+			   const u8 *mac, unsigned int mac_len)
+{
+	struct cipher_xchachapoly *x = (struct cipher_xchachapoly *)cipher;
+
+	(void)mac; (void)mac_len;
+	memset(x, 0, sizeof(*x));
+	if (key)
+		xchachapoly_algorithm_set_key(cipher, key, key_len);
+	if (iv)
+		xchachapoly_algorithm_set_iv(cipher, iv, iv_len);
+}
+
+static struct cipher_algorithm xchachapoly_algorithm = {
+	.name = "xchacha20-poly1305",
+	.desc = "XChaCha20-Poly1305",
+	.id = C_XCHACHA20,
+	.mode = M_POLY1305,
+	.type = C_TYPE_AEAD,
+	.dialect = C_DIALECT_NONE,
+	.ctx_size = sizeof(struct cipher_xchachapoly),
+	.key_size = 32,
+	.block_size = CHACHA_BLOCKLEN,
+	.iv_size = XCHACHAPOLY_NONCE_LEN,
+	.mac_size = POLY1305_TAGLEN,
+	.init = xchachapoly_algorithm_init,
+	.set_key = xchachapoly_algorithm_set_key,
+	.set_iv = xchachapoly_algorithm_set_iv,
+	.decrypt = chachapoly_algorithm_decrypt,
+	.encrypt = chachapoly_algorithm_encrypt,
+	.decrypt_inplace = chachapoly_algorithm_decrypt_inplace,
+	.encrypt_inplace = chachapoly_algorithm_encrypt_inplace,
+	.open = chachapoly_algorithm_open,
+	.seal = chachapoly_algorithm_seal,
+	.open_iov = chachapoly_algorithm_open_iov,
+	.seal_iov = chachapoly_algorithm_seal_iov,
 };
 
 static void __init__ cipher_chacha_init(void)
 {
+	/* names the keystream kernel the backend picked for this CPU */
+	chachapoly_algorithm.desc = chacha_desc();
 	crypto_cipher_register(&chachapoly_algorithm);
+	crypto_cipher_register(&xchachapoly_algorithm);
 }
@@ -0,0 +1,376 @@
+/*
+poly1305 implementation using 64 bit * 64 bit = 128 bit multiplication and 128 bit addition
+public domain
+
+Long messages go to the AVX2 (4-way) or NEON (2-way) block function when one
+is configured; the scalar code below handles the rest and the final block.
+*/
+
+#include "poly1305-64.h"
+#if defined(CONFIG_CRYPTO_CIPHER_POLY1305_AVX2)
+#include <crypto/init.h>
+#endif
+
+#if (USE_UNALIGNED == 1)
+#define U8TO64(p) \
+    (*((u64 *)(p)))
+#define U64TO8(p, v) \
+    do { \
+      *((u64 *)(p)) = v; \
+    } while (0)
+#else
+/* interpret eight 8 bit unsigned integers as a 64 bit unsigned integer in little endian */
+static u64
+U8TO64(const u8 *p)
+{
+    return
+        (((u64)(p[0] & 0xff)      ) |
+         ((u64)(p[1] & 0xff) <<  8) |
+         ((u64)(p[2] & 0xff) << 16) |
+         ((u64)(p[3] & 0xff) << 24) |
+         ((u64)(p[4] & 0xff) << 32) |
+         ((u64)(p[5] & 0xff) << 40) |
+         ((u64)(p[6] & 0xff) << 48) |
+         ((u64)(p[7] & 0xff) << 56));
+}
+
+/* store a 64 bit unsigned integer as eight 8 bit unsigned integers in little endian */
+static void
+U64TO8(u8 *p, u64 v)
+{
+    p[0] = (v      ) & 0xff;
+    p[1] = (v >>  8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+    p[4] = (v >> 32) & 0xff;
+    p[5] = (v >> 40) & 0xff;
+    p[6] = (v >> 48) & 0xff;
+    p[7] = (v >> 56) & 0xff;
+}
+#endif
+
+#if defined(CONFIG_CRYPTO_CIPHER_POLY1305_AVX2)
+/*
+ * Whether the AVX2 block function runs, read once from the CPU capability
+ * vector on the first call that could use it (-1 until then). crypto_init()
+ * fills the vector first if no cap constructor has run yet.
+ */
+static int poly1305_avx2 = -1;
+
+static int
+have_avx2(void)
+{
+#if defined(CONFIG_X86_HAS_AVX2)
+    return 1;
+#else
+    if (poly1305_avx2 < 0) {
+        if (!OPENSSL_ia32cap_P[0] && !OPENSSL_ia32cap_P[1])
+            crypto_init();
+        /* leaf7 EBX bit 5 (AVX2), cleared unless the OS saves the YMM state */
+        poly1305_avx2 = (OPENSSL_ia32cap_P[2] & (1u << 5)) != 0;
+    }
+    return poly1305_avx2;
+#endif
+}
+#endif
+
+void
+poly1305_init(struct poly1305_context *ctx, const u8 key[32])
+{
+    struct poly1305_state64 *st = (struct poly1305_state64 *)ctx;
+    u64 t0, t1;
+
+    /* r &= 0xffffffc0ffffffc0ffffffc0fffffff */
+    t0 = U8TO64(&key[0]);
+    t1 = U8TO64(&key[8]);
+
+    st->r[0] = ( t0                    ) & 0xffc0fffffff;
+    st->r[1] = ((t0 >> 44) | (t1 << 20)) & 0xfffffc0ffff;
+    st->r[2] = ((t1 >> 24)             ) & 0x00ffffffc0f;
+
+    /* h = 0 */
+    st->h[0] = 0;
+    st->h[1] = 0;
+    st->h[2] = 0;
+
+    /* save pad for later */
+    st->pad[0] = U8TO64(&key[16]);
+    st->pad[1] = U8TO64(&key[24]);
+
+    st->leftover = 0;
+    st->final = 0;
+    st->powers = 0;
+}
+
+static void
+poly1305_blocks(struct poly1305_state64 *st, const u8 *m, size_t bytes)
+{
+    const u64 hibit = (st->final) ? 0 : ((u64)1 << 40); /* 1 << 128 */
+    u64 r0,r1,r2;
+    u64 s1,s2;
+    u64 h0,h1,h2;
+    u64 c;
+    uint128_t d0,d1,d2,d;
+
+#if defined(CONFIG_CRYPTO_CIPHER_POLY1305_AVX2) || \
+    defined(CONFIG_CRYPTO_CIPHER_POLY1305_NEON)
+    if (hibit && bytes >= POLY1305_SIMD_MIN) {
+        size_t done = 0;
+#if defined(CONFIG_CRYPTO_CIPHER_POLY1305_AVX2)
+        if (have_avx2()) {
+            if (!st->powers)
+                poly1305_powers(st);
+            done = poly1305_blocks_avx2(st, m, bytes);
+        }
+#else
+        if (!st->powers)
+            poly1305_powers(st);
+        done = poly1305_blocks_neon(st, m, bytes);
+#endif
+        m += done;
+        bytes -= done;
+    }
+#endif
+
+    r0 = st->r[0];
+    r1 = st->r[1];
+    r2 = st->r[2];
+
+    h0 = st->h[0];
+    h1 = st->h[1];
+    h2 = st->h[2];
+
+    s1 = r1 * (5 << 2);
+    s2 = r2 * (5 << 2);
+
+    while (bytes >= POLY1305_BLOCK_SIZE) {
+        u64 t0, t1;
+
+        /* h += m[i] */
+        t0 = U8TO64(&m[0]);
+        t1 = U8TO64(&m[8]);
+
+        h0 += (( t0                    ) & 0xfffffffffff);
+        h1 += (((t0 >> 44) | (t1 << 20)) & 0xfffffffffff);
+        h2 += (((t1 >> 24)             ) & 0x3ffffffffff) | hibit;
+
+        /* h *= r */
+        d0 = (uint128_t)h0 * r0; d = (uint128_t)h1 * s2; d0 += d; d = (uint128_t)h2 * s1; d0 += d;
+        d1 = (uint128_t)h0 * r1; d = (uint128_t)h1 * r0; d1 += d; d = (uint128_t)h2 * s2; d1 += d;
+        d2 = (uint128_t)h0 * r2; d = (uint128_t)h1 * r1; d2 += d; d = (uint128_t)h2 * r0; d2 += d;
+
+        /* (partial) h %= p */
+                      c = (u64)(d0 >> 44); h0 = (u64)d0 & 0xfffffffffff;
+        d1 += c;      c = (u64)(d1 >> 44); h1 = (u64)d1 & 0xfffffffffff;
+        d2 += c;      c = (u64)(d2 >> 42); h2 = (u64)d2 & 0x3ffffffffff;
+        h0 += c * 5;  c = (h0 >> 44);      h0 =      h0 & 0xfffffffffff;
+        h1 += c;
+
+        m += POLY1305_BLOCK_SIZE;
+        bytes -= POLY1305_BLOCK_SIZE;
+    }
+
+    st->h[0] = h0;
+    st->h[1] = h1;
+    st->h[2] = h2;
+}
+
+void
+poly1305_finish(struct poly1305_context *ctx, u8 mac[16])
+{
+    struct poly1305_state64 *st = (struct poly1305_state64 *)ctx;
+    u64 h0,h1,h2,c;
+    u64 g0,g1,g2;
+    u64 t0,t1;
+    int k, l;
+
+    /* process the remaining block */
+    if (st->leftover) {
+        size_t i = st->leftover;
+        st->buffer[i++] = 1;
+        for (; i < POLY1305_BLOCK_SIZE; i++)
+            st->buffer[i] = 0;
+        st->final = 1;
+        poly1305_blocks(st, st->buffer, POLY1305_BLOCK_SIZE);
+    }
+
+    /* fully carry h */
+    h0 = st->h[0];
+    h1 = st->h[1];
+    h2 = st->h[2];
+
+                 c = (h1 >> 44); h1 &= 0xfffffffffff;
+    h2 += c;     c = (h2 >> 42); h2 &= 0x3ffffffffff;
+    h0 += c * 5; c = (h0 >> 44); h0 &= 0xfffffffffff;
+    h1 += c;     c = (h1 >> 44); h1 &= 0xfffffffffff;
+    h2 += c;     c = (h2 >> 42); h2 &= 0x3ffffffffff;
+    h0 += c * 5; c = (h0 >> 44); h0 &= 0xfffffffffff;
+    h1 += c;
+
+    /* compute h + -p */
+    g0 = h0 + 5; c = (g0 >> 44); g0 &= 0xfffffffffff;
+    g1 = h1 + c; c = (g1 >> 44); g1 &= 0xfffffffffff;
+    g2 = h2 + c - ((u64)1 << 42);
+
+    /* select h if h < p, or h + -p if h >= p */
+    c = (g2 >> ((sizeof(u64) * 8) - 1)) - 1;
+    g0 &= c;
+    g1 &= c;
+    g2 &= c;
+    c = ~c;
+    h0 = (h0 & c) | g0;
+    h1 = (h1 & c) | g1;
+    h2 = (h2 & c) | g2;
+
+    /* h = (h + pad) */
+    t0 = st->pad[0];
+    t1 = st->pad[1];
+
+    h0 += (( t0                    ) & 0xfffffffffff)    ; c = (h0 >> 44); h0 &= 0xfffffffffff;
+    h1 += (((t0 >> 44) | (t1 << 20)) & 0xfffffffffff) + c; c = (h1 >> 44); h1 &= 0xfffffffffff;
+    h2 += (((t1 >> 24)             ) & 0x3ffffffffff) + c;                 h2 &= 0x3ffffffffff;
+
+    /* mac = h % (2^128) */
+    h0 = ((h0      ) | (h1 << 44));
+    h1 = ((h1 >> 20) | (h2 << 24));
+
+    U64TO8(&mac[0], h0);
+    U64TO8(&mac[8], h1);
+
+    /* zero out the state */
+    st->h[0] = 0;
+    st->h[1] = 0;
+    st->h[2] = 0;
+    st->r[0] = 0;
+    st->r[1] = 0;
+    st->r[2] = 0;
+    st->pad[0] = 0;
+    st->pad[1] = 0;
+    for (k = 0; k < 5; k++)
+        for (l = 0; l < 4; l++)
+            st->rp[k][l] = 0;
+    st->powers = 0;
+}
+
+void
+poly1305_update(struct poly1305_context *ctx, const u8 *m, size_t bytes)
+{
+    struct poly1305_state64 *st = (struct poly1305_state64 *)ctx;
+    size_t i;
+
+    /* handle leftover */
+    if (st->leftover) {
+        size_t want = (POLY1305_BLOCK_SIZE - st->leftover);
+        if (want > bytes)
+            want = bytes;
+        for (i = 0; i < want; i++)
+            st->buffer[st->leftover + i] = m[i];
+        bytes -= want;
+        m += want;
+        st->leftover += want;
+        if (st->leftover < POLY1305_BLOCK_SIZE)
+            return;
+        poly1305_blocks(st, st->buffer, POLY1305_BLOCK_SIZE);
+        st->leftover = 0;
+    }
+
+    /* process full blocks */
+    if (bytes >= POLY1305_BLOCK_SIZE) {
+        size_t want = (bytes & ~(POLY1305_BLOCK_SIZE - 1));
+        poly1305_blocks(st, m, want);
+        m += want;
+        bytes -= want;
+    }
+
+    /* store leftover */
+    if (bytes) {
+#if (USE_MEMCPY == 1)
+        memcpy(st->buffer + st->leftover, m, bytes);
+#else
+        for (i = 0; i < bytes; i++)
+            st->buffer[st->leftover + i] = m[i];
+#endif
+        st->leftover += bytes;
+    }
+}
+
+void
+poly1305_auth(u8 mac[16], const u8 *m, size_t bytes, const u8 key[32])
+{
+    struct poly1305_context ctx;
+    poly1305_init(&ctx, key);
+    poly1305_update(&ctx, m, bytes);
+    poly1305_finish(&ctx, mac);
+}
+
+#if defined(CONFIG_CRYPTO_CIPHER_POLY1305_AVX2) || \
+    defined(CONFIG_CRYPTO_CIPHER_POLY1305_NEON)
+/* states handed to the lanes per call */
+#define POLY1305_MB_STATES 16
+
+static void
+poly1305_update_lanes(struct poly1305_context *const *ctx, const u8 *const *m,
+                      const size_t *len, unsigned int n)
+{
+    struct poly1305_state64 *st[POLY1305_MB_STATES];
+    const u8 *p[POLY1305_MB_STATES];
+    size_t blocks[POLY1305_MB_STATES], rest[POLY1305_MB_STATES];
+    unsigned int i, j, c;
+
+    for (i = 0; i < n; i += c) {
+        c = n - i < POLY1305_MB_STATES ? n - i : POLY1305_MB_STATES;
+        for (j = 0; j < c; j++) {
+            const u8 *mj = m[i + j];
+            size_t lj = len[i + j];
+
+            /* complete a partly filled block first */
+            st[j] = (struct poly1305_state64 *)ctx[i + j];
+            if (st[j]->leftover) {
+                size_t want = POLY1305_BLOCK_SIZE - st[j]->leftover;
+                if (want > lj)
+                    want = lj;
+                poly1305_update(ctx[i + j], mj, want);
+                mj += want;
+                lj -= want;
+            }
+            p[j] = mj;
+            blocks[j] = lj / POLY1305_BLOCK_SIZE;
+            rest[j] = lj % POLY1305_BLOCK_SIZE;
+        }
+
+#if defined(CONFIG_CRYPTO_CIPHER_POLY1305_AVX2)
+        poly1305_blocks_avx2_mb(st, p, blocks, c);
+#else
+        poly1305_blocks_neon_mb(st, p, blocks, c);
+#endif
+
+        for (j = 0; j < c; j++)
+            if (rest[j])
+                poly1305_update(ctx[i + j],
+                                p[j] + blocks[j] * POLY1305_BLOCK_SIZE,
+                                rest[j]);
+    }
+}
+#endif
+
+void
+poly1305_update_mb(struct poly1305_context *const *ctx, const u8 *const *m,
+                   const size_t *len, unsigned int n)
+{
+    unsigned int i;
+
+    /* fewer messages than lanes lose to the scalar loop */
+#if defined(CONFIG_CRYPTO_CIPHER_POLY1305_AVX2)
+    if (n >= 4 && have_avx2()) {
+        poly1305_update_lanes(ctx, m, len, n);
+        return;
+    }
+#elif defined(CONFIG_CRYPTO_CIPHER_POLY1305_NEON)
+    if (n > 1) {
+        poly1305_update_lanes(ctx, m, len, n);
+        return;
+    }
+#endif
+    for (i = 0; i < n; i++)
+        poly1305_update(ctx[i], m[i], len[i]);
+}
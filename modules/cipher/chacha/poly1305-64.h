@@ -0,0 +1,129 @@
+/*
+poly1305 implementation using 64 bit * 64 bit = 128 bit multiplication and 128 bit addition
+public domain
+
+State and limb conversions shared by poly1305-64.c and the AVX2/NEON block
+functions (poly1305-avx2.c, poly1305-neon.c).
+*/
+
+#ifndef POLY1305_64_H
+#define POLY1305_64_H
+
+#include <crypto/cipher/poly1305.h>
+
+typedef unsigned __int128 uint128_t;
+
+/* the SIMD block functions take over from this many bytes per call */
+#define POLY1305_SIMD_MIN 128
+
+/*
+ * struct poly1305_context reinterpreted: h and r in 44/44/42 bit limbs, and
+ * for the vector lanes r^4, r^3, r^2, r^1 in 26 bit limbs, rp[limb][lane],
+ * computed on the first SIMD call (powers != 0).
+ */
+struct poly1305_state64 {
+    u64 r[3];
+    u64 h[3];
+    u64 pad[2];
+    size_t leftover;
+    u8 buffer[POLY1305_BLOCK_SIZE];
+    u8 final;
+    u8 powers;
+    u32 rp[5][4];
+};
+
+_Static_assert(sizeof(struct poly1305_state64) <= sizeof(struct poly1305_context),
+               "POLY1305_CTX_ACCEL_HEADROOM too small for poly1305_state64");
+
+/* h *= r (partial) mod 2^130 - 5 */
+static inline void
+poly1305_mul64(u64 h[3], const u64 r[3])
+{
+    const u64 s1 = r[1] * (5 << 2);
+    const u64 s2 = r[2] * (5 << 2);
+    uint128_t d0, d1, d2;
+    u64 c;
+
+    d0 = (uint128_t)h[0] * r[0] + (uint128_t)h[1] * s2 + (uint128_t)h[2] * s1;
+    d1 = (uint128_t)h[0] * r[1] + (uint128_t)h[1] * r[0] + (uint128_t)h[2] * s2;
+    d2 = (uint128_t)h[0] * r[2] + (uint128_t)h[1] * r[1] + (uint128_t)h[2] * r[0];
+
+                          c = (u64)(d0 >> 44); h[0] = (u64)d0 & 0xfffffffffff;
+    d1 += c;              c = (u64)(d1 >> 44); h[1] = (u64)d1 & 0xfffffffffff;
+    d2 += c;              c = (u64)(d2 >> 42); h[2] = (u64)d2 & 0x3ffffffffff;
+    h[0] += c * 5;        c = (h[0] >> 44);    h[0] = h[0] & 0xfffffffffff;
+    h[1] += c;
+}
+
+/* 44/44/42 bit limbs (partially carried) to 26 bit limbs, same value */
+static inline void
+poly1305_to26(const u64 h[3], u64 l[5])
+{
+    u64 t = h[0];
+
+    l[0] = t & 0x3ffffff; t >>= 26;
+    t += h[1] << 18;
+    l[1] = t & 0x3ffffff; t >>= 26;
+    l[2] = t & 0x3ffffff; t >>= 26;
+    t += h[2] << 10;
+    l[3] = t & 0x3ffffff; t >>= 26;
+    l[4] = t;
+}
+
+/* 26 bit limbs (each below 2^28) back to 44/44/42 bit limbs, mod 2^130 - 5 */
+static inline void
+poly1305_from26(const u64 l[5], u64 h[3])
+{
+    u64 t = l[0] + (l[1] << 26);
+
+    h[0] = t & 0xfffffffffff; t >>= 44;
+    t += (l[2] << 8) + (l[3] << 34);
+    h[1] = t & 0xfffffffffff; t >>= 44;
+    t += l[4] << 16;
+    h[2] = t & 0x3ffffffffff; t >>= 42;
+    h[0] += t * 5;
+}
+
+static inline void
+poly1305_powers(struct poly1305_state64 *st)
+{
+    u64 p[4][3], l[5];
+    int i, k;
+
+    for (k = 0; k < 3; k++)
+        p[0][k] = p[1][k] = st->r[k];
+    poly1305_mul64(p[1], st->r);            /* r^2 */
+    for (k = 0; k < 3; k++)
+        p[2][k] = p[3][k] = p[1][k];
+    poly1305_mul64(p[2], st->r);            /* r^3 */
+    poly1305_mul64(p[3], p[1]);             /* r^4 */
+
+    for (i = 0; i < 4; i++) {
+        poly1305_to26(p[i], l);
+        for (k = 0; k < 5; k++)
+            st->rp[k][3 - i] = (u32)l[k];
+    }
+    st->powers = 1;
+}
+
+/*
+ * The _mb variants absorb full blocks (hibit set) of |n| states, a state per
+ * lane: st[i] takes blocks[i] blocks at m[i]. A lane moves on to the next
+ * state when its own runs out.
+ */
+#if defined(CONFIG_CRYPTO_CIPHER_POLY1305_AVX2)
+/* full 4-block strides of |bytes| (hibit set), returns the bytes consumed */
+size_t poly1305_blocks_avx2(struct poly1305_state64 *st, const u8 *m, size_t bytes);
+void poly1305_blocks_avx2_mb(struct poly1305_state64 *const *st,
+                             const u8 *const *m, const size_t *blocks,
+                             unsigned int n);
+#endif
+#if defined(CONFIG_CRYPTO_CIPHER_POLY1305_NEON)
+/* full 2-block strides of |bytes| (hibit set), returns the bytes consumed */
+size_t poly1305_blocks_neon(struct poly1305_state64 *st, const u8 *m, size_t bytes);
+void poly1305_blocks_neon_mb(struct poly1305_state64 *const *st,
+                             const u8 *const *m, const size_t *blocks,
+                             unsigned int n);
+#endif
+
+#endif /* POLY1305_64_H */
@@ -0,0 +1,207 @@
+/*
+Poly1305 blocks, four at a time with AVX2 (built with -mavx2, called from
+poly1305-64.c only on CPUs that have it).
+
+Lane i accumulates blocks i, i + 4, i + 8, ... in 26 bit limbs, one limb per
+64 bit element: each stride multiplies all lanes by r^4 and adds the next
+four blocks, and the last stride multiplies the lanes by r^4, r^3, r^2, r^1
+and sums them, which equals hashing the blocks one by one.
+
+poly1305_blocks_avx2_mb instead gives each lane a message of its own, with
+its own h and r, and multiplies by r once per block.
+public domain
+*/
+
+#include <immintrin.h>
+#include "poly1305-64.h"
+
+#define MUL(a, b) _mm256_mul_epu32(a, b)
+#define ADD(a, b) _mm256_add_epi64(a, b)
+
+/* blocks 0, 1 in |a| and 2, 3 in |b| as 26 bit limbs, lane i holding block
+ * i, plus |hib| (2^128 where set) */
+static inline void
+split4(__m256i l[5], __m256i a, __m256i b, __m256i hib)
+{
+    const __m256i mask = _mm256_set1_epi64x(0x3ffffff);
+    __m256i lo = _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a, b), 0xd8);
+    __m256i hi = _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(a, b), 0xd8);
+
+    l[0] = _mm256_and_si256(lo, mask);
+    l[1] = _mm256_and_si256(_mm256_srli_epi64(lo, 26), mask);
+    l[2] = _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(lo, 52),
+                                            _mm256_slli_epi64(hi, 12)), mask);
+    l[3] = _mm256_and_si256(_mm256_srli_epi64(hi, 14), mask);
+    l[4] = _mm256_or_si256(_mm256_srli_epi64(hi, 40), hib);
+}
+
+/* four blocks as 26 bit limbs with 2^128 set, lane i holding m[16 * i] */
+static inline void
+load4(__m256i l[5], const u8 *m)
+{
+    split4(l, _mm256_loadu_si256((const __m256i *)(m +  0)),
+           _mm256_loadu_si256((const __m256i *)(m + 32)),
+           _mm256_set1_epi64x(1 << 24));
+}
+
+/* one block from each of p[0..3], lane i holding p[i] */
+static inline void
+gather4(__m256i l[5], const u8 *const p[4], __m256i hib)
+{
+#define LD(q) _mm_loadu_si128((const __m128i *)(q))
+    split4(l, _mm256_inserti128_si256(_mm256_castsi128_si256(LD(p[0])), LD(p[1]), 1),
+           _mm256_inserti128_si256(_mm256_castsi128_si256(LD(p[2])), LD(p[3]), 1),
+           hib);
+#undef LD
+}
+
+/* h *= r (partial) mod 2^130 - 5 per lane, s = 5 * r */
+static inline void
+mul4(__m256i h[5], const __m256i r[5], const __m256i s[5])
+{
+    const __m256i mask = _mm256_set1_epi64x(0x3ffffff);
+    __m256i d0, d1, d2, d3, d4, c;
+
+    d0 = ADD(ADD(ADD(ADD(MUL(h[0], r[0]), MUL(h[1], s[4])), MUL(h[2], s[3])), MUL(h[3], s[2])), MUL(h[4], s[1]));
+    d1 = ADD(ADD(ADD(ADD(MUL(h[0], r[1]), MUL(h[1], r[0])), MUL(h[2], s[4])), MUL(h[3], s[3])), MUL(h[4], s[2]));
+    d2 = ADD(ADD(ADD(ADD(MUL(h[0], r[2]), MUL(h[1], r[1])), MUL(h[2], r[0])), MUL(h[3], s[4])), MUL(h[4], s[3]));
+    d3 = ADD(ADD(ADD(ADD(MUL(h[0], r[3]), MUL(h[1], r[2])), MUL(h[2], r[1])), MUL(h[3], r[0])), MUL(h[4], s[4]));
+    d4 = ADD(ADD(ADD(ADD(MUL(h[0], r[4]), MUL(h[1], r[3])), MUL(h[2], r[2])), MUL(h[3], r[1])), MUL(h[4], r[0]));
+
+                       c = _mm256_srli_epi64(d0, 26); h[0] = _mm256_and_si256(d0, mask);
+    d1 = ADD(d1, c);   c = _mm256_srli_epi64(d1, 26); h[1] = _mm256_and_si256(d1, mask);
+    d2 = ADD(d2, c);   c = _mm256_srli_epi64(d2, 26); h[2] = _mm256_and_si256(d2, mask);
+    d3 = ADD(d3, c);   c = _mm256_srli_epi64(d3, 26); h[3] = _mm256_and_si256(d3, mask);
+    d4 = ADD(d4, c);   c = _mm256_srli_epi64(d4, 26); h[4] = _mm256_and_si256(d4, mask);
+    h[0] = ADD(h[0], ADD(c, _mm256_slli_epi64(c, 2)));
+    c = _mm256_srli_epi64(h[0], 26); h[0] = _mm256_and_si256(h[0], mask);
+    h[1] = ADD(h[1], c);
+}
+
+size_t
+poly1305_blocks_avx2(struct poly1305_state64 *st, const u8 *m, size_t bytes)
+{
+    const size_t done = bytes & ~(size_t)63;
+    __m256i h[5], x[5], r[5], s[5];
+    u64 l[5];
+    int k;
+
+    if (done == 0)
+        return 0;
+
+    /* lane 0 carries h into the first stride */
+    poly1305_to26(st->h, l);
+    load4(h, m);
+    for (k = 0; k < 5; k++) {
+        h[k] = ADD(h[k], _mm256_set_epi64x(0, 0, 0, (long long)l[k]));
+        r[k] = _mm256_set1_epi64x(st->rp[k][0]);
+        s[k] = ADD(r[k], _mm256_slli_epi64(r[k], 2));
+    }
+
+    for (m += 64, bytes = done - 64; bytes; m += 64, bytes -= 64) {
+        mul4(h, r, s);
+        load4(x, m);
+        for (k = 0; k < 5; k++)
+            h[k] = ADD(h[k], x[k]);
+    }
+
+    for (k = 0; k < 5; k++) {
+        r[k] = _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *)st->rp[k]));
+        s[k] = ADD(r[k], _mm256_slli_epi64(r[k], 2));
+    }
+    mul4(h, r, s);
+
+    for (k = 0; k < 5; k++) {
+        __m128i t = _mm_add_epi64(_mm256_castsi256_si128(h[k]),
+                                  _mm256_extracti128_si256(h[k], 1));
+        l[k] = (u64)_mm_cvtsi128_si64(t) + (u64)_mm_extract_epi64(t, 1);
+    }
+    poly1305_from26(l, st->h);
+    return done;
+}
+
+void
+poly1305_blocks_avx2_mb(struct poly1305_state64 *const *st,
+                        const u8 *const *m, const size_t *blocks,
+                        unsigned int n)
+{
+    static const u8 zero[POLY1305_BLOCK_SIZE];
+    u64 hl[5][4], rl[5][4], hib[4], l[5];
+    const u8 *p[4];
+    size_t left[4], step, j;
+    unsigned int next = 0, i, stride[4];
+    int job[4], k, busy;
+    __m256i h[5], x[5], r[5], s[5], hb;
+
+    for (i = 0; i < 4; i++)
+        job[i] = -1;
+
+    for (;;) {
+        /* lanes that ran out hand their state back and take the next one */
+        for (i = 0; i < 4; i++) {
+            if (job[i] >= 0 && left[i])
+                continue;
+            if (job[i] >= 0) {
+                for (k = 0; k < 5; k++)
+                    l[k] = hl[k][i];
+                poly1305_from26(l, st[job[i]]->h);
+            }
+            while (next < n && !blocks[next])
+                next++;
+            if (next == n) {
+                /* idle: h = 0 absorbing zero blocks without 2^128 */
+                job[i] = -1;
+                p[i] = zero;
+                stride[i] = 0;
+                left[i] = 0;
+                hib[i] = 0;
+                for (k = 0; k < 5; k++)
+                    hl[k][i] = rl[k][i] = 0;
+                continue;
+            }
+            job[i] = (int)next;
+            p[i] = m[next];
+            stride[i] = POLY1305_BLOCK_SIZE;
+            left[i] = blocks[next];
+            hib[i] = 1 << 24;
+            poly1305_to26(st[next]->h, l);
+            for (k = 0; k < 5; k++)
+                hl[k][i] = l[k];
+            poly1305_to26(st[next]->r, l);
+            for (k = 0; k < 5; k++)
+                rl[k][i] = l[k];
+            next++;
+        }
+
+        /* run every lane until the first busy one is done */
+        busy = 0;
+        step = 0;
+        for (i = 0; i < 4; i++)
+            if (job[i] >= 0 && (!busy++ || left[i] < step))
+                step = left[i];
+        if (!busy)
+            break;
+
+        for (k = 0; k < 5; k++) {
+            h[k] = _mm256_loadu_si256((const __m256i *)hl[k]);
+            r[k] = _mm256_loadu_si256((const __m256i *)rl[k]);
+            s[k] = ADD(r[k], _mm256_slli_epi64(r[k], 2));
+        }
+        hb = _mm256_loadu_si256((const __m256i *)hib);
+
+        for (j = 0; j < step; j++) {
+            gather4(x, p, hb);
+            for (k = 0; k < 5; k++)
+                h[k] = ADD(h[k], x[k]);
+            mul4(h, r, s);
+            for (i = 0; i < 4; i++)
+                p[i] += stride[i];
+        }
+
+        for (k = 0; k < 5; k++)
+            _mm256_storeu_si256((__m256i *)hl[k], h[k]);
+        for (i = 0; i < 4; i++)
+            if (job[i] >= 0)
+                left[i] -= step;
+    }
+}
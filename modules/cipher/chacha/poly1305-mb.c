@@ -0,0 +1,60 @@
+/*
+poly1305 tags for many (key, message) pairs, on the poly1305_update_mb of
+whichever implementation is linked (poly1305.c or poly1305-64.c)
+public domain
+*/
+
+#include <crypto/cipher/poly1305.h>
+
+/* contexts per poly1305_update_mb call, kept on the stack */
+#define POLY1305_MB_CHUNK 16
+
+static unsigned int
+poly1305_mb(struct poly1305_mb *job, unsigned int n, int verify)
+{
+    struct poly1305_context ctx[POLY1305_MB_CHUNK];
+    struct poly1305_context *cp[POLY1305_MB_CHUNK];
+    const u8 *m[POLY1305_MB_CHUNK];
+    size_t len[POLY1305_MB_CHUNK];
+    u8 mac[POLY1305_TAGLEN];
+    unsigned int i, j, k, c, diff, failed = 0;
+
+    for (i = 0; i < n; i += c) {
+        c = n - i < POLY1305_MB_CHUNK ? n - i : POLY1305_MB_CHUNK;
+        for (j = 0; j < c; j++) {
+            poly1305_init(&ctx[j], job[i + j].key);
+            cp[j] = &ctx[j];
+            m[j] = job[i + j].msg;
+            len[j] = job[i + j].len;
+        }
+
+        poly1305_update_mb(cp, m, len, c);
+
+        for (j = 0; j < c; j++) {
+            struct poly1305_mb *jb = &job[i + j];
+
+            if (!verify) {
+                poly1305_finish(&ctx[j], jb->mac);
+                continue;
+            }
+            poly1305_finish(&ctx[j], mac);
+            for (diff = 0, k = 0; k < POLY1305_TAGLEN; k++)
+                diff |= (unsigned int)(mac[k] ^ jb->mac[k]);
+            jb->status = diff != 0;
+            failed += (unsigned int)jb->status;
+        }
+    }
+    return failed;
+}
+
+void
+poly1305_auth_mb(struct poly1305_mb *job, unsigned int n)
+{
+    poly1305_mb(job, n, 0);
+}
+
+unsigned int
+poly1305_verify_mb(struct poly1305_mb *job, unsigned int n)
+{
+    return poly1305_mb(job, n, 1);
+}
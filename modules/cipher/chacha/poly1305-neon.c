@@ -0,0 +1,205 @@
+/*
+Poly1305 blocks, two at a time with AArch64 Advanced SIMD (always present,
+so poly1305-64.c calls it unconditionally).
+
+Lane i accumulates blocks i, i + 2, i + 4, ... in 26 bit limbs: each stride
+multiplies both lanes by r^2 (umull/umlal, 32 x 32 -> 64 bit) and adds the
+next two blocks, and the last stride multiplies the lanes by r^2, r^1 and
+sums them, which equals hashing the blocks one by one.
+
+poly1305_blocks_neon_mb instead gives each lane a message of its own, with
+its own h and r, and multiplies by r once per block.
+public domain
+*/
+
+#include <arm_neon.h>
+#include "poly1305-64.h"
+
+/* low and high halves of two blocks as 26 bit limbs, plus |hib| (2^128
+ * where set) */
+static inline void
+split2(uint64x2_t l[5], uint64x2_t lo, uint64x2_t hi, uint64x2_t hib)
+{
+    const uint64x2_t mask = vdupq_n_u64(0x3ffffff);
+
+    l[0] = vandq_u64(lo, mask);
+    l[1] = vandq_u64(vshrq_n_u64(lo, 26), mask);
+    l[2] = vandq_u64(vorrq_u64(vshrq_n_u64(lo, 52), vshlq_n_u64(hi, 12)), mask);
+    l[3] = vandq_u64(vshrq_n_u64(hi, 14), mask);
+    l[4] = vorrq_u64(vshrq_n_u64(hi, 40), hib);
+}
+
+/* two blocks as 26 bit limbs with 2^128 set, lane i holding m[16 * i] */
+static inline void
+load2(uint64x2_t l[5], const u8 *m)
+{
+    uint64x2x2_t v = vld2q_u64((const uint64_t *)m);
+
+    split2(l, v.val[0], v.val[1], vdupq_n_u64(1 << 24));
+}
+
+/* one block from each of p[0], p[1], lane i holding p[i] */
+static inline void
+gather2(uint64x2_t l[5], const u8 *const p[2], uint64x2_t hib)
+{
+    uint64_t lo[2], hi[2];
+
+    memcpy(&lo[0], p[0], 8);
+    memcpy(&hi[0], p[0] + 8, 8);
+    memcpy(&lo[1], p[1], 8);
+    memcpy(&hi[1], p[1] + 8, 8);
+    split2(l, vld1q_u64(lo), vld1q_u64(hi), hib);
+}
+
+/* h *= r (partial) mod 2^130 - 5 per lane, s = 5 * r */
+static inline void
+mul2(uint64x2_t h[5], const uint32x2_t r[5], const uint32x2_t s[5])
+{
+    const uint64x2_t mask = vdupq_n_u64(0x3ffffff);
+    uint32x2_t a0 = vmovn_u64(h[0]), a1 = vmovn_u64(h[1]), a2 = vmovn_u64(h[2]);
+    uint32x2_t a3 = vmovn_u64(h[3]), a4 = vmovn_u64(h[4]);
+    uint64x2_t d0, d1, d2, d3, d4, c;
+
+    d0 = vmlal_u32(vmlal_u32(vmlal_u32(vmlal_u32(vmull_u32(a0, r[0]), a1, s[4]), a2, s[3]), a3, s[2]), a4, s[1]);
+    d1 = vmlal_u32(vmlal_u32(vmlal_u32(vmlal_u32(vmull_u32(a0, r[1]), a1, r[0]), a2, s[4]), a3, s[3]), a4, s[2]);
+    d2 = vmlal_u32(vmlal_u32(vmlal_u32(vmlal_u32(vmull_u32(a0, r[2]), a1, r[1]), a2, r[0]), a3, s[4]), a4, s[3]);
+    d3 = vmlal_u32(vmlal_u32(vmlal_u32(vmlal_u32(vmull_u32(a0, r[3]), a1, r[2]), a2, r[1]), a3, r[0]), a4, s[4]);
+    d4 = vmlal_u32(vmlal_u32(vmlal_u32(vmlal_u32(vmull_u32(a0, r[4]), a1, r[3]), a2, r[2]), a3, r[1]), a4, r[0]);
+
+                             c = vshrq_n_u64(d0, 26); h[0] = vandq_u64(d0, mask);
+    d1 = vaddq_u64(d1, c);   c = vshrq_n_u64(d1, 26); h[1] = vandq_u64(d1, mask);
+    d2 = vaddq_u64(d2, c);   c = vshrq_n_u64(d2, 26); h[2] = vandq_u64(d2, mask);
+    d3 = vaddq_u64(d3, c);   c = vshrq_n_u64(d3, 26); h[3] = vandq_u64(d3, mask);
+    d4 = vaddq_u64(d4, c);   c = vshrq_n_u64(d4, 26); h[4] = vandq_u64(d4, mask);
+    h[0] = vaddq_u64(h[0], vaddq_u64(c, vshlq_n_u64(c, 2)));
+    c = vshrq_n_u64(h[0], 26); h[0] = vandq_u64(h[0], mask);
+    h[1] = vaddq_u64(h[1], c);
+}
+
+size_t
+poly1305_blocks_neon(struct poly1305_state64 *st, const u8 *m, size_t bytes)
+{
+    const size_t done = bytes & ~(size_t)31;
+    uint64x2_t h[5], x[5];
+    uint32x2_t r[5], s[5];
+    u64 l[5];
+    int k;
+
+    if (done == 0)
+        return 0;
+
+    /* lane 0 carries h into the first stride */
+    poly1305_to26(st->h, l);
+    load2(h, m);
+    for (k = 0; k < 5; k++) {
+        h[k] = vaddq_u64(h[k], vsetq_lane_u64(l[k], vdupq_n_u64(0), 0));
+        r[k] = vdup_n_u32(st->rp[k][2]);
+        s[k] = vmul_n_u32(r[k], 5);
+    }
+
+    for (m += 32, bytes = done - 32; bytes; m += 32, bytes -= 32) {
+        mul2(h, r, s);
+        load2(x, m);
+        for (k = 0; k < 5; k++)
+            h[k] = vaddq_u64(h[k], x[k]);
+    }
+
+    for (k = 0; k < 5; k++) {
+        r[k] = vld1_u32(&st->rp[k][2]);
+        s[k] = vmul_n_u32(r[k], 5);
+    }
+    mul2(h, r, s);
+
+    for (k = 0; k < 5; k++)
+        l[k] = vaddvq_u64(h[k]);
+    poly1305_from26(l, st->h);
+    return done;
+}
+
+void
+poly1305_blocks_neon_mb(struct poly1305_state64 *const *st,
+                        const u8 *const *m, const size_t *blocks,
+                        unsigned int n)
+{
+    static const u8 zero[POLY1305_BLOCK_SIZE];
+    uint64_t hl[5][2], rl[5][2], hib[2];
+    u64 l[5];
+    const u8 *p[2];
+    size_t left[2], step, j;
+    unsigned int next = 0, i, stride[2];
+    int job[2], k, busy;
+    uint64x2_t h[5], x[5], hb;
+    uint32x2_t r[5], s[5];
+
+    for (i = 0; i < 2; i++)
+        job[i] = -1;
+
+    for (;;) {
+        /* lanes that ran out hand their state back and take the next one */
+        for (i = 0; i < 2; i++) {
+            if (job[i] >= 0 && left[i])
+                continue;
+            if (job[i] >= 0) {
+                for (k = 0; k < 5; k++)
+                    l[k] = hl[k][i];
+                poly1305_from26(l, st[job[i]]->h);
+            }
+            while (next < n && !blocks[next])
+                next++;
+            if (next == n) {
+                /* idle: h = 0 absorbing zero blocks without 2^128 */
+                job[i] = -1;
+                p[i] = zero;
+                stride[i] = 0;
+                left[i] = 0;
+                hib[i] = 0;
+                for (k = 0; k < 5; k++)
+                    hl[k][i] = rl[k][i] = 0;
+                continue;
+            }
+            job[i] = (int)next;
+            p[i] = m[next];
+            stride[i] = POLY1305_BLOCK_SIZE;
+            left[i] = blocks[next];
+            hib[i] = 1 << 24;
+            poly1305_to26(st[next]->h, l);
+            for (k = 0; k < 5; k++)
+                hl[k][i] = l[k];
+            poly1305_to26(st[next]->r, l);
+            for (k = 0; k < 5; k++)
+                rl[k][i] = l[k];
+            next++;
+        }
+
+        /* run both lanes until the first busy one is done */
+        busy = 0;
+        step = 0;
+        for (i = 0; i < 2; i++)
+            if (job[i] >= 0 && (!busy++ || left[i] < step))
+                step = left[i];
+        if (!busy)
+            break;
+
+        for (k = 0; k < 5; k++) {
+            h[k] = vld1q_u64(hl[k]);
+            r[k] = vmovn_u64(vld1q_u64(rl[k]));
+            s[k] = vmul_n_u32(r[k], 5);
+        }
+        hb = vld1q_u64(hib);
+
+        for (j = 0; j < step; j++) {
+            gather2(x, p, hb);
+            for (k = 0; k < 5; k++)
+                h[k] = vaddq_u64(h[k], x[k]);
+            mul2(h, r, s);
+            for (i = 0; i < 2; i++)
+                p[i] += stride[i];
+        }
+
+        for (k = 0; k < 5; k++)
+            vst1q_u64(hl[k], h[k]);
+        for (i = 0; i < 2; i++)
+            if (job[i] >= 0)
+                left[i] -= step;
+    }
+}
@@ -261,3 +261,13 @@ poly1305_auth(u8 mac[16], const u8 *m, size_t bytes, const u8 key[32])
     poly1305_update(&ctx, m, bytes);
     poly1305_finish(&ctx, mac);
 }
+
+void
+poly1305_update_mb(struct poly1305_context *const *ctx, const u8 *const *m,
+                   const size_t *len, unsigned int n)
+{
+    unsigned int i;
+
+    for (i = 0; i < n; i++)
+        poly1305_update(ctx[i], m[i], len[i]);
+}
@@ -46,6 +46,8 @@ digest_get_desc(enum algorithm_digest id)
 #define DIGEST_SHA1_IMPL_DESC "aws-lc, x86_64, SHA-NI"
 #elif defined(CONFIG_CRYPTO_SHA1_AWS_ARMV8)
 #define DIGEST_SHA1_IMPL_DESC "aws-lc, ARMv8"
+#elif defined(CONFIG_CRYPTO_SHA1_AWS_DISPATCH)
+#define DIGEST_SHA1_IMPL_DESC "aws-lc, runtime dispatch"
 #elif defined(CONFIG_CRYPTO_SHA1_GENERIC)
 #define DIGEST_SHA1_IMPL_DESC "generic"
 #else
@@ -65,6 +67,8 @@ digest_get_desc(enum algorithm_digest id)
 #define DIGEST_SHA2_IMPL_DESC "aws-lc, x86_64, SHA-NI"
 #elif defined(CONFIG_CRYPTO_SHA2_AWS_ARMV8)
 #define DIGEST_SHA2_IMPL_DESC "aws-lc, ARMv8"
+#elif defined(CONFIG_CRYPTO_SHA2_AWS_DISPATCH)
+#define DIGEST_SHA2_IMPL_DESC "aws-lc, runtime dispatch"
 #elif defined(CONFIG_CRYPTO_SHA2_GENERIC)
 #define DIGEST_SHA2_IMPL_DESC "generic"
 #else
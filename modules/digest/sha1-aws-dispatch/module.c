@@ -0,0 +1,13 @@
+#include <crypto/digest.h>
+
+/* desc names the kernel sha1-dispatch.c picked for this CPU */
+static struct digest_algorithm sha1_aws_dispatch = {
+	.name = "sha1-160",
+	.id = ALGORITHM_SHA1_160,
+};
+
+static void __init__ digest_sha1_aws_dispatch_init(void)
+{
+	sha1_aws_dispatch.desc = sha1_kernel_desc();
+	crypto_digest_register(&sha1_aws_dispatch);
+}
@@ -0,0 +1,136 @@
+/*
+ * SHA-1 block functions of every aws-lc code path the target has, one of
+ * which is picked at startup from the CPU capability vector (CPUID on x86_64,
+ * getauxval(AT_HWCAP) on AArch64) and stored in sha1_block_kernel, which the
+ * inline update/final code in built-in.h calls through. Same scheme as
+ * ../sha2-aws-dispatch/sha2-dispatch.c.
+ */
+#include <hpc/compiler.h>
+#include <crypto/digest.h>
+#include <crypto/init.h>
+
+struct sha1_kernel {
+	fn_sha1_block block;
+	int (*usable)(void);
+	const char *desc;
+};
+
+static int cpu_any(void)
+{
+	return 1;
+}
+
+#if defined(__x86_64__)
+extern void sha1_block_data_order_hw(void *c, const void *p, size_t n);
+extern void sha1_block_data_order_avx2(void *c, const void *p, size_t n);
+extern void sha1_block_data_order_avx(void *c, const void *p, size_t n);
+extern void sha1_block_data_order_ssse3(void *c, const void *p, size_t n);
+extern void sha1_block_data_order_nohw(void *c, const void *p, size_t n);
+
+static int have_ssse3(void)
+{
+	return OPENSSL_ia32cap_P[1] & (1u << 9);	/* leaf1 ECX bit 9 */
+}
+
+static int have_shani(void)
+{
+	/* leaf7 EBX bit 29 (SHA); the aws-lc kernel also uses pshufb */
+	return (OPENSSL_ia32cap_P[2] & (1u << 29)) && have_ssse3();
+}
+
+static int have_avx(void)
+{
+	/* leaf1 ECX bit 28, cleared unless the OS saves the YMM state */
+	return (OPENSSL_ia32cap_P[1] & (1u << 28)) && have_ssse3();
+}
+
+static int have_avx2(void)
+{
+	/* leaf7 EBX bits 5 (AVX2), 3 (BMI1) and 8 (BMI2): rorx/andn */
+	const unsigned int bits = (1u << 5) | (1u << 3) | (1u << 8);
+
+	return (OPENSSL_ia32cap_P[2] & bits) == bits && have_avx();
+}
+
+static int cpu_caps_empty(void)
+{
+	return !OPENSSL_ia32cap_P[0] && !OPENSSL_ia32cap_P[1];
+}
+
+/* best first */
+static const struct sha1_kernel sha1_kernels[] = {
+	{ sha1_block_data_order_hw, have_shani,
+	  "SHA1-160 (aws-lc, x86_64, SHA-NI)" },
+	{ sha1_block_data_order_avx2, have_avx2,
+	  "SHA1-160 (aws-lc, x86_64, AVX2)" },
+	{ sha1_block_data_order_avx, have_avx,
+	  "SHA1-160 (aws-lc, x86_64, AVX)" },
+	{ sha1_block_data_order_ssse3, have_ssse3,
+	  "SHA1-160 (aws-lc, x86_64, SSSE3)" },
+	{ sha1_block_data_order_nohw, cpu_any,
+	  "SHA1-160 (aws-lc, x86_64)" },
+};
+#elif defined(__aarch64__)
+extern void sha1_block_data_order_hw(void *c, const void *p, size_t n);
+extern void sha1_block_data_order_nohw(void *c, const void *p, size_t n);
+
+static int have_sha1(void)
+{
+	return OPENSSL_armcap_P & ARMV8_SHA1;
+}
+
+static int cpu_caps_empty(void)
+{
+	return !OPENSSL_armcap_P;
+}
+
+/* best first */
+static const struct sha1_kernel sha1_kernels[] = {
+	{ sha1_block_data_order_hw, have_sha1,
+	  "SHA1-160 (aws-lc, ARMv8, SHA1)" },
+	{ sha1_block_data_order_nohw, cpu_any,
+	  "SHA1-160 (aws-lc, ARMv8)" },
+};
+#else
+#error "unsupported architecture for the aws-lc SHA-1 dispatch"
+#endif
+
+static void sha1_block_resolve(void *c, const void *p, size_t n);
+
+fn_sha1_block sha1_block_kernel = sha1_block_resolve;
+
+static const struct sha1_kernel *sha1_kernel;
+
+static void
+sha1_kernel_select(void)
+{
+	const struct sha1_kernel *k = sha1_kernels;
+
+	if (cpu_caps_empty())
+		crypto_init();
+	while (!k->usable())
+		k++;
+	sha1_kernel = k;
+	sha1_block_kernel = k->block;
+}
+
+static void
+sha1_block_resolve(void *c, const void *p, size_t n)
+{
+	sha1_kernel_select();
+	sha1_block_kernel(c, p, n);
+}
+
+const char *
+sha1_kernel_desc(void)
+{
+	if (!sha1_kernel)
+		sha1_kernel_select();
+	return sha1_kernel->desc;
+}
+
+static void __init__
+sha1_kernel_init(void)
+{
+	sha1_kernel_select();
+}
@@ -56,13 +56,15 @@ sha256_block_data_order(void *ctx, const void *in, size_t num)
 	sha256_block_data_order_hw(ctx, in, num);
 }
 
-extern void sha512_block_data_order_hw(struct sha512 *ctx, const void *in, size_t num);
+/* SHA512 extension kernel or scalar aws-lc, picked in sha512_block.c */
+extern void (*sha512_armv8_block_kernel)(void *ctx, const void *in, size_t num);
 
 static inline void
 sha512_block_data_order(void *ctx, const void *in, size_t num)
 {
-	sha512_block_data_order_hw(ctx, in, num);
+	sha512_armv8_block_kernel(ctx, in, num);
 }
+
 static inline void
 arch_sha224_init(struct sha256 *c)
 {
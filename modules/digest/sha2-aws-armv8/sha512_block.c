@@ -1,22 +1,39 @@
+/*
+ * SHA-512 block function of the ARMv8 backend: the SHA512 crypto extension
+ * (sha512h, ARMv8.2) when HWCAP has it, aws-lc's scalar code otherwise --
+ * ARMv8.0 cores with only SHA1/SHA2 fault on the _hw kernel. Picked once,
+ * like ../sha2-aws-dispatch.
+ */
 #include <hpc/compiler.h>
+#include <crypto/init.h>
 
-#define SHA_LBLOCK 16
-#define SHA512_CBLOCK (SHA_LBLOCK * 8)
+typedef void (*fn_sha512_block)(void *ctx, const void *in, size_t num);
 
-typedef struct {
-    u64 h[8];
-    u64 Nl, Nh;
-    union {
-        u64 d[SHA_LBLOCK];
-        unsigned char p[SHA512_CBLOCK];
-    } u;
-    unsigned int num, md_len;
-} SHA512_CTX;
+extern void sha512_block_data_order_hw(void *ctx, const void *in, size_t num);
+extern void sha512_block_data_order_nohw(void *ctx, const void *in, size_t num);
 
-extern void sha512_block_data_order_hw(SHA512_CTX *ctx, const void *in, size_t num);
+static void sha512_armv8_block_resolve(void *ctx, const void *in, size_t num);
 
-void
-sha512_block_data_order(void *ctx, const void *in, size_t num)
+fn_sha512_block sha512_armv8_block_kernel = sha512_armv8_block_resolve;
+
+static void
+sha512_armv8_block_select(void)
+{
+	if (!OPENSSL_armcap_P)
+		crypto_init();
+	sha512_armv8_block_kernel = (OPENSSL_armcap_P & ARMV8_SHA512) ?
+		sha512_block_data_order_hw : sha512_block_data_order_nohw;
+}
+
+static void
+sha512_armv8_block_resolve(void *ctx, const void *in, size_t num)
+{
+	sha512_armv8_block_select();
+	sha512_armv8_block_kernel(ctx, in, num);
+}
+
+static void __init__
+sha512_armv8_block_init(void)
 {
-	sha512_block_data_order_hw(ctx, in, num);
+	sha512_armv8_block_select();
 }
@@ -0,0 +1,34 @@
+#include <crypto/digest.h>
+
+/* desc names the kernel sha2-dispatch.c picked for this CPU */
+static struct digest_algorithm sha2_aws_dispatch_224 = {
+	.name = "sha2-224",
+	.id = ALGORITHM_SHA2_224,
+};
+
+static struct digest_algorithm sha2_aws_dispatch_256 = {
+	.name = "sha2-256",
+	.id = ALGORITHM_SHA2_256,
+};
+
+static struct digest_algorithm sha2_aws_dispatch_384 = {
+	.name = "sha2-384",
+	.id = ALGORITHM_SHA2_384,
+};
+
+static struct digest_algorithm sha2_aws_dispatch_512 = {
+	.name = "sha2-512",
+	.id = ALGORITHM_SHA2_512,
+};
+
+static void __init__ digest_sha2_aws_dispatch_init(void)
+{
+	sha2_aws_dispatch_224.desc = sha2_kernel_desc(ALGORITHM_SHA2_224);
+	sha2_aws_dispatch_256.desc = sha2_kernel_desc(ALGORITHM_SHA2_256);
+	sha2_aws_dispatch_384.desc = sha2_kernel_desc(ALGORITHM_SHA2_384);
+	sha2_aws_dispatch_512.desc = sha2_kernel_desc(ALGORITHM_SHA2_512);
+	crypto_digest_register(&sha2_aws_dispatch_224);
+	crypto_digest_register(&sha2_aws_dispatch_256);
+	crypto_digest_register(&sha2_aws_dispatch_384);
+	crypto_digest_register(&sha2_aws_dispatch_512);
+}
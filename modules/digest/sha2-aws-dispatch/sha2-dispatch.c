@@ -0,0 +1,214 @@
+/*
+ * SHA-256/SHA-512 block functions of every aws-lc code path the target has,
+ * one of which is picked per size at startup from the CPU capability vector
+ * (CPUID on x86_64, getauxval(AT_HWCAP) on AArch64) and stored in
+ * sha256_block_kernel / sha512_block_kernel. The inline update/final code in
+ * built-in.h calls through those pointers, so one binary runs the SHA-NI,
+ * AVX2, AVX, SSSE3 or scalar path of whichever CPU it lands on. The x86_64
+ * SHA512-extension kernel is ours (../sha2-aws-x86_64-shani/sha512ni-x86_64.S);
+ * aws-lc has none.
+ *
+ * The pointers start out at resolvers, so a digest taken before the
+ * constructor below has run (another constructor, say) still resolves on its
+ * first block. crypto_init() fills the vector first if no cap constructor has
+ * run yet.
+ */
+#include <hpc/compiler.h>
+#include <crypto/digest.h>
+#include <crypto/init.h>
+
+struct sha2_kernel {
+	fn_sha2_block block;
+	int (*usable)(void);
+	const char *desc[2];	/* SHA2-224/384, SHA2-256/512 */
+};
+
+static int cpu_any(void)
+{
+	return 1;
+}
+
+#if defined(__x86_64__)
+extern void sha256_block_data_order_hw(void *ctx, const void *in, size_t num);
+extern void sha256_block_data_order_avx2(void *ctx, const void *in, size_t num);
+extern void sha256_block_data_order_avx(void *ctx, const void *in, size_t num);
+extern void sha256_block_data_order_ssse3(void *ctx, const void *in, size_t num);
+extern void sha256_block_data_order_nohw(void *ctx, const void *in, size_t num);
+extern void sha512_block_data_order_hw(void *ctx, const void *in, size_t num);
+extern void sha512_block_data_order_avx2(void *ctx, const void *in, size_t num);
+extern void sha512_block_data_order_avx(void *ctx, const void *in, size_t num);
+extern void sha512_block_data_order_nohw(void *ctx, const void *in, size_t num);
+
+static int have_ssse3(void)
+{
+	return OPENSSL_ia32cap_P[1] & (1u << 9);	/* leaf1 ECX bit 9 */
+}
+
+static int have_shani(void)
+{
+	/* leaf7 EBX bit 29 (SHA); the aws-lc kernel also uses pshufb */
+	return (OPENSSL_ia32cap_P[2] & (1u << 29)) && have_ssse3();
+}
+
+static int have_avx(void)
+{
+	/* leaf1 ECX bit 28, cleared unless the OS saves the YMM state */
+	return (OPENSSL_ia32cap_P[1] & (1u << 28)) && have_ssse3();
+}
+
+static int have_avx2(void)
+{
+	/* leaf7 EBX bits 5 (AVX2), 3 (BMI1) and 8 (BMI2): rorx/andn */
+	const unsigned int bits = (1u << 5) | (1u << 3) | (1u << 8);
+
+	return (OPENSSL_ia32cap_P[2] & bits) == bits && have_avx();
+}
+
+static int have_sha512(void)
+{
+	/* leaf7.1 EAX bit 0 (word 5); VEX.256, so AVX2 as well */
+	return (OPENSSL_ia32cap_P[5] & 1u) && have_avx2();
+}
+
+static int cpu_caps_empty(void)
+{
+	return !OPENSSL_ia32cap_P[0] && !OPENSSL_ia32cap_P[1];
+}
+
+/* best first */
+static const struct sha2_kernel sha256_kernels[] = {
+	{ sha256_block_data_order_hw, have_shani,
+	  { "SHA2-224 (aws-lc, x86_64, SHA-NI)",
+	    "SHA2-256 (aws-lc, x86_64, SHA-NI)" } },
+	{ sha256_block_data_order_avx2, have_avx2,
+	  { "SHA2-224 (aws-lc, x86_64, AVX2)",
+	    "SHA2-256 (aws-lc, x86_64, AVX2)" } },
+	{ sha256_block_data_order_avx, have_avx,
+	  { "SHA2-224 (aws-lc, x86_64, AVX)",
+	    "SHA2-256 (aws-lc, x86_64, AVX)" } },
+	{ sha256_block_data_order_ssse3, have_ssse3,
+	  { "SHA2-224 (aws-lc, x86_64, SSSE3)",
+	    "SHA2-256 (aws-lc, x86_64, SSSE3)" } },
+	{ sha256_block_data_order_nohw, cpu_any,
+	  { "SHA2-224 (aws-lc, x86_64)",
+	    "SHA2-256 (aws-lc, x86_64)" } },
+};
+
+static const struct sha2_kernel sha512_kernels[] = {
+	{ sha512_block_data_order_hw, have_sha512,
+	  { "SHA2-384 (x86_64, SHA512)",
+	    "SHA2-512 (x86_64, SHA512)" } },
+	{ sha512_block_data_order_avx2, have_avx2,
+	  { "SHA2-384 (aws-lc, x86_64, AVX2)",
+	    "SHA2-512 (aws-lc, x86_64, AVX2)" } },
+	{ sha512_block_data_order_avx, have_avx,
+	  { "SHA2-384 (aws-lc, x86_64, AVX)",
+	    "SHA2-512 (aws-lc, x86_64, AVX)" } },
+	{ sha512_block_data_order_nohw, cpu_any,
+	  { "SHA2-384 (aws-lc, x86_64)",
+	    "SHA2-512 (aws-lc, x86_64)" } },
+};
+#elif defined(__aarch64__)
+extern void sha256_block_data_order_hw(void *ctx, const void *in, size_t num);
+extern void sha256_block_data_order_nohw(void *ctx, const void *in, size_t num);
+extern void sha512_block_data_order_hw(void *ctx, const void *in, size_t num);
+extern void sha512_block_data_order_nohw(void *ctx, const void *in, size_t num);
+
+static int have_sha256(void)
+{
+	return OPENSSL_armcap_P & ARMV8_SHA256;
+}
+
+static int have_sha512(void)
+{
+	return OPENSSL_armcap_P & ARMV8_SHA512;
+}
+
+static int cpu_caps_empty(void)
+{
+	return !OPENSSL_armcap_P;
+}
+
+/* best first */
+static const struct sha2_kernel sha256_kernels[] = {
+	{ sha256_block_data_order_hw, have_sha256,
+	  { "SHA2-224 (aws-lc, ARMv8, SHA2)",
+	    "SHA2-256 (aws-lc, ARMv8, SHA2)" } },
+	{ sha256_block_data_order_nohw, cpu_any,
+	  { "SHA2-224 (aws-lc, ARMv8)",
+	    "SHA2-256 (aws-lc, ARMv8)" } },
+};
+
+static const struct sha2_kernel sha512_kernels[] = {
+	{ sha512_block_data_order_hw, have_sha512,
+	  { "SHA2-384 (aws-lc, ARMv8, SHA512)",
+	    "SHA2-512 (aws-lc, ARMv8, SHA512)" } },
+	{ sha512_block_data_order_nohw, cpu_any,
+	  { "SHA2-384 (aws-lc, ARMv8)",
+	    "SHA2-512 (aws-lc, ARMv8)" } },
+};
+#else
+#error "unsupported architecture for the aws-lc SHA-2 dispatch"
+#endif
+
+static void sha256_block_resolve(void *ctx, const void *in, size_t num);
+static void sha512_block_resolve(void *ctx, const void *in, size_t num);
+
+fn_sha2_block sha256_block_kernel = sha256_block_resolve;
+fn_sha2_block sha512_block_kernel = sha512_block_resolve;
+
+static const struct sha2_kernel *sha256_kernel, *sha512_kernel;
+
+static const struct sha2_kernel *
+sha2_kernel_pick(const struct sha2_kernel *k)
+{
+	while (!k->usable())
+		k++;
+	return k;
+}
+
+static void
+sha2_kernel_select(void)
+{
+	if (cpu_caps_empty())
+		crypto_init();
+	sha256_kernel = sha2_kernel_pick(sha256_kernels);
+	sha512_kernel = sha2_kernel_pick(sha512_kernels);
+	sha256_block_kernel = sha256_kernel->block;
+	sha512_block_kernel = sha512_kernel->block;
+}
+
+static void
+sha256_block_resolve(void *ctx, const void *in, size_t num)
+{
+	sha2_kernel_select();
+	sha256_block_kernel(ctx, in, num);
+}
+
+static void
+sha512_block_resolve(void *ctx, const void *in, size_t num)
+{
+	sha2_kernel_select();
+	sha512_block_kernel(ctx, in, num);
+}
+
+const char *
+sha2_kernel_desc(unsigned int id)
+{
+	if (!sha256_kernel)
+		sha2_kernel_select();
+
+	switch (id) {
+	case ALGORITHM_SHA2_224: return sha256_kernel->desc[0];
+	case ALGORITHM_SHA2_256: return sha256_kernel->desc[1];
+	case ALGORITHM_SHA2_384: return sha512_kernel->desc[0];
+	case ALGORITHM_SHA2_512: return sha512_kernel->desc[1];
+	default:                 return "";
+	}
+}
+
+static void __init__
+sha2_kernel_init(void)
+{
+	sha2_kernel_select();
+}
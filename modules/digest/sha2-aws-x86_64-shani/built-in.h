@@ -56,12 +56,13 @@ sha256_block_data_order(void *ctx, const void *in, size_t num)
 	sha256_block_data_order_hw(ctx, in, num);
 }
 
-extern void sha512_block_data_order_nohw(struct sha512 *ctx, const void *in, size_t num);
+/* SHA512 extension kernel or scalar aws-lc, picked in sha512_block.c */
+extern void (*sha512_shani_block_kernel)(void *ctx, const void *in, size_t num);
 
 static inline void
 sha512_block_data_order(void *ctx, const void *in, size_t num)
 {
-	sha512_block_data_order_nohw(ctx, in, num);
+	sha512_shani_block_kernel(ctx, in, num);
 }
 
 static inline void
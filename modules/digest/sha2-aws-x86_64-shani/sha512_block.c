@@ -0,0 +1,44 @@
+/*
+ * SHA-512 block function of the SHA-NI backend. SHA-NI only covers SHA-1 and
+ * SHA-256; CPUs with the later SHA512 extension get sha512ni-x86_64.S, the
+ * rest aws-lc's scalar code. Picked once, like ../sha2-aws-dispatch.
+ */
+#include <hpc/compiler.h>
+#include <crypto/init.h>
+
+typedef void (*fn_sha512_block)(void *ctx, const void *in, size_t num);
+
+extern void sha512_block_data_order_hw(void *ctx, const void *in, size_t num);
+extern void sha512_block_data_order_nohw(void *ctx, const void *in, size_t num);
+
+static void sha512_shani_block_resolve(void *ctx, const void *in, size_t num);
+
+fn_sha512_block sha512_shani_block_kernel = sha512_shani_block_resolve;
+
+static int have_sha512(void)
+{
+	/* leaf7.1 EAX bit 0 (word 5); the kernel also needs AVX2 permutes */
+	return (OPENSSL_ia32cap_P[5] & 1u) && (OPENSSL_ia32cap_P[2] & (1u << 5));
+}
+
+static void
+sha512_shani_block_select(void)
+{
+	if (!OPENSSL_ia32cap_P[0] && !OPENSSL_ia32cap_P[1])
+		crypto_init();
+	sha512_shani_block_kernel = have_sha512() ?
+		sha512_block_data_order_hw : sha512_block_data_order_nohw;
+}
+
+static void
+sha512_shani_block_resolve(void *ctx, const void *in, size_t num)
+{
+	sha512_shani_block_select();
+	sha512_shani_block_kernel(ctx, in, num);
+}
+
+static void __init__
+sha512_shani_block_init(void)
+{
+	sha512_shani_block_select();
+}
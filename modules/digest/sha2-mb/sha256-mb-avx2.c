@@ -0,0 +1,94 @@
+/*
+ * Multi-buffer SHA-256, eight lanes of AVX2 (built with -mavx2, picked by
+ * sha256-mb.c only on CPUs that have it). Vector j of the state holds word
+ * j of all eight lanes; each block's message words get there with an 8x8
+ * transpose of the eight lanes' loads.
+ */
+#include <immintrin.h>
+#include "sha256-mb-kernel.h"
+
+#define ADD(a, b)   _mm256_add_epi32(a, b)
+#define XOR(a, b)   _mm256_xor_si256(a, b)
+#define ROR(x, n)   _mm256_or_si256(_mm256_srli_epi32(x, n), \
+                                    _mm256_slli_epi32(x, 32 - (n)))
+
+/* words 8k .. 8k + 7 of the eight lanes' block, w[i] holding word 8k + i */
+static inline void
+load8(__m256i w[8], const u8 *const *p, size_t off)
+{
+	const __m256i bswap = _mm256_setr_epi8(
+		3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+		3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+	__m256i r[8], t[8], u[8];
+
+	for (unsigned int i = 0; i < 8; i++)
+		r[i] = _mm256_loadu_si256((const __m256i *)(p[i] + off));
+	for (unsigned int i = 0; i < 8; i += 2) {
+		t[i] = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+		t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+	}
+	for (unsigned int i = 0; i < 8; i += 4) {
+		u[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+		u[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+		u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+		u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+	}
+	for (unsigned int i = 0; i < 4; i++) {
+		w[i] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x20);
+		w[i + 4] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x31);
+	}
+	for (unsigned int i = 0; i < 8; i++)
+		w[i] = _mm256_shuffle_epi8(w[i], bswap);
+}
+
+void
+sha256_mb_blocks_avx2(u32 h[8][SHA256_MB_LANES_MAX], const u8 *const *p,
+                      size_t blocks)
+{
+	__m256i s[8], w[16];
+
+	for (unsigned int i = 0; i < 8; i++)
+		s[i] = _mm256_loadu_si256((const __m256i *)h[i]);
+
+	for (size_t b = 0; b < blocks; b++) {
+		__m256i a = s[0], bb = s[1], c = s[2], d = s[3];
+		__m256i e = s[4], f = s[5], g = s[6], hh = s[7];
+
+		load8(w, p, b * 64);
+		load8(w + 8, p, b * 64 + 32);
+
+		for (unsigned int t = 0; t < 64; t++) {
+			__m256i x, t1, t2;
+
+			if (t >= 16) {
+				__m256i w15 = w[(t - 15) & 15], w2 = w[(t - 2) & 15];
+
+				x = XOR(XOR(ROR(w15, 7), ROR(w15, 18)),
+					_mm256_srli_epi32(w15, 3));
+				x = ADD(x, XOR(XOR(ROR(w2, 17), ROR(w2, 19)),
+					       _mm256_srli_epi32(w2, 10)));
+				w[t & 15] = ADD(ADD(w[t & 15], w[(t - 7) & 15]), x);
+			}
+
+			t1 = ADD(hh, XOR(XOR(ROR(e, 6), ROR(e, 11)), ROR(e, 25)));
+			t1 = ADD(t1, XOR(_mm256_and_si256(e, f),
+					 _mm256_andnot_si256(e, g)));
+			t1 = ADD(t1, ADD(_mm256_set1_epi32((int)sha256_mb_k[t]),
+					 w[t & 15]));
+			t2 = XOR(XOR(ROR(a, 2), ROR(a, 13)), ROR(a, 22));
+			t2 = ADD(t2, _mm256_or_si256(_mm256_and_si256(a, bb),
+						     _mm256_and_si256(c, _mm256_or_si256(a, bb))));
+
+			hh = g; g = f; f = e; e = ADD(d, t1);
+			d = c; c = bb; bb = a; a = ADD(t1, t2);
+		}
+
+		s[0] = ADD(s[0], a); s[1] = ADD(s[1], bb);
+		s[2] = ADD(s[2], c); s[3] = ADD(s[3], d);
+		s[4] = ADD(s[4], e); s[5] = ADD(s[5], f);
+		s[6] = ADD(s[6], g); s[7] = ADD(s[7], hh);
+	}
+
+	for (unsigned int i = 0; i < 8; i++)
+		_mm256_storeu_si256((__m256i *)h[i], s[i]);
+}
@@ -0,0 +1,101 @@
+/*
+ * Multi-buffer SHA-256, sixteen lanes of AVX-512F (built with -mavx512f,
+ * picked by sha256-mb.c only on CPUs that have it). Same shape as
+ * sha256-mb-avx2.c with vprord for the rotates and vpternlogd for Ch and
+ * Maj; the message words come from a 16x16 transpose.
+ */
+#include <immintrin.h>
+#include "sha256-mb-kernel.h"
+
+#define ADD(a, b)       _mm512_add_epi32(a, b)
+#define ROR(x, n)       _mm512_ror_epi32(x, n)
+#define XOR3(a, b, c)   _mm512_ternarylogic_epi32(a, b, c, 0x96)
+#define CH(e, f, g)     _mm512_ternarylogic_epi32(e, f, g, 0xca)
+#define MAJ(a, b, c)    _mm512_ternarylogic_epi32(a, b, c, 0xe8)
+
+/* the block of each of the sixteen lanes at |off|, w[i] holding word i */
+static inline void
+load16(__m512i w[16], const u8 *const *p, size_t off)
+{
+	const __m512i odd = _mm512_set1_epi32((int)0xff00ff00);
+	__m512i r[16], t[16], u[16];
+
+	/* byte swap without vpshufb (AVX512BW): bytes 3, 1 of x >>> 8 and
+	 * bytes 2, 0 of x <<< 8 */
+	for (unsigned int i = 0; i < 16; i++) {
+		__m512i x = _mm512_loadu_si512(p[i] + off);
+
+		r[i] = CH(odd, ROR(x, 8), _mm512_rol_epi32(x, 8));
+	}
+	for (unsigned int i = 0; i < 16; i += 2) {
+		t[i] = _mm512_unpacklo_epi32(r[i], r[i + 1]);
+		t[i + 1] = _mm512_unpackhi_epi32(r[i], r[i + 1]);
+	}
+	/* u[4g + m]: word 4k + m of lanes 4g .. 4g + 3 in 128 bit chunk k */
+	for (unsigned int i = 0; i < 16; i += 4) {
+		u[i] = _mm512_unpacklo_epi64(t[i], t[i + 2]);
+		u[i + 1] = _mm512_unpackhi_epi64(t[i], t[i + 2]);
+		u[i + 2] = _mm512_unpacklo_epi64(t[i + 1], t[i + 3]);
+		u[i + 3] = _mm512_unpackhi_epi64(t[i + 1], t[i + 3]);
+	}
+	for (unsigned int m = 0; m < 4; m++) {
+		__m512i lo01 = _mm512_shuffle_i32x4(u[m], u[4 + m], 0x44);
+		__m512i hi01 = _mm512_shuffle_i32x4(u[m], u[4 + m], 0xee);
+		__m512i lo23 = _mm512_shuffle_i32x4(u[8 + m], u[12 + m], 0x44);
+		__m512i hi23 = _mm512_shuffle_i32x4(u[8 + m], u[12 + m], 0xee);
+
+		w[m] = _mm512_shuffle_i32x4(lo01, lo23, 0x88);
+		w[4 + m] = _mm512_shuffle_i32x4(lo01, lo23, 0xdd);
+		w[8 + m] = _mm512_shuffle_i32x4(hi01, hi23, 0x88);
+		w[12 + m] = _mm512_shuffle_i32x4(hi01, hi23, 0xdd);
+	}
+}
+
+void
+sha256_mb_blocks_avx512(u32 h[8][SHA256_MB_LANES_MAX], const u8 *const *p,
+                        size_t blocks)
+{
+	__m512i s[8], w[16];
+
+	for (unsigned int i = 0; i < 8; i++)
+		s[i] = _mm512_loadu_si512(h[i]);
+
+	for (size_t b = 0; b < blocks; b++) {
+		__m512i a = s[0], bb = s[1], c = s[2], d = s[3];
+		__m512i e = s[4], f = s[5], g = s[6], hh = s[7];
+
+		load16(w, p, b * 64);
+
+		for (unsigned int t = 0; t < 64; t++) {
+			__m512i t1, t2;
+
+			if (t >= 16) {
+				__m512i w15 = w[(t - 15) & 15], w2 = w[(t - 2) & 15];
+
+				w[t & 15] = ADD(ADD(w[t & 15], w[(t - 7) & 15]),
+					ADD(XOR3(ROR(w15, 7), ROR(w15, 18),
+						 _mm512_srli_epi32(w15, 3)),
+					    XOR3(ROR(w2, 17), ROR(w2, 19),
+						 _mm512_srli_epi32(w2, 10))));
+			}
+
+			t1 = ADD(ADD(hh, XOR3(ROR(e, 6), ROR(e, 11), ROR(e, 25))),
+				 ADD(CH(e, f, g),
+				     ADD(_mm512_set1_epi32((int)sha256_mb_k[t]),
+					 w[t & 15])));
+			t2 = ADD(XOR3(ROR(a, 2), ROR(a, 13), ROR(a, 22)),
+				 MAJ(a, bb, c));
+
+			hh = g; g = f; f = e; e = ADD(d, t1);
+			d = c; c = bb; bb = a; a = ADD(t1, t2);
+		}
+
+		s[0] = ADD(s[0], a); s[1] = ADD(s[1], bb);
+		s[2] = ADD(s[2], c); s[3] = ADD(s[3], d);
+		s[4] = ADD(s[4], e); s[5] = ADD(s[5], f);
+		s[6] = ADD(s[6], g); s[7] = ADD(s[7], hh);
+	}
+
+	for (unsigned int i = 0; i < 8; i++)
+		_mm512_storeu_si512(h[i], s[i]);
+}
@@ -0,0 +1,26 @@
+/*
+ * Lane kernels behind sha256-mb.c. Each one runs |blocks| SHA-256 blocks in
+ * every one of its lanes, lane i reading p[i] onwards and updating column i
+ * of h[word][lane]; lanes the manager has no job for point at another lane's
+ * data and their column is thrown away.
+ */
+#ifndef __MODULES_DIGEST_SHA256_MB_KERNEL_H__
+#define __MODULES_DIGEST_SHA256_MB_KERNEL_H__
+
+#include <crypto/digest/sha256-mb.h>
+
+typedef void (*fn_sha256_mb_blocks)(u32 h[8][SHA256_MB_LANES_MAX],
+                                    const u8 *const *p, size_t blocks);
+
+extern const u32 sha256_mb_k[64];
+
+void sha256_mb_blocks_avx2(u32 h[8][SHA256_MB_LANES_MAX],
+                           const u8 *const *p, size_t blocks);
+void sha256_mb_blocks_avx512(u32 h[8][SHA256_MB_LANES_MAX],
+                             const u8 *const *p, size_t blocks);
+void sha256_mb_blocks_shani(u32 h[8][SHA256_MB_LANES_MAX],
+                            const u8 *const *p, size_t blocks);
+void sha256_mb_blocks_neon(u32 h[8][SHA256_MB_LANES_MAX],
+                           const u8 *const *p, size_t blocks);
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * Multi-buffer SHA-256, four lanes of NEON. Vector j of the state holds
+ * word j of the four lanes; the message words come from 4x4 transposes of
+ * the lanes' loads (trn1/trn2 on 32 then 64 bit elements). Unlike the
+ * SHA2 crypto extension this runs on every ARMv8 core, and it keeps four
+ * short messages in flight where sha256h works on one.
+ */
+#include <arm_neon.h>
+#include "sha256-mb-kernel.h"
+
+#define ADD(a, b)   vaddq_u32(a, b)
+#define XOR(a, b)   veorq_u32(a, b)
+#define ROR(x, n)   vsriq_n_u32(vshlq_n_u32(x, 32 - (n)), x, n)
+
+/* words 4k .. 4k + 3 of the four lanes' block, w[i] holding word 4k + i */
+static inline void
+load4(uint32x4_t w[4], const u8 *const *p, size_t off)
+{
+	uint32x4_t r[4], t0, t1, t2, t3;
+
+	for (unsigned int i = 0; i < 4; i++)
+		r[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(p[i] + off)));
+	t0 = vtrn1q_u32(r[0], r[1]);
+	t1 = vtrn2q_u32(r[0], r[1]);
+	t2 = vtrn1q_u32(r[2], r[3]);
+	t3 = vtrn2q_u32(r[2], r[3]);
+#define TRN64(op, a, b) vreinterpretq_u32_u64(op(vreinterpretq_u64_u32(a), \
+						 vreinterpretq_u64_u32(b)))
+	w[0] = TRN64(vtrn1q_u64, t0, t2);
+	w[1] = TRN64(vtrn1q_u64, t1, t3);
+	w[2] = TRN64(vtrn2q_u64, t0, t2);
+	w[3] = TRN64(vtrn2q_u64, t1, t3);
+#undef TRN64
+}
+
+void
+sha256_mb_blocks_neon(u32 h[8][SHA256_MB_LANES_MAX], const u8 *const *p,
+                      size_t blocks)
+{
+	uint32x4_t s[8], w[16];
+
+	for (unsigned int i = 0; i < 8; i++)
+		s[i] = vld1q_u32(h[i]);
+
+	for (size_t b = 0; b < blocks; b++) {
+		uint32x4_t a = s[0], bb = s[1], c = s[2], d = s[3];
+		uint32x4_t e = s[4], f = s[5], g = s[6], hh = s[7];
+
+		for (unsigned int k = 0; k < 4; k++)
+			load4(w + 4 * k, p, b * 64 + 16 * k);
+
+		for (unsigned int t = 0; t < 64; t++) {
+			uint32x4_t x, t1, t2;
+
+			if (t >= 16) {
+				uint32x4_t w15 = w[(t - 15) & 15], w2 = w[(t - 2) & 15];
+
+				x = XOR(XOR(ROR(w15, 7), ROR(w15, 18)),
+					vshrq_n_u32(w15, 3));
+				x = ADD(x, XOR(XOR(ROR(w2, 17), ROR(w2, 19)),
+					       vshrq_n_u32(w2, 10)));
+				w[t & 15] = ADD(ADD(w[t & 15], w[(t - 7) & 15]), x);
+			}
+
+			/* Ch = e ? f : g, Maj = (a ^ b) ? c : b */
+			t1 = ADD(hh, XOR(XOR(ROR(e, 6), ROR(e, 11)), ROR(e, 25)));
+			t1 = ADD(t1, vbslq_u32(e, f, g));
+			t1 = ADD(t1, ADD(vdupq_n_u32(sha256_mb_k[t]), w[t & 15]));
+			t2 = XOR(XOR(ROR(a, 2), ROR(a, 13)), ROR(a, 22));
+			t2 = ADD(t2, vbslq_u32(XOR(a, bb), c, bb));
+
+			hh = g; g = f; f = e; e = ADD(d, t1);
+			d = c; c = bb; bb = a; a = ADD(t1, t2);
+		}
+
+		s[0] = ADD(s[0], a); s[1] = ADD(s[1], bb);
+		s[2] = ADD(s[2], c); s[3] = ADD(s[3], d);
+		s[4] = ADD(s[4], e); s[5] = ADD(s[5], f);
+		s[6] = ADD(s[6], g); s[7] = ADD(s[7], hh);
+	}
+
+	for (unsigned int i = 0; i < 8; i++)
+		vst1q_u32(h[i], s[i]);
+}
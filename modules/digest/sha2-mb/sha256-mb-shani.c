@@ -0,0 +1,87 @@
+/*
+ * Multi-buffer SHA-256 on SHA-NI, two lanes (built with -msha -msse4.1,
+ * picked by sha256-mb.c only on CPUs that have it). sha256rnds2 is one long
+ * dependency chain per message; with two independent messages every step
+ * below is issued for both lanes back to back, so one lane's rounds run in
+ * the other's latency. On CPUs with SHA-NI but no AVX-512 this beats eight
+ * AVX2 lanes.
+ */
+#include <immintrin.h>
+#include "sha256-mb-kernel.h"
+
+#define LANES 2
+
+void
+sha256_mb_blocks_shani(u32 h[8][SHA256_MB_LANES_MAX], const u8 *const *p,
+                       size_t blocks)
+{
+	const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+					     0x0405060700010203ULL);
+	__m128i abef[LANES], cdgh[LANES], m[LANES][4];
+	unsigned int l;
+
+	/* h[word][lane] into the ABEF / CDGH order sha256rnds2 wants */
+	for (l = 0; l < LANES; l++) {
+		__m128i t = _mm_set_epi32(h[2][l], h[3][l], h[0][l], h[1][l]);
+		__m128i s = _mm_set_epi32(h[4][l], h[5][l], h[6][l], h[7][l]);
+
+		abef[l] = _mm_alignr_epi8(t, s, 8);
+		cdgh[l] = _mm_blend_epi16(s, t, 0xf0);
+	}
+
+	for (size_t b = 0; b < blocks; b++) {
+		__m128i abef0[LANES], cdgh0[LANES];
+
+		for (l = 0; l < LANES; l++) {
+			abef0[l] = abef[l];
+			cdgh0[l] = cdgh[l];
+		}
+
+		/* fully unrolled, or m[][] goes through the stack */
+#pragma GCC unroll 16
+		for (unsigned int i = 0; i < 16; i++) {
+			const __m128i k = _mm_loadu_si128(
+				(const __m128i *)&sha256_mb_k[4 * i]);
+
+#pragma GCC unroll 2
+			for (l = 0; l < LANES; l++) {
+				__m128i *cur = &m[l][i & 3];
+				__m128i *prev = &m[l][(i - 1) & 3];
+				__m128i *next = &m[l][(i + 1) & 3];
+				__m128i wk;
+
+				if (i < 4)
+					*cur = _mm_shuffle_epi8(_mm_loadu_si128(
+						(const __m128i *)(p[l] + b * 64 + 16 * i)),
+						bswap);
+				wk = _mm_add_epi32(*cur, k);
+				cdgh[l] = _mm_sha256rnds2_epu32(cdgh[l], abef[l], wk);
+				if (i >= 3 && i <= 14) {
+					*next = _mm_add_epi32(*next,
+						_mm_alignr_epi8(*cur, *prev, 4));
+					*next = _mm_sha256msg2_epu32(*next, *cur);
+				}
+				wk = _mm_shuffle_epi32(wk, 0x0e);
+				abef[l] = _mm_sha256rnds2_epu32(abef[l], cdgh[l], wk);
+				if (i >= 1 && i <= 12)
+					*prev = _mm_sha256msg1_epu32(*prev, *cur);
+			}
+		}
+
+		for (l = 0; l < LANES; l++) {
+			abef[l] = _mm_add_epi32(abef[l], abef0[l]);
+			cdgh[l] = _mm_add_epi32(cdgh[l], cdgh0[l]);
+		}
+	}
+
+	for (l = 0; l < LANES; l++) {
+		__m128i t = _mm_shuffle_epi32(abef[l], 0x1b);
+		__m128i s = _mm_shuffle_epi32(cdgh[l], 0xb1);
+		u32 v[8];
+
+		_mm_storeu_si128((__m128i *)&v[0], _mm_blend_epi16(t, s, 0xf0));
+		_mm_storeu_si128((__m128i *)&v[4], _mm_alignr_epi8(s, t, 8));
+		for (unsigned int i = 0; i < 8; i++)
+			h[i][l] = v[i];
+	}
+}
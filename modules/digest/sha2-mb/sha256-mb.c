@@ -0,0 +1,283 @@
+/*
+ * Multi-buffer SHA-256 job manager (crypto/digest/sha256-mb.h) and the
+ * portable four-lane kernel. Lanes only move in lock step: every kernel call
+ * runs as many blocks as the shortest busy lane has left in its current
+ * run, which is either the whole blocks of the message or the one or two
+ * padding blocks built from its tail at submit time. A lane whose padding
+ * is done holds a finished job until submit or flush hands it back.
+ *
+ * The SIMD kernel (sha256-mb-avx512.c, sha256-mb-shani.c, sha256-mb-avx2.c,
+ * sha256-mb-neon.c) is picked once at startup from the CPU capability
+ * vector, like the block functions of ../sha2-aws-dispatch; crypto_init()
+ * fills the vector first if no cap constructor has run yet.
+ */
+#include <hpc/compiler.h>
+#include <hpc/mem/unaligned.h>
+#include <string.h>
+#if defined(CONFIG_CC_CPU_ACCELERATION) && defined(__x86_64__)
+#include <crypto/init.h>
+#endif
+#include "sha256-mb-kernel.h"
+
+const u32 sha256_mb_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static const u32 sha256_mb_iv[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+	0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+#define ROR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+/* portable kernel: four lanes, one after the other */
+static void
+sha256_mb_blocks_c(u32 h[8][SHA256_MB_LANES_MAX], const u8 *const *p,
+                   size_t blocks)
+{
+	for (unsigned int l = 0; l < 4; l++) {
+		const u8 *m = p[l];
+		u32 s[8], w[64];
+
+		for (unsigned int i = 0; i < 8; i++)
+			s[i] = h[i][l];
+
+		for (size_t b = 0; b < blocks; b++, m += 64) {
+			u32 a = s[0], bb = s[1], c = s[2], d = s[3];
+			u32 e = s[4], f = s[5], g = s[6], hh = s[7];
+
+			for (unsigned int t = 0; t < 16; t++)
+				w[t] = get_u32_be(m + 4 * t);
+			for (unsigned int t = 16; t < 64; t++) {
+				u32 s0 = ROR32(w[t - 15], 7) ^ ROR32(w[t - 15], 18) ^
+					 (w[t - 15] >> 3);
+				u32 s1 = ROR32(w[t - 2], 17) ^ ROR32(w[t - 2], 19) ^
+					 (w[t - 2] >> 10);
+
+				w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+			}
+			for (unsigned int t = 0; t < 64; t++) {
+				u32 t1 = hh + (ROR32(e, 6) ^ ROR32(e, 11) ^ ROR32(e, 25)) +
+					 ((e & f) ^ (~e & g)) + sha256_mb_k[t] + w[t];
+				u32 t2 = (ROR32(a, 2) ^ ROR32(a, 13) ^ ROR32(a, 22)) +
+					 ((a & bb) ^ (a & c) ^ (bb & c));
+
+				hh = g; g = f; f = e; e = d + t1;
+				d = c; c = bb; bb = a; a = t1 + t2;
+			}
+			s[0] += a; s[1] += bb; s[2] += c; s[3] += d;
+			s[4] += e; s[5] += f; s[6] += g; s[7] += hh;
+		}
+
+		for (unsigned int i = 0; i < 8; i++)
+			h[i][l] = s[i];
+	}
+}
+
+struct sha256_mb_kernel {
+	fn_sha256_mb_blocks blocks;
+	unsigned int lanes;
+	int (*usable)(void);
+	const char *desc;
+};
+
+static int cpu_any(void)
+{
+	return 1;
+}
+
+#if defined(CONFIG_CC_CPU_ACCELERATION) && defined(__x86_64__)
+static int have_avx512(void)
+{
+	/* leaf7 EBX bit 16 (AVX512F), cleared unless the OS saves ZMM state */
+	return OPENSSL_ia32cap_P[2] & (1u << 16);
+}
+
+static int have_shani(void)
+{
+	/* leaf7 EBX bit 29 (SHA) with leaf1 ECX bit 19 (SSE4.1) */
+	return (OPENSSL_ia32cap_P[2] & (1u << 29)) &&
+	       (OPENSSL_ia32cap_P[1] & (1u << 19));
+}
+
+static int have_avx2(void)
+{
+	/* leaf7 EBX bit 5 (AVX2), cleared unless the OS saves YMM state */
+	return OPENSSL_ia32cap_P[2] & (1u << 5);
+}
+
+static int cpu_caps_empty(void)
+{
+	return !OPENSSL_ia32cap_P[0] && !OPENSSL_ia32cap_P[1];
+}
+
+/* best first */
+static const struct sha256_mb_kernel sha256_mb_kernels[] = {
+	{ sha256_mb_blocks_avx512, 16, have_avx512, "SHA2-256 x16 (AVX-512)" },
+	{ sha256_mb_blocks_shani, 2, have_shani, "SHA2-256 x2 (SHA-NI)" },
+	{ sha256_mb_blocks_avx2, 8, have_avx2, "SHA2-256 x8 (AVX2)" },
+	{ sha256_mb_blocks_c, 4, cpu_any, "SHA2-256 x4 (C)" },
+};
+#elif defined(CONFIG_CC_CPU_ACCELERATION) && defined(__aarch64__)
+static const struct sha256_mb_kernel sha256_mb_kernels[] = {
+	{ sha256_mb_blocks_neon, 4, cpu_any, "SHA2-256 x4 (NEON)" },
+};
+#else
+static const struct sha256_mb_kernel sha256_mb_kernels[] = {
+	{ sha256_mb_blocks_c, 4, cpu_any, "SHA2-256 x4 (C)" },
+};
+#endif
+
+static const struct sha256_mb_kernel *sha256_mb_kernel;
+
+static const struct sha256_mb_kernel *
+sha256_mb_pick(void)
+{
+	const struct sha256_mb_kernel *k = sha256_mb_kernels;
+
+	if (!sha256_mb_kernel) {
+#if defined(CONFIG_CC_CPU_ACCELERATION) && defined(__x86_64__)
+		if (cpu_caps_empty())
+			crypto_init();
+#endif
+		while (!k->usable())
+			k++;
+		sha256_mb_kernel = k;
+	}
+	return sha256_mb_kernel;
+}
+
+const char *
+sha256_mb_desc(void)
+{
+	return sha256_mb_pick()->desc;
+}
+
+static void __init__
+sha256_mb_kernel_init(void)
+{
+	sha256_mb_pick();
+}
+
+void
+sha256_mb_init(struct sha256_mb_mgr *mgr)
+{
+	mgr->lanes = sha256_mb_pick()->lanes;
+	mgr->busy = 0;
+}
+
+/* the bytes after the last whole block, 0x80, zeros and the bit length */
+static unsigned int
+sha256_mb_pad(u8 pad[128], const u8 *msg, size_t len)
+{
+	size_t rem = len % 64;
+	unsigned int n = rem < 56 ? 64 : 128;
+
+	if (rem)
+		memcpy(pad, msg + len - rem, rem);
+	pad[rem] = 0x80;
+	memset(pad + rem + 1, 0, n - 8 - rem - 1);
+	put_u64_be(pad + n - 8, (u64)len << 3);
+	return n / 64;
+}
+
+struct sha256_mb_job *
+sha256_mb_submit(struct sha256_mb_mgr *mgr, struct sha256_mb_job *job)
+{
+	unsigned int full = (1u << mgr->lanes) - 1;
+	unsigned int l = __builtin_ctz(~mgr->busy);
+	struct sha256_mb_lane *ln = &mgr->lane[l];
+
+	for (unsigned int i = 0; i < 8; i++)
+		mgr->h[i][l] = sha256_mb_iv[i];
+	ln->job = job;
+	ln->p = job->msg;
+	ln->blocks = job->len / 64;
+	ln->tail = sha256_mb_pad(ln->pad, job->msg, job->len);
+	if (!ln->blocks) {
+		ln->p = ln->pad;
+		ln->blocks = ln->tail;
+		ln->tail = 0;
+	}
+	mgr->busy |= 1u << l;
+
+	return mgr->busy == full ? sha256_mb_flush(mgr) : NULL;
+}
+
+struct sha256_mb_job *
+sha256_mb_flush(struct sha256_mb_mgr *mgr)
+{
+	const struct sha256_mb_kernel *k = sha256_mb_pick();
+	const u8 *p[SHA256_MB_LANES_MAX];
+
+	if (!mgr->busy)
+		return NULL;
+
+	for (;;) {
+		size_t run = (size_t)-1;
+		const u8 *any = NULL;
+
+		for (unsigned int l = 0; l < mgr->lanes; l++) {
+			struct sha256_mb_lane *ln = &mgr->lane[l];
+			struct sha256_mb_job *job;
+
+			if (!(mgr->busy & (1u << l)))
+				continue;
+			if (ln->blocks) {
+				run = ln->blocks < run ? ln->blocks : run;
+				any = ln->p;
+				continue;
+			}
+			job = ln->job;
+			for (unsigned int i = 0; i < 8; i++)
+				put_u32_be(job->digest + 4 * i, mgr->h[i][l]);
+			mgr->busy &= ~(1u << l);
+			return job;
+		}
+
+		for (unsigned int l = 0; l < mgr->lanes; l++)
+			p[l] = mgr->busy & (1u << l) ? mgr->lane[l].p : any;
+		k->blocks(mgr->h, p, run);
+
+		for (unsigned int l = 0; l < mgr->lanes; l++) {
+			struct sha256_mb_lane *ln = &mgr->lane[l];
+
+			if (!(mgr->busy & (1u << l)))
+				continue;
+			ln->p += run * 64;
+			ln->blocks -= run;
+			if (!ln->blocks && ln->tail) {
+				ln->p = ln->pad;
+				ln->blocks = ln->tail;
+				ln->tail = 0;
+			}
+		}
+	}
+}
+
+void
+sha256_mb(struct sha256_mb_job *job, unsigned int n)
+{
+	struct sha256_mb_mgr mgr;
+
+	sha256_mb_init(&mgr);
+	for (unsigned int i = 0; i < n; i++)
+		sha256_mb_submit(&mgr, &job[i]);
+	while (sha256_mb_flush(&mgr))
+		;
+}
@@ -0,0 +1,87 @@
+/*
+ * The 24 rounds of Keccak-f[1600] on 25 vectors, lane i of A[j] being word j
+ * of state i. Included by the SIMD kernels, and on plain words by the
+ * portable fallback in sha3-mb.c, after they define V and the operations
+ * below for their vector type; the rho offsets are immediates, so
+ * the rounds are written out rather than driven by a table.
+ *
+ *   XOR(a, b)       a ^ b
+ *   XOR3(a, b, c)   a ^ b ^ c
+ *   ROL(x, n)       each 64 bit word of x rotated left by n
+ *   CHI(a, b, c)    a ^ (~b & c)
+ *   SET1(x)         x in every word
+ */
+
+static inline void
+keccakf1600_x_rounds(V A[25])
+{
+	V B[25], C0, C1, C2, C3, C4, D0, D1, D2, D3, D4;
+
+	for (unsigned int round = 0; round < 24; round++) {
+		/* theta */
+		C0 = XOR3(XOR3(A[0], A[5], A[10]), A[15], A[20]);
+		C1 = XOR3(XOR3(A[1], A[6], A[11]), A[16], A[21]);
+		C2 = XOR3(XOR3(A[2], A[7], A[12]), A[17], A[22]);
+		C3 = XOR3(XOR3(A[3], A[8], A[13]), A[18], A[23]);
+		C4 = XOR3(XOR3(A[4], A[9], A[14]), A[19], A[24]);
+		D0 = XOR(C4, ROL(C1, 1));
+		D1 = XOR(C0, ROL(C2, 1));
+		D2 = XOR(C1, ROL(C3, 1));
+		D3 = XOR(C2, ROL(C4, 1));
+		D4 = XOR(C3, ROL(C0, 1));
+		/* rho, pi */
+		B[0] = XOR(A[0], D0);
+		B[1] = ROL(XOR(A[6], D1), 44);
+		B[2] = ROL(XOR(A[12], D2), 43);
+		B[3] = ROL(XOR(A[18], D3), 21);
+		B[4] = ROL(XOR(A[24], D4), 14);
+		B[5] = ROL(XOR(A[3], D3), 28);
+		B[6] = ROL(XOR(A[9], D4), 20);
+		B[7] = ROL(XOR(A[10], D0), 3);
+		B[8] = ROL(XOR(A[16], D1), 45);
+		B[9] = ROL(XOR(A[22], D2), 61);
+		B[10] = ROL(XOR(A[1], D1), 1);
+		B[11] = ROL(XOR(A[7], D2), 6);
+		B[12] = ROL(XOR(A[13], D3), 25);
+		B[13] = ROL(XOR(A[19], D4), 8);
+		B[14] = ROL(XOR(A[20], D0), 18);
+		B[15] = ROL(XOR(A[4], D4), 27);
+		B[16] = ROL(XOR(A[5], D0), 36);
+		B[17] = ROL(XOR(A[11], D1), 10);
+		B[18] = ROL(XOR(A[17], D2), 15);
+		B[19] = ROL(XOR(A[23], D3), 56);
+		B[20] = ROL(XOR(A[2], D2), 62);
+		B[21] = ROL(XOR(A[8], D3), 55);
+		B[22] = ROL(XOR(A[14], D4), 39);
+		B[23] = ROL(XOR(A[15], D0), 41);
+		B[24] = ROL(XOR(A[21], D1), 2);
+		/* chi */
+		A[0] = CHI(B[0], B[1], B[2]);
+		A[1] = CHI(B[1], B[2], B[3]);
+		A[2] = CHI(B[2], B[3], B[4]);
+		A[3] = CHI(B[3], B[4], B[0]);
+		A[4] = CHI(B[4], B[0], B[1]);
+		A[5] = CHI(B[5], B[6], B[7]);
+		A[6] = CHI(B[6], B[7], B[8]);
+		A[7] = CHI(B[7], B[8], B[9]);
+		A[8] = CHI(B[8], B[9], B[5]);
+		A[9] = CHI(B[9], B[5], B[6]);
+		A[10] = CHI(B[10], B[11], B[12]);
+		A[11] = CHI(B[11], B[12], B[13]);
+		A[12] = CHI(B[12], B[13], B[14]);
+		A[13] = CHI(B[13], B[14], B[10]);
+		A[14] = CHI(B[14], B[10], B[11]);
+		A[15] = CHI(B[15], B[16], B[17]);
+		A[16] = CHI(B[16], B[17], B[18]);
+		A[17] = CHI(B[17], B[18], B[19]);
+		A[18] = CHI(B[18], B[19], B[15]);
+		A[19] = CHI(B[19], B[15], B[16]);
+		A[20] = CHI(B[20], B[21], B[22]);
+		A[21] = CHI(B[21], B[22], B[23]);
+		A[22] = CHI(B[22], B[23], B[24]);
+		A[23] = CHI(B[23], B[24], B[20]);
+		A[24] = CHI(B[24], B[20], B[21]);
+		/* iota */
+		A[0] = XOR(A[0], SET1(keccakf1600_x_rc[round]));
+	}
+}
@@ -0,0 +1,29 @@
+/*
+ * Keccak-f[1600] on four states at once, one per 64 bit lane of AVX2 (built
+ * with -mavx2, picked by sha3-mb.c only on CPUs that have it). No 64 bit
+ * rotate below AVX-512, so ROL is two shifts and an or.
+ */
+#include <immintrin.h>
+#include "sha3-mb-kernel.h"
+
+#define V               __m256i
+#define XOR(a, b)       _mm256_xor_si256(a, b)
+#define XOR3(a, b, c)   XOR(XOR(a, b), c)
+#define ROL(x, n)       _mm256_or_si256(_mm256_slli_epi64(x, n), \
+                                        _mm256_srli_epi64(x, 64 - (n)))
+#define CHI(a, b, c)    XOR(a, _mm256_andnot_si256(b, c))
+#define SET1(x)         _mm256_set1_epi64x((long long)(x))
+
+#include "keccakf1600-x-round.h"
+
+void
+keccakf1600_x4_avx2(u64 *s)
+{
+	V A[25];
+
+	for (unsigned int i = 0; i < 25; i++)
+		A[i] = _mm256_loadu_si256((const __m256i *)(s + 4 * i));
+	keccakf1600_x_rounds(A);
+	for (unsigned int i = 0; i < 25; i++)
+		_mm256_storeu_si256((__m256i *)(s + 4 * i), A[i]);
+}
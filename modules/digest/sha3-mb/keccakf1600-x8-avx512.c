@@ -0,0 +1,29 @@
+/*
+ * Keccak-f[1600] on eight states at once, one per 64 bit lane of AVX-512F
+ * (built with -mavx512f, picked by sha3-mb.c only on CPUs that have it).
+ * vprolq does the rotates and vpternlogq the three-input theta and chi
+ * steps; with 32 registers the state never leaves them.
+ */
+#include <immintrin.h>
+#include "sha3-mb-kernel.h"
+
+#define V               __m512i
+#define XOR(a, b)       _mm512_xor_si512(a, b)
+#define XOR3(a, b, c)   _mm512_ternarylogic_epi64(a, b, c, 0x96)
+#define ROL(x, n)       _mm512_rol_epi64(x, n)
+#define CHI(a, b, c)    _mm512_ternarylogic_epi64(a, b, c, 0xd2)
+#define SET1(x)         _mm512_set1_epi64((long long)(x))
+
+#include "keccakf1600-x-round.h"
+
+void
+keccakf1600_x8_avx512(u64 *s)
+{
+	V A[25];
+
+	for (unsigned int i = 0; i < 25; i++)
+		A[i] = _mm512_loadu_si512(s + 8 * i);
+	keccakf1600_x_rounds(A);
+	for (unsigned int i = 0; i < 25; i++)
+		_mm512_storeu_si512(s + 8 * i, A[i]);
+}
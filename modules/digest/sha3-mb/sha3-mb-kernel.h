@@ -0,0 +1,18 @@
+/*
+ * Parallel Keccak-f[1600] kernels behind sha3-mb.c. A kernel with L lanes
+ * permutes L independent states kept interleaved as s[word][lane], i.e. word
+ * j of state i at s[L * j + i], so each of the 25 words loads as one vector.
+ */
+#ifndef __MODULES_DIGEST_SHA3_MB_KERNEL_H__
+#define __MODULES_DIGEST_SHA3_MB_KERNEL_H__
+
+#include <crypto/digest/sha3-mb.h>
+
+typedef void (*fn_keccakf1600_x)(u64 *s);
+
+extern const u64 keccakf1600_x_rc[24];
+
+void keccakf1600_x4_avx2(u64 *s);
+void keccakf1600_x8_avx512(u64 *s);
+
+#endif
@@ -0,0 +1,330 @@
+/*
+ * Batched SHA-3 / SHAKE (crypto/digest/sha3-mb.h) over the parallel
+ * Keccak-f[1600] kernels. Messages go through in groups of the kernel's
+ * lane count, each group absorbed, padded and squeezed in the interleaved
+ * s[word][lane] layout of sha3-mb-kernel.h; a short last group drops to a
+ * narrower kernel when one covers it in a single pass.
+ *
+ * The kernel is picked once at startup from the CPU capability vector, like
+ * the lane kernels of ../sha2-mb.
+ */
+#include <hpc/compiler.h>
+#include <hpc/mem/unaligned.h>
+#include <crypto/digest.h>
+#include <string.h>
+#if defined(CONFIG_CC_CPU_ACCELERATION) && defined(__x86_64__)
+#include <crypto/init.h>
+#endif
+#include "sha3-mb-kernel.h"
+
+const u64 keccakf1600_x_rc[24] = {
+	0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL,
+	0x8000000080008000ULL, 0x000000000000808bULL, 0x0000000080000001ULL,
+	0x8000000080008081ULL, 0x8000000000008009ULL, 0x000000000000008aULL,
+	0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+	0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL,
+	0x8000000000008003ULL, 0x8000000000008002ULL, 0x8000000000000080ULL,
+	0x000000000000800aULL, 0x800000008000000aULL, 0x8000000080008081ULL,
+	0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+#ifdef HAVE_DIGEST_SHA3_BUILT_IN
+/* one state at a time through the permutation of the SHA-3 backend */
+static void
+keccakf1600_x1(u64 *s)
+{
+	arch_keccakf1600(s);
+}
+
+#define KECCAKF1600_X1_DESC "Keccak-f[1600] x1 (SHA-3 backend)"
+#else
+/*
+ * No SHA-3 backend built in (MODULES=y, where arch_keccakf1600 is only the
+ * empty stub of modules/digest/sha3.h): the same rounds on plain words.
+ */
+#define V               u64
+#define XOR(a, b)       ((a) ^ (b))
+#define XOR3(a, b, c)   ((a) ^ (b) ^ (c))
+#define ROL(x, n)       (((x) << (n)) | ((x) >> (64 - (n))))
+#define CHI(a, b, c)    ((a) ^ (~(b) & (c)))
+#define SET1(x)         (x)
+
+#include "keccakf1600-x-round.h"
+
+#undef V
+#undef XOR
+#undef XOR3
+#undef ROL
+#undef CHI
+#undef SET1
+
+static void
+keccakf1600_x1(u64 *s)
+{
+	keccakf1600_x_rounds(s);
+}
+
+#define KECCAKF1600_X1_DESC "Keccak-f[1600] x1 (C)"
+#endif
+
+struct sha3_mb_kernel {
+	fn_keccakf1600_x permute;
+	unsigned int lanes;
+	int (*usable)(void);
+	const char *desc;
+};
+
+static int cpu_any(void)
+{
+	return 1;
+}
+
+#if defined(CONFIG_CC_CPU_ACCELERATION) && defined(__x86_64__)
+static int have_avx512(void)
+{
+	/* leaf7 EBX bit 16 (AVX512F), cleared unless the OS saves ZMM state */
+	return OPENSSL_ia32cap_P[2] & (1u << 16);
+}
+
+static int have_avx2(void)
+{
+	/* leaf7 EBX bit 5 (AVX2), cleared unless the OS saves YMM state */
+	return OPENSSL_ia32cap_P[2] & (1u << 5);
+}
+
+static int cpu_caps_empty(void)
+{
+	return !OPENSSL_ia32cap_P[0] && !OPENSSL_ia32cap_P[1];
+}
+
+/* best first, widest first */
+static const struct sha3_mb_kernel sha3_mb_kernels[] = {
+	{ keccakf1600_x8_avx512, 8, have_avx512, "Keccak-f[1600] x8 (AVX-512)" },
+	{ keccakf1600_x4_avx2, 4, have_avx2, "Keccak-f[1600] x4 (AVX2)" },
+	{ keccakf1600_x1, 1, cpu_any, KECCAKF1600_X1_DESC },
+};
+#else
+static const struct sha3_mb_kernel sha3_mb_kernels[] = {
+	{ keccakf1600_x1, 1, cpu_any, KECCAKF1600_X1_DESC },
+};
+#endif
+
+#define SHA3_MB_KERNELS (sizeof(sha3_mb_kernels) / sizeof(sha3_mb_kernels[0]))
+
+static const struct sha3_mb_kernel *sha3_mb_kernel;
+
+static const struct sha3_mb_kernel *
+sha3_mb_pick(void)
+{
+	const struct sha3_mb_kernel *k = sha3_mb_kernels;
+
+	if (!sha3_mb_kernel) {
+#if defined(CONFIG_CC_CPU_ACCELERATION) && defined(__x86_64__)
+		if (cpu_caps_empty())
+			crypto_init();
+#endif
+		while (!k->usable())
+			k++;
+		sha3_mb_kernel = k;
+	}
+	return sha3_mb_kernel;
+}
+
+/* kernel for |n| states: the widest, unless a narrower one holds them all */
+static const struct sha3_mb_kernel *
+sha3_mb_fit(unsigned int n)
+{
+	const struct sha3_mb_kernel *k = sha3_mb_pick();
+	const struct sha3_mb_kernel *end = sha3_mb_kernels + SHA3_MB_KERNELS;
+
+	for (const struct sha3_mb_kernel *next = k + 1; next < end; next++)
+		if (next->usable() && n <= next->lanes)
+			k = next;
+	return k;
+}
+
+const char *
+sha3_mb_desc(void)
+{
+	return sha3_mb_pick()->desc;
+}
+
+static void __init__
+sha3_mb_kernel_init(void)
+{
+	sha3_mb_pick();
+}
+
+/*
+ * Absorb |len| bytes of in[0 .. m) and the padding (domain byte |ds|) into
+ * the zeroed lanes of |s|. Lanes from m up to the kernel width stay zero and
+ * are permuted along for nothing.
+ */
+static void
+sha3_mb_absorb(const struct sha3_mb_kernel *k, u64 *s, const u8 *const *in,
+               unsigned int m, size_t len, unsigned int rate, u8 ds)
+{
+	unsigned int L = k->lanes, w = rate / 8;
+	size_t off, rem = len % rate;
+	u8 last[200];
+
+	memset(s, 0, 25 * L * sizeof(*s));
+	for (off = 0; off < len - rem; off += rate) {
+		for (unsigned int l = 0; l < m; l++)
+			for (unsigned int i = 0; i < w; i++)
+				s[L * i + l] ^= get_u64_le(in[l] + off + 8 * i);
+		k->permute(s);
+	}
+
+	for (unsigned int l = 0; l < m; l++) {
+		memcpy(last, in[l] + off, rem);
+		last[rem] = ds;
+		memset(last + rem + 1, 0, rate - rem - 1);
+		last[rate - 1] |= 0x80;
+		for (unsigned int i = 0; i < w; i++)
+			s[L * i + l] ^= get_u64_le(last + 8 * i);
+	}
+}
+
+/* permute, then |outlen| bytes of lanes 0 .. m, rate bytes per permutation */
+static void
+sha3_mb_squeeze(const struct sha3_mb_kernel *k, u64 *s, u8 *const *out,
+                unsigned int m, size_t outlen, unsigned int rate)
+{
+	unsigned int L = k->lanes;
+	u8 word[8];
+
+	for (size_t off = 0; off < outlen; off += rate) {
+		size_t n = outlen - off < rate ? outlen - off : rate;
+
+		k->permute(s);
+		for (unsigned int l = 0; l < m; l++) {
+			unsigned int i;
+
+			for (i = 0; i < n / 8; i++)
+				put_u64_le(out[l] + off + 8 * i, s[L * i + l]);
+			if (n % 8) {
+				put_u64_le(word, s[L * i + l]);
+				memcpy(out[l] + off + 8 * i, word, n % 8);
+			}
+		}
+	}
+}
+
+static void
+sha3_mb_run(u8 *const out[], size_t outlen, const u8 *const in[], size_t len,
+            unsigned int n, unsigned int rate, u8 ds)
+{
+	u64 s[25 * SHA3_MB_LANES_MAX];
+
+	for (unsigned int g = 0; g < n; ) {
+		const struct sha3_mb_kernel *k = sha3_mb_fit(n - g);
+		unsigned int m = n - g < k->lanes ? n - g : k->lanes;
+
+		sha3_mb_absorb(k, s, in + g, m, len, rate, ds);
+		sha3_mb_squeeze(k, s, out + g, m, outlen, rate);
+		g += m;
+	}
+}
+
+void
+sha3_256_mb(u8 *const out[], const u8 *const in[], size_t len, unsigned int n)
+{
+	sha3_mb_run(out, 32, in, len, n, 200 - 2 * 32, 0x06);
+}
+
+void
+sha3_512_mb(u8 *const out[], const u8 *const in[], size_t len, unsigned int n)
+{
+	sha3_mb_run(out, 64, in, len, n, 200 - 2 * 64, 0x06);
+}
+
+void
+shake128_mb(u8 *const out[], size_t outlen, const u8 *const in[], size_t len,
+            unsigned int n)
+{
+	sha3_mb_run(out, outlen, in, len, n, SHAKE128_RATE, 0x1f);
+}
+
+void
+shake256_mb(u8 *const out[], size_t outlen, const u8 *const in[], size_t len,
+            unsigned int n)
+{
+	sha3_mb_run(out, outlen, in, len, n, SHAKE256_RATE, 0x1f);
+}
+
+/* lanes 0 .. m of |s| from / back to the states sha3[0 .. m) */
+static void
+sha3_mb_gather(u64 *s, unsigned int L, struct sha3 *const *sha3, unsigned int m)
+{
+	memset(s, 0, 25 * L * sizeof(*s));
+	for (unsigned int l = 0; l < m; l++)
+		for (unsigned int i = 0; i < 25; i++)
+			s[L * i + l] = sha3[l]->st[i];
+}
+
+static void
+sha3_mb_scatter(struct sha3 *const *sha3, const u64 *s, unsigned int L,
+                unsigned int m)
+{
+	for (unsigned int l = 0; l < m; l++)
+		for (unsigned int i = 0; i < 25; i++)
+			sha3[l]->st[i] = s[L * i + l];
+}
+
+static void
+shake_mb_absorb(struct sha3 *const sha3[], const u8 *const in[], size_t len,
+                unsigned int n, unsigned int rate)
+{
+	u64 s[25 * SHA3_MB_LANES_MAX];
+
+	for (unsigned int g = 0; g < n; ) {
+		const struct sha3_mb_kernel *k = sha3_mb_fit(n - g);
+		unsigned int m = n - g < k->lanes ? n - g : k->lanes;
+
+		sha3_mb_absorb(k, s, in + g, m, len, rate, 0x1f);
+		sha3_mb_scatter(sha3 + g, s, k->lanes, m);
+		/* padded: squeezing, at the end of a block (crypto/digest/shake.h) */
+		for (unsigned int l = 0; l < m; l++) {
+			struct sha3 *x = sha3[g + l];
+
+			x->md_len = 0;
+			x->rsiz = rate;
+			x->rsizw = rate / 8;
+			x->partial = rate;
+		}
+		g += m;
+	}
+}
+
+void
+shake128_mb_absorb(struct sha3 *const sha3[], const u8 *const in[], size_t len,
+                   unsigned int n)
+{
+	shake_mb_absorb(sha3, in, len, n, SHAKE128_RATE);
+}
+
+void
+shake256_mb_absorb(struct sha3 *const sha3[], const u8 *const in[], size_t len,
+                   unsigned int n)
+{
+	shake_mb_absorb(sha3, in, len, n, SHAKE256_RATE);
+}
+
+void
+shake_mb_squeezeblocks(struct sha3 *const sha3[], u8 *const out[],
+                       size_t blocks, unsigned int n)
+{
+	u64 s[25 * SHA3_MB_LANES_MAX];
+
+	for (unsigned int g = 0; g < n; ) {
+		const struct sha3_mb_kernel *k = sha3_mb_fit(n - g);
+		unsigned int m = n - g < k->lanes ? n - g : k->lanes;
+		unsigned int rate = sha3[g]->rsiz;
+
+		sha3_mb_gather(s, k->lanes, sha3 + g, m);
+		sha3_mb_squeeze(k, s, out + g, m, blocks * rate, rate);
+		sha3_mb_scatter(sha3 + g, s, k->lanes, m);
+		g += m;
+	}
+}
@@ -73,6 +73,13 @@ arch_sha3_512_init(struct sha3 *sha3)
 	arch_sha3_init(sha3, SHA3_512_DIGEST_SIZE);
 }
 
+/* the bare permutation, for SHAKE/cSHAKE/KMAC (crypto/digest/shake.h) */
+static inline void
+arch_keccakf1600(u64 st[25])
+{
+	keccakf1600(st);
+}
+
 #ifdef HAVE_DIGEST_SHA3_BUILT_IN 
 
 static inline int
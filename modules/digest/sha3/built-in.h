@@ -28,6 +28,7 @@ void sha3_384_init(struct sha3_ctx *sctx);
 void sha3_512_init(struct sha3_ctx *sctx);
 int sha3_update(struct sha3_ctx *sctx, const u8 *data, unsigned int len);
 void sha3_final(struct sha3_ctx *sctx);
+void sha3_keccakf1600(u64 st[25]);
 
 #else
 
@@ -72,4 +73,11 @@ arch_sha3_256_final(struct sha3 *s, u8 *out)
 	sha3_final(c);
 }
 
+/* the bare permutation, for SHAKE/cSHAKE/KMAC (crypto/digest/shake.h) */
+static inline void
+arch_keccakf1600(u64 st[25])
+{
+	sha3_keccakf1600(st);
+}
+
 #endif
@@ -51,6 +51,7 @@ SHA3_SCOPE void sha3_512_init(struct sha3_ctx *sctx);
 
 SHA3_SCOPE int sha3_update(struct sha3_ctx *sctx, const u8 *data, unsigned int len);
 SHA3_SCOPE void sha3_final(struct sha3_ctx *sctx);
+SHA3_SCOPE void sha3_keccakf1600(uint64_t st[25]);
 
 
 #define KECCAK_ROUNDS 24
@@ -120,6 +121,13 @@ keccakf(uint64_t st[25])
 	}
 }
 
+/* keccakf() for callers outside this file: SHAKE, cSHAKE, KMAC */
+SHA3_SCOPE void _unused
+sha3_keccakf1600(uint64_t st[25])
+{
+	keccakf(st);
+}
+
 static void
 sha3_init(struct sha3_ctx *sctx, unsigned int digest_sz)
 {
@@ -1,5 +1,5 @@
 /*
- * Standalone cipher selftest. Exercises the AES-128/256 (CBC, GCM) and
+ * Standalone cipher selftest. Exercises the AES-128/256 (CBC, CTR, GCM) and
  * ChaCha20-Poly1305 free-function API against published NIST / RFC 7539 test
  * vectors, linked against whichever backend the crypto build selected
  * (generic C or the aws-lc accelerated modules). One "<name>: ok/FAIL" line is
@@ -10,6 +10,7 @@
 #include <crypto/cipher/aes.h>
 #include <crypto/cipher/aes/gcm.h>
 #include <crypto/cipher/chachapoly.h>
+#include <crypto/cipher/poly1305.h>
 
 #ifdef CONFIG_CC_CLIB
 #include <unistd.h>
@@ -64,7 +65,440 @@ static int test_aes128_gcm(void)
 	return 1;
 }
 
+/*
+ * Keyed AES-128-GCM: NIST GCM Test Case 2 again, but sealed and opened twice
+ * under one aes_gcm_setkey to check the cached schedule survives a record.
+ */
+static int test_aes128_gcm_keyed(void)
+{
+	struct aes_gcm_key gcm;
+	u8 key[16] = {0}, iv[12] = {0}, pt[16] = {0};
+	u8 out[32], dec[16];
+	static const u8 ct[16] = {
+		0x03,0x88,0xda,0xce,0x60,0xb6,0xa3,0x92,
+		0xf3,0x28,0xc2,0xb9,0x71,0xb2,0xfe,0x78 };
+	static const u8 tag[16] = {
+		0xab,0x6e,0x47,0xd4,0x2c,0xec,0x13,0xbd,
+		0xf5,0x3a,0x67,0xb2,0x12,0x57,0xbd,0xdf };
+
+	aes_init_keygen_tables();
+	if (aes_gcm_setkey(&gcm, key, 16) != 0)
+		return 0;
+	for (unsigned int round = 0; round < 2; round++) {
+		aes_gcm_seal(&gcm, out, pt, 16, iv, 12, NULL, 0);
+		if (!eq(out, ct, 16) || !eq(out + 16, tag, 16))
+			return 0;
+		if (aes_gcm_open(&gcm, dec, out, 32, iv, 12, NULL, 0) != 0 ||
+		    !eq(dec, pt, 16))
+			return 0;
+	}
+	out[0] ^= 0x01;
+	if (aes_gcm_open(&gcm, dec, out, 32, iv, 12, NULL, 0) == 0)
+		return 0;
+	return 1;
+}
+
+/* AES-128-GCM with AAD, NIST GCM Test Case 4 (60-byte PT, 20-byte AAD). */
+static int test_aes128_gcm_aad(void)
+{
+	struct aes_gcm_key gcm;
+	static const u8 key[16] = {
+		0xfe,0xff,0xe9,0x92,0x86,0x65,0x73,0x1c,0x6d,0x6a,0x8f,0x94,
+		0x67,0x30,0x83,0x08 };
+	static const u8 iv[12] = {
+		0xca,0xfe,0xba,0xbe,0xfa,0xce,0xdb,0xad,0xde,0xca,0xf8,0x88 };
+	static const u8 aad[20] = {
+		0xfe,0xed,0xfa,0xce,0xde,0xad,0xbe,0xef,0xfe,0xed,0xfa,0xce,
+		0xde,0xad,0xbe,0xef,0xab,0xad,0xda,0xd2 };
+	static const u8 pt[60] = {
+		0xd9,0x31,0x32,0x25,0xf8,0x84,0x06,0xe5,0xa5,0x59,0x09,0xc5,
+		0xaf,0xf5,0x26,0x9a,0x86,0xa7,0xa9,0x53,0x15,0x34,0xf7,0xda,
+		0x2e,0x4c,0x30,0x3d,0x8a,0x31,0x8a,0x72,0x1c,0x3c,0x0c,0x95,
+		0x95,0x68,0x09,0x53,0x2f,0xcf,0x0e,0x24,0x49,0xa6,0xb5,0x25,
+		0xb1,0x6a,0xed,0xf5,0xaa,0x0d,0xe6,0x57,0xba,0x63,0x7b,0x39 };
+	static const u8 ct[60] = {
+		0x42,0x83,0x1e,0xc2,0x21,0x77,0x74,0x24,0x4b,0x72,0x21,0xb7,
+		0x84,0xd0,0xd4,0x9c,0xe3,0xaa,0x21,0x2f,0x2c,0x02,0xa4,0xe0,
+		0x35,0xc1,0x7e,0x23,0x29,0xac,0xa1,0x2e,0x21,0xd5,0x14,0xb2,
+		0x54,0x66,0x93,0x1c,0x7d,0x8f,0x6a,0x5a,0xac,0x84,0xaa,0x05,
+		0x1b,0xa3,0x0b,0x39,0x6a,0x0a,0xac,0x97,0x3d,0x58,0xe0,0x91 };
+	static const u8 tag[16] = {
+		0x5b,0xc9,0x4f,0xbc,0x32,0x21,0xa5,0xdb,0x94,0xfa,0xe9,0x5a,
+		0xe7,0x12,0x1a,0x47 };
+	u8 out[76], dec[60];
+
+	aes_init_keygen_tables();
+	if (aes_gcm_setkey(&gcm, key, 16) != 0)
+		return 0;
+	aes_gcm_seal(&gcm, out, pt, 60, iv, 12, aad, 20);
+	if (!eq(out, ct, 60) || !eq(out + 60, tag, 16))
+		return 0;
+	if (aes_gcm_open(&gcm, dec, out, 76, iv, 12, aad, 20) != 0 ||
+	    !eq(dec, pt, 60))
+		return 0;
+	/* the AAD is authenticated: a different header must be rejected */
+	if (aes_gcm_open(&gcm, dec, out, 76, iv, 12, aad, 19) == 0)
+		return 0;
+	return 1;
+}
+
+/*
+ * AES-128-GCM over a 1000-byte record (pt[i] = i, NIST Test Case 4 key, IV
+ * and AAD): long enough for the stitched bulk kernel to take several 96-byte
+ * strides before the tail path finishes the record. Tag from OpenSSL.
+ */
+static int test_aes128_gcm_bulk(void)
+{
+	struct aes_gcm_key gcm;
+	static const u8 key[16] = {
+		0xfe,0xff,0xe9,0x92,0x86,0x65,0x73,0x1c,0x6d,0x6a,0x8f,0x94,
+		0x67,0x30,0x83,0x08 };
+	static const u8 iv[12] = {
+		0xca,0xfe,0xba,0xbe,0xfa,0xce,0xdb,0xad,0xde,0xca,0xf8,0x88 };
+	static const u8 aad[20] = {
+		0xfe,0xed,0xfa,0xce,0xde,0xad,0xbe,0xef,0xfe,0xed,0xfa,0xce,
+		0xde,0xad,0xbe,0xef,0xab,0xad,0xda,0xd2 };
+	static const u8 tag[16] = {
+		0x69,0x6c,0xa7,0xdc,0x7b,0x4f,0x77,0x9b,0xec,0xc2,0xf9,0xc2,
+		0x45,0x21,0xe3,0xd1 };
+	static u8 pt[1000], out[1016], dec[1000];
+
+	for (unsigned int i = 0; i < sizeof(pt); i++)
+		pt[i] = (u8)i;
+	aes_init_keygen_tables();
+	if (aes_gcm_setkey(&gcm, key, 16) != 0)
+		return 0;
+	aes_gcm_seal(&gcm, out, pt, 1000, iv, 12, aad, 20);
+	if (!eq(out + 1000, tag, 16))
+		return 0;
+	if (aes_gcm_open(&gcm, dec, out, 1016, iv, 12, aad, 20) != 0 ||
+	    !eq(dec, pt, 1000))
+		return 0;
+	out[500] ^= 0x01;
+	if (aes_gcm_open(&gcm, dec, out, 1016, iv, 12, aad, 20) == 0)
+		return 0;
+	return 1;
+}
+
+/*
+ * NIST GCM Test Case 4 again, with its IV taken the TLS 1.2 way: salt
+ * cafebabe from the key block, explicit nonce facedbaddecaf888 per record.
+ */
+static int test_aes128_gcm_explicit(void)
+{
+	struct aes_gcm_key gcm;
+	static const u8 key[16] = {
+		0xfe,0xff,0xe9,0x92,0x86,0x65,0x73,0x1c,0x6d,0x6a,0x8f,0x94,
+		0x67,0x30,0x83,0x08 };
+	static const u8 aad[20] = {
+		0xfe,0xed,0xfa,0xce,0xde,0xad,0xbe,0xef,0xfe,0xed,0xfa,0xce,
+		0xde,0xad,0xbe,0xef,0xab,0xad,0xda,0xd2 };
+	static const u8 pt[60] = {
+		0xd9,0x31,0x32,0x25,0xf8,0x84,0x06,0xe5,0xa5,0x59,0x09,0xc5,
+		0xaf,0xf5,0x26,0x9a,0x86,0xa7,0xa9,0x53,0x15,0x34,0xf7,0xda,
+		0x2e,0x4c,0x30,0x3d,0x8a,0x31,0x8a,0x72,0x1c,0x3c,0x0c,0x95,
+		0x95,0x68,0x09,0x53,0x2f,0xcf,0x0e,0x24,0x49,0xa6,0xb5,0x25,
+		0xb1,0x6a,0xed,0xf5,0xaa,0x0d,0xe6,0x57,0xba,0x63,0x7b,0x39 };
+	static const u8 tag[16] = {
+		0x5b,0xc9,0x4f,0xbc,0x32,0x21,0xa5,0xdb,0x94,0xfa,0xe9,0x5a,
+		0xe7,0x12,0x1a,0x47 };
+	u8 out[76], dec[60];
+
+	aes_init_keygen_tables();
+	if (aes_gcm_setkey(&gcm, key, 16) != 0)
+		return 0;
+	aes_gcm_seal_explicit(&gcm, out, pt, 60, 0xcafebabeu,
+			      0xfacedbaddecaf888ull, aad, 20);
+	if (!eq(out + 60, tag, 16))
+		return 0;
+	if (aes_gcm_open_explicit(&gcm, dec, out, 76, 0xcafebabeu,
+				  0xfacedbaddecaf888ull, aad, 20) != 0 ||
+	    !eq(dec, pt, 60))
+		return 0;
+	/* the next sequence number is a different nonce */
+	if (aes_gcm_open_explicit(&gcm, dec, out, 76, 0xcafebabeu,
+				  0xfacedbaddecaf889ull, aad, 20) == 0)
+		return 0;
+	return aes_gcm_seal_explicit(&gcm, out, pt, -1, 0xcafebabeu,
+				     0xfacedbaddecaf888ull, aad, 20) != 0;
+}
+
+/*
+ * Compact keyed state: the backend must stay within aes_gcm_key_size bytes
+ * of struct aes_gcm_key, which is all a packed per-flow context allocates.
+ * The rest of the storage is poisoned and must survive setkey, seal and open.
+ */
+static int test_aes128_gcm_compact(void)
+{
+	struct aes_gcm_key gcm;
+	static const u8 key[16] = {
+		0xfe,0xff,0xe9,0x92,0x86,0x65,0x73,0x1c,0x6d,0x6a,0x8f,0x94,
+		0x67,0x30,0x83,0x08 };
+	static const u8 iv[12] = {
+		0xca,0xfe,0xba,0xbe,0xfa,0xce,0xdb,0xad,0xde,0xca,0xf8,0x88 };
+	static const u8 aad[20] = {
+		0xfe,0xed,0xfa,0xce,0xde,0xad,0xbe,0xef,0xfe,0xed,0xfa,0xce,
+		0xde,0xad,0xbe,0xef,0xab,0xad,0xda,0xd2 };
+	static const u8 pt[60] = {
+		0xd9,0x31,0x32,0x25,0xf8,0x84,0x06,0xe5,0xa5,0x59,0x09,0xc5,
+		0xaf,0xf5,0x26,0x9a,0x86,0xa7,0xa9,0x53,0x15,0x34,0xf7,0xda,
+		0x2e,0x4c,0x30,0x3d,0x8a,0x31,0x8a,0x72,0x1c,0x3c,0x0c,0x95,
+		0x95,0x68,0x09,0x53,0x2f,0xcf,0x0e,0x24,0x49,0xa6,0xb5,0x25,
+		0xb1,0x6a,0xed,0xf5,0xaa,0x0d,0xe6,0x57,0xba,0x63,0x7b,0x39 };
+	static const u8 tag[16] = {
+		0x5b,0xc9,0x4f,0xbc,0x32,0x21,0xa5,0xdb,0x94,0xfa,0xe9,0x5a,
+		0xe7,0x12,0x1a,0x47 };
+	size_t size = aes_gcm_key_size(), i;
+	u8 out[76], dec[60];
+
+	if (size > sizeof(gcm))
+		return 0;
+	for (i = 0; i < sizeof(gcm); i++)
+		gcm.data[i] = 0xa5;
+
+	aes_init_keygen_tables();
+	if (aes_gcm_setkey(&gcm, key, 16) != 0)
+		return 0;
+	aes_gcm_seal(&gcm, out, pt, 60, iv, 12, aad, 20);
+	if (!eq(out + 60, tag, 16))
+		return 0;
+	if (aes_gcm_open(&gcm, dec, out, 76, iv, 12, aad, 20) != 0 ||
+	    !eq(dec, pt, 60))
+		return 0;
+	for (i = size; i < sizeof(gcm); i++)
+		if (gcm.data[i] != 0xa5)
+			return 0;
+	return 1;
+}
+
+/*
+ * Batched key setup: six keys (one full lane group and a partial one) per
+ * key size must seal exactly like contexts keyed one by one.
+ */
+static int test_aes_gcm_setkey_batch(void)
+{
+	static struct aes_gcm_key one[6], many[6];
+	struct aes_gcm_key *gcm[6];
+	const u8 *kp[6];
+	u8 key[6][32], iv[12] = { 0 }, pt[40], a[56], b[56];
+	unsigned int i, j, len;
+
+	aes_init_keygen_tables();
+	for (i = 0; i < 40; i++)
+		pt[i] = (u8)i;
+	for (i = 0; i < 6; i++) {
+		for (j = 0; j < 32; j++)
+			key[i][j] = (u8)(i * 41 + j * 7);
+		kp[i] = key[i];
+		gcm[i] = &many[i];
+	}
+
+	for (len = 16; len <= 32; len += 16) {
+		if (aes_gcm_setkey_batch(gcm, kp, len, 6) != 0)
+			return 0;
+		for (i = 0; i < 6; i++) {
+			if (aes_gcm_setkey(&one[i], key[i], len) != 0)
+				return 0;
+			aes_gcm_seal(&one[i], a, pt, 40, iv, 12, NULL, 0);
+			aes_gcm_seal(&many[i], b, pt, 40, iv, 12, NULL, 0);
+			if (!eq(a, b, 56))
+				return 0;
+		}
+	}
+	return aes_gcm_setkey_batch(gcm, kp, 20, 6) != 0;
+}
+
+/*
+ * A key pinned to the plain CTR + GHASH kernel, which every backend has,
+ * must seal a multi-stride record like the default kernel, and a bad key
+ * length must still be refused.
+ */
+static int test_aes_gcm_setkey_bulk(void)
+{
+	static struct aes_gcm_key best, ghash;
+	static u8 pt[1000], a[1016], b[1016];
+	u8 key[16], iv[12] = { 0 };
+	unsigned int i;
+
+	aes_init_keygen_tables();
+	for (i = 0; i < sizeof(pt); i++)
+		pt[i] = (u8)(i * 3);
+	for (i = 0; i < 16; i++)
+		key[i] = (u8)(i * 29);
+
+	if (aes_gcm_setkey_bulk(&best, key, 16, AES_GCM_BULK_BEST) != 0 ||
+	    aes_gcm_setkey_bulk(&ghash, key, 16, AES_GCM_BULK_GHASH) != 0)
+		return 0;
+	aes_gcm_seal(&best, a, pt, 1000, iv, 12, NULL, 0);
+	aes_gcm_seal(&ghash, b, pt, 1000, iv, 12, NULL, 0);
+	if (!eq(a, b, sizeof(a)) ||
+	    aes_gcm_open(&ghash, b, a, 1016, iv, 12, NULL, 0) != 0 ||
+	    !eq(b, pt, sizeof(pt)))
+		return 0;
+	return aes_gcm_setkey_bulk(&ghash, key, 20, AES_GCM_BULK_GHASH) != 0;
+}
+
+/*
+ * Streaming AES-128-GCM over the 1000-byte record above, sealed and opened
+ * in place from pieces that start and end mid-block, as TCP segments of a
+ * TLS record would. Must match the one-shot seal and the OpenSSL tag.
+ */
+static int test_aes128_gcm_stream(void)
+{
+	struct aes_gcm_key gcm;
+	struct aes_gcm_stream st;
+	static const u8 key[16] = {
+		0xfe,0xff,0xe9,0x92,0x86,0x65,0x73,0x1c,0x6d,0x6a,0x8f,0x94,
+		0x67,0x30,0x83,0x08 };
+	static const u8 iv[12] = {
+		0xca,0xfe,0xba,0xbe,0xfa,0xce,0xdb,0xad,0xde,0xca,0xf8,0x88 };
+	static const u8 aad[20] = {
+		0xfe,0xed,0xfa,0xce,0xde,0xad,0xbe,0xef,0xfe,0xed,0xfa,0xce,
+		0xde,0xad,0xbe,0xef,0xab,0xad,0xda,0xd2 };
+	static const u8 want[16] = {
+		0x69,0x6c,0xa7,0xdc,0x7b,0x4f,0x77,0x9b,0xec,0xc2,0xf9,0xc2,
+		0x45,0x21,0xe3,0xd1 };
+	static const unsigned int seal_pieces[] = { 1, 15, 17, 300, 7, 660 };
+	static const unsigned int open_pieces[] = { 100, 3, 896, 1 };
+	static u8 buf[1000], ref[1016];
+	u8 tag[16];
+	unsigned int i, off;
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = (u8)i;
+	aes_init_keygen_tables();
+	if (aes_gcm_setkey(&gcm, key, 16) != 0)
+		return 0;
+	aes_gcm_seal(&gcm, ref, buf, 1000, iv, 12, aad, 20);
+
+	if (aes_gcm_stream_init(&st, &gcm, 1, iv, 12, aad, 20) != 0)
+		return 0;
+	for (i = 0, off = 0; i < 6; off += seal_pieces[i++])
+		aes_gcm_stream_update(&st, buf + off, buf + off,
+				      seal_pieces[i]);
+	aes_gcm_stream_final(&st, tag);
+	if (!eq(buf, ref, 1000) || !eq(tag, want, 16))
+		return 0;
+
+	if (aes_gcm_stream_init(&st, &gcm, 0, iv, 12, aad, 20) != 0)
+		return 0;
+	for (i = 0, off = 0; i < 4; off += open_pieces[i++])
+		aes_gcm_stream_update(&st, buf + off, buf + off,
+				      open_pieces[i]);
+	if (aes_gcm_stream_final(&st, tag) != 0)
+		return 0;
+	for (i = 0; i < sizeof(buf); i++)
+		if (buf[i] != (u8)i)
+			return 0;
+
+	/* a corrupted tag fails at final */
+	tag[0] ^= 0x80;
+	aes_gcm_stream_init(&st, &gcm, 0, iv, 12, aad, 20);
+	aes_gcm_stream_update(&st, ref, buf, 1000);
+	if (aes_gcm_stream_final(&st, tag) == 0)
+		return 0;
+	return 1;
+}
+
+/*
+ * Multi-buffer open: records of assorted lengths (empty, sub-block, one
+ * stride and several strides) under two keys, sealed one by one and opened
+ * in one aes_gcm_open_mb call, more records than lanes. A short and a long
+ * record are opened in place, and a short and a long one carry a corrupted
+ * tag, which must fail on their own.
+ */
+static int test_aes_gcm_open_mb(void)
+{
+	static const unsigned int lens[10] = {
+		0, 13, 60, 96, 1000, 1536, 3100, 16, 255, 4097 };
+	static u8 pt[10][4097], ct[10][4097 + 16], dec[10][4097];
+	struct aes_gcm_mb rec[10];
+	struct aes_gcm_key key[2];
+	u8 k[32], iv[12];
+	unsigned int i, j;
+
+	for (i = 0; i < sizeof(k); i++)
+		k[i] = (u8)(0xa0 + i);
+	for (i = 0; i < sizeof(iv); i++)
+		iv[i] = (u8)i;
+	aes_init_keygen_tables();
+	if (aes_gcm_setkey(&key[0], k, 16) || aes_gcm_setkey(&key[1], k, 32))
+		return 0;
+
+	for (i = 0; i < 10; i++) {
+		for (j = 0; j < lens[i]; j++)
+			pt[i][j] = (u8)(i * 31 + j);
+		aes_gcm_seal(&key[i & 1], ct[i], pt[i], (int)lens[i], iv, 12,
+			     iv, i);
+		rec[i].key = &key[i & 1];
+		rec[i].iv = iv;
+		rec[i].aad = iv;
+		rec[i].aad_len = i;
+		rec[i].in = ct[i];
+		rec[i].out = i == 3 || i == 6 ? ct[i] : dec[i];
+		rec[i].len = lens[i];
+		rec[i].tag = ct[i] + lens[i];
+	}
+	ct[2][60 + 15] ^= 0x80;
+	ct[4][1000 + 3] ^= 0x01;
+
+	if (aes_gcm_open_mb(rec, 10) != 2)
+		return 0;
+	for (i = 0; i < 10; i++) {
+		if (i == 2 || i == 4) {
+			if (rec[i].status == 0)
+				return 0;
+			continue;
+		}
+		if (rec[i].status != 0 || !eq(rec[i].out, pt[i], lens[i]))
+			return 0;
+	}
+	return 1;
+}
+
 /* AES-256-GCM, NIST GCM Test Case 14 (zero key/iv, 16-byte zero PT, no AAD). */
+static int test_aes128_gcm_inplace(void)
+{
+	static u8 pt[1500], ref[sizeof(pt) + 16], buf[sizeof(pt) + 16];
+	static const unsigned int lens[] = { 1500, 77 };
+	static struct aes_gcm_key gcm;
+	u8 key[16], iv[12];
+
+	for (unsigned int i = 0; i < 16; i++)
+		key[i] = (u8)(5 * i + 3);
+	for (unsigned int i = 0; i < 12; i++)
+		iv[i] = (u8)(0x60 + i);
+	for (unsigned int i = 0; i < sizeof(pt); i++)
+		pt[i] = (u8)(i * 13 + 1);
+	aes_init_keygen_tables();
+	if (aes_gcm_setkey(&gcm, key, 16) != 0)
+		return 0;
+
+	for (unsigned int l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+		int len = (int)lens[l];
+
+		aes_gcm_seal(&gcm, ref, pt, len, iv, 12, NULL, 0);
+		for (int i = 0; i < len; i++)
+			buf[i] = pt[i];
+		aes_gcm_seal(&gcm, buf, buf, len, iv, 12, NULL, 0);
+		if (!eq(buf, ref, (unsigned int)len + 16))
+			return 0;
+
+		if (aes_gcm_open(&gcm, buf, buf, len + 16, iv, 12, NULL, 0) != 0 ||
+		    !eq(buf, pt, (unsigned int)len))
+			return 0;
+
+		/* a forged record leaves no plaintext behind */
+		for (int i = 0; i < len + 16; i++)
+			buf[i] = ref[i];
+		buf[len + 15] ^= 0x80;
+		if (aes_gcm_open(&gcm, buf, buf, len + 16, iv, 12, NULL, 0) == 0 ||
+		    eq(buf, pt, (unsigned int)len))
+			return 0;
+	}
+	return 1;
+}
+
 static int test_aes256_gcm(void)
 {
 	u8 key[32] = {0}, iv[12] = {0}, pt[16] = {0};
@@ -114,6 +548,445 @@ static int test_aes128_cbc(void)
 	return eq(buf, pt, 16);
 }
 
+/*
+ * AES-256-CBC, NIST SP800-38A F.2.5/F.2.6 (four blocks). The key is expanded
+ * once; each record only resets the IV. A 160-byte record decrypted in two
+ * calls then checks the IV chains across the multi-block decrypt path.
+ */
+static int test_aes256_cbc_keyed(void)
+{
+	struct aes256_ctx ctx;
+	static const u8 key[32] = {
+		0x60,0x3d,0xeb,0x10,0x15,0xca,0x71,0xbe,0x2b,0x73,0xae,0xf0,
+		0x85,0x7d,0x77,0x81,0x1f,0x35,0x2c,0x07,0x3b,0x61,0x08,0xd7,
+		0x2d,0x98,0x10,0xa3,0x09,0x14,0xdf,0xf4 };
+	static const u8 iv[16] = {
+		0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,
+		0x08,0x09,0x0a,0x0b,0x0c,0x0d,0x0e,0x0f };
+	static const u8 pt[64] = {
+		0x6b,0xc1,0xbe,0xe2,0x2e,0x40,0x9f,0x96,0xe9,0x3d,0x7e,0x11,
+		0x73,0x93,0x17,0x2a,0xae,0x2d,0x8a,0x57,0x1e,0x03,0xac,0x9c,
+		0x9e,0xb7,0x6f,0xac,0x45,0xaf,0x8e,0x51,0x30,0xc8,0x1c,0x46,
+		0xa3,0x5c,0xe4,0x11,0xe5,0xfb,0xc1,0x19,0x1a,0x0a,0x52,0xef,
+		0xf6,0x9f,0x24,0x45,0xdf,0x4f,0x9b,0x17,0xad,0x2b,0x41,0x7b,
+		0xe6,0x6c,0x37,0x10 };
+	static const u8 want[64] = {
+		0xf5,0x8c,0x4c,0x04,0xd6,0xe5,0xf1,0xba,0x77,0x9e,0xab,0xfb,
+		0x5f,0x7b,0xfb,0xd6,0x9c,0xfc,0x4e,0x96,0x7e,0xdb,0x80,0x8d,
+		0x67,0x9f,0x77,0x7b,0xc6,0x70,0x2c,0x7d,0x39,0xf2,0x33,0x69,
+		0xa9,0xd9,0xba,0xcf,0xa5,0x30,0xe2,0x63,0x04,0x23,0x14,0x61,
+		0xb2,0xeb,0x05,0xe2,0xc3,0x9b,0xe9,0xfc,0xda,0x6c,0x19,0x07,
+		0x8c,0x6a,0x9d,0x1b };
+	u8 buf[160], ref[160];
+	unsigned int i;
+
+	aes_init_keygen_tables();
+	aes256_cbc_init(&ctx, key);
+	for (i = 0; i < 64; i++)
+		buf[i] = pt[i];
+	aes256_cbc_set_iv(&ctx, iv);
+	aes256_cbc_encrypt(&ctx, buf, 64);
+	if (!eq(buf, want, 64))
+		return 0;
+	aes256_cbc_set_iv(&ctx, iv);
+	aes256_cbc_decrypt(&ctx, buf, 64);
+	if (!eq(buf, pt, 64))
+		return 0;
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = ref[i] = (u8)(i * 7);
+	aes256_cbc_set_iv(&ctx, iv);
+	aes256_cbc_encrypt(&ctx, buf, 160);
+	aes256_cbc_set_iv(&ctx, iv);
+	aes256_cbc_decrypt(&ctx, buf, 96);
+	aes256_cbc_decrypt(&ctx, buf + 96, 64);
+	return eq(buf, ref, 160);
+}
+
+/*
+ * AES-128-CTR, NIST SP800-38A F.5.1/F.5.2, fed in uneven pieces so the
+ * partial keystream block is carried across calls, then decrypted in place.
+ */
+static int test_aes128_ctr(void)
+{
+	struct aes_ctr_ctx ctx;
+	static const u8 key[16] = {
+		0x2b,0x7e,0x15,0x16,0x28,0xae,0xd2,0xa6,
+		0xab,0xf7,0x15,0x88,0x09,0xcf,0x4f,0x3c };
+	static const u8 ctr[16] = {
+		0xf0,0xf1,0xf2,0xf3,0xf4,0xf5,0xf6,0xf7,
+		0xf8,0xf9,0xfa,0xfb,0xfc,0xfd,0xfe,0xff };
+	static const u8 pt[64] = {
+		0x6b,0xc1,0xbe,0xe2,0x2e,0x40,0x9f,0x96,0xe9,0x3d,0x7e,0x11,
+		0x73,0x93,0x17,0x2a,0xae,0x2d,0x8a,0x57,0x1e,0x03,0xac,0x9c,
+		0x9e,0xb7,0x6f,0xac,0x45,0xaf,0x8e,0x51,0x30,0xc8,0x1c,0x46,
+		0xa3,0x5c,0xe4,0x11,0xe5,0xfb,0xc1,0x19,0x1a,0x0a,0x52,0xef,
+		0xf6,0x9f,0x24,0x45,0xdf,0x4f,0x9b,0x17,0xad,0x2b,0x41,0x7b,
+		0xe6,0x6c,0x37,0x10 };
+	static const u8 want[64] = {
+		0x87,0x4d,0x61,0x91,0xb6,0x20,0xe3,0x26,0x1b,0xef,0x68,0x64,
+		0x99,0x0d,0xb6,0xce,0x98,0x06,0xf6,0x6b,0x79,0x70,0xfd,0xff,
+		0x86,0x17,0x18,0x7b,0xb9,0xff,0xfd,0xff,0x5a,0xe4,0xdf,0x3e,
+		0xdb,0xd5,0xd3,0x5e,0x5b,0x4f,0x09,0x02,0x0d,0xb0,0x3e,0xab,
+		0x1e,0x03,0x1d,0xda,0x2f,0xbe,0x03,0xd1,0x79,0x21,0x70,0xa0,
+		0xf3,0x00,0x9c,0xee };
+	static const unsigned int cut[] = { 1, 15, 17, 3, 28 };
+	u8 buf[64];
+	unsigned int i, off = 0;
+
+	aes_init_keygen_tables();
+	if (aes_ctr_setkey(&ctx, key, 16) != 0)
+		return 0;
+	aes_ctr_set_iv(&ctx, ctr);
+	for (i = 0; i < sizeof(cut) / sizeof(cut[0]); i++) {
+		aes_ctr_crypt(&ctx, pt + off, buf + off, cut[i]);
+		off += cut[i];
+	}
+	if (!eq(buf, want, 64))
+		return 0;
+	aes_ctr_set_iv(&ctx, ctr);
+	aes_ctr_crypt(&ctx, buf, buf, 64);
+	return eq(buf, pt, 64);
+}
+
+/*
+ * AES-256-CTR, NIST SP800-38A F.5.5 in one call, then an 83-byte message
+ * under a counter block whose low 40 bits are all ones: the carry out of the
+ * 32-bit word the hardware kernels increment must reach bytes 11 and 10.
+ * Reference output from OpenSSL's 128-bit counter.
+ */
+static int test_aes256_ctr(void)
+{
+	struct aes_ctr_ctx ctx;
+	static const u8 key[32] = {
+		0x60,0x3d,0xeb,0x10,0x15,0xca,0x71,0xbe,0x2b,0x73,0xae,0xf0,
+		0x85,0x7d,0x77,0x81,0x1f,0x35,0x2c,0x07,0x3b,0x61,0x08,0xd7,
+		0x2d,0x98,0x10,0xa3,0x09,0x14,0xdf,0xf4 };
+	static const u8 ctr[16] = {
+		0xf0,0xf1,0xf2,0xf3,0xf4,0xf5,0xf6,0xf7,
+		0xf8,0xf9,0xfa,0xfb,0xfc,0xfd,0xfe,0xff };
+	static const u8 pt[64] = {
+		0x6b,0xc1,0xbe,0xe2,0x2e,0x40,0x9f,0x96,0xe9,0x3d,0x7e,0x11,
+		0x73,0x93,0x17,0x2a,0xae,0x2d,0x8a,0x57,0x1e,0x03,0xac,0x9c,
+		0x9e,0xb7,0x6f,0xac,0x45,0xaf,0x8e,0x51,0x30,0xc8,0x1c,0x46,
+		0xa3,0x5c,0xe4,0x11,0xe5,0xfb,0xc1,0x19,0x1a,0x0a,0x52,0xef,
+		0xf6,0x9f,0x24,0x45,0xdf,0x4f,0x9b,0x17,0xad,0x2b,0x41,0x7b,
+		0xe6,0x6c,0x37,0x10 };
+	static const u8 want[64] = {
+		0x60,0x1e,0xc3,0x13,0x77,0x57,0x89,0xa5,0xb7,0xa7,0xf5,0x04,
+		0xbb,0xf3,0xd2,0x28,0xf4,0x43,0xe3,0xca,0x4d,0x62,0xb5,0x9a,
+		0xca,0x84,0xe9,0x90,0xca,0xca,0xf5,0xc5,0x2b,0x09,0x30,0xda,
+		0xa2,0x3d,0xe9,0x4c,0xe8,0x70,0x17,0xba,0x2d,0x84,0x98,0x8d,
+		0xdf,0xc9,0xc5,0x8d,0xb6,0x7a,0xad,0xa6,0x13,0xc2,0xdd,0x08,
+		0x45,0x79,0x41,0xa6 };
+	static const u8 wkey[16] = {
+		0x2b,0x7e,0x15,0x16,0x28,0xae,0xd2,0xa6,
+		0xab,0xf7,0x15,0x88,0x09,0xcf,0x4f,0x3c };
+	static const u8 wctr[16] = {
+		0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,
+		0x08,0x09,0x0a,0xff,0xff,0xff,0xff,0xff };
+	static const u8 wwant[83] = {
+		0x89,0x61,0xbd,0x76,0xc8,0x69,0xd0,0xc4,0x21,0xfc,0x1e,0x9b,
+		0xd3,0x79,0x9a,0xd7,0xbd,0x6f,0x1e,0xe2,0xf9,0xca,0x46,0x76,
+		0x95,0x91,0xa8,0x7b,0x0e,0xa8,0xba,0xec,0x9a,0x62,0x0f,0xfe,
+		0x35,0x5b,0xd7,0xe4,0xad,0x0a,0xe9,0xb6,0x1a,0x8c,0x3f,0x56,
+		0xc0,0xe6,0x96,0x10,0xad,0x84,0xee,0xcb,0x67,0x20,0x5f,0x23,
+		0x4d,0xe9,0xe3,0xef,0x3c,0xa8,0xa0,0x49,0xbd,0xaf,0x05,0x89,
+		0xa4,0xed,0xec,0x83,0x9c,0xa3,0x5c,0xc6,0x6c,0x59,0x70 };
+	u8 buf[83];
+	unsigned int i;
+
+	aes_init_keygen_tables();
+	if (aes_ctr_setkey(&ctx, key, 32) != 0)
+		return 0;
+	aes_ctr_set_iv(&ctx, ctr);
+	aes_ctr_crypt(&ctx, pt, buf, 64);
+	if (!eq(buf, want, 64))
+		return 0;
+
+	if (aes_ctr_setkey(&ctx, wkey, 16) != 0)
+		return 0;
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = (u8)i;
+	aes_ctr_set_iv(&ctx, wctr);
+	aes_ctr_crypt(&ctx, buf, buf, 7);
+	aes_ctr_crypt(&ctx, buf + 7, buf + 7, 50);
+	aes_ctr_crypt(&ctx, buf + 57, buf + 57, 26);
+	return eq(buf, wwant, 83);
+}
+
+/*
+ * AES-128-CCM (16-byte tag) with a TLS-sized 12-byte nonce and 13-byte AAD
+ * (key[i] = 0x40 + i, nonce[i] = 0x10 + i, aad[i] = 0x20 + i, pt[i] = i):
+ * 40 bytes exercise two full blocks and a partial tail. From OpenSSL.
+ */
+static int test_aes128_ccm(void)
+{
+	struct aes_ccm_key ccm;
+	static const u8 ct[40] = {
+		0xc3,0x92,0x21,0x89,0xd5,0x97,0x3a,0x5a,0xbb,0x3c,0xca,0xcc,
+		0xed,0xb7,0xc7,0x2b,0x41,0x56,0x8a,0xf9,0x84,0x62,0xaa,0x85,
+		0x74,0x3b,0xf1,0xf4,0x36,0xda,0x2c,0xc3,0x8c,0x57,0xcf,0x40,
+		0x0e,0x02,0x18,0xce };
+	static const u8 tag[16] = {
+		0x98,0x7f,0x17,0x09,0xbe,0x93,0x93,0x21,0x4a,0xcd,0x70,0x79,
+		0x04,0x57,0x7f,0x7c };
+	u8 key[16], nonce[12], aad[13], pt[40], out[56], dec[40];
+	unsigned int i;
+
+	for (i = 0; i < 16; i++)
+		key[i] = (u8)(0x40 + i);
+	for (i = 0; i < 12; i++)
+		nonce[i] = (u8)(0x10 + i);
+	for (i = 0; i < 13; i++)
+		aad[i] = (u8)(0x20 + i);
+	for (i = 0; i < 40; i++)
+		pt[i] = (u8)i;
+
+	aes_init_keygen_tables();
+	if (aes_ccm_setkey(&ccm, key, 16, 16) != 0)
+		return 0;
+	aes_ccm_seal(&ccm, out, pt, 40, nonce, 12, aad, 13);
+	if (!eq(out, ct, 40) || !eq(out + 40, tag, 16))
+		return 0;
+	if (aes_ccm_open(&ccm, dec, out, 56, nonce, 12, aad, 13) != 0 ||
+	    !eq(dec, pt, 40))
+		return 0;
+	/* a flipped tag bit must be rejected */
+	out[55] ^= 1;
+	if (aes_ccm_open(&ccm, dec, out, 56, nonce, 12, aad, 13) == 0)
+		return 0;
+	return 1;
+}
+
+/*
+ * AES-256-CCM_8 over 100 bytes, same inputs as above with a 32-byte key;
+ * opened in place. From OpenSSL.
+ */
+static int test_aes256_ccm8(void)
+{
+	struct aes_ccm_key ccm;
+	static const u8 ct[16] = {
+		0x24,0xd8,0xa3,0x8e,0x93,0x9d,0x27,0x10,0xca,0xd5,0x2b,0x96,
+		0xfe,0x6f,0x82,0x01 };
+	static const u8 tag[8] = {
+		0x01,0x2b,0x6d,0x15,0x9a,0xa1,0x55,0x07 };
+	u8 key[32], nonce[12], aad[13], buf[108];
+	unsigned int i;
+
+	for (i = 0; i < 32; i++)
+		key[i] = (u8)(0x40 + i);
+	for (i = 0; i < 12; i++)
+		nonce[i] = (u8)(0x10 + i);
+	for (i = 0; i < 13; i++)
+		aad[i] = (u8)(0x20 + i);
+	for (i = 0; i < 100; i++)
+		buf[i] = (u8)i;
+
+	aes_init_keygen_tables();
+	if (aes_ccm_setkey(&ccm, key, 32, 8) != 0)
+		return 0;
+	aes_ccm_seal(&ccm, buf, buf, 100, nonce, 12, aad, 13);
+	if (!eq(buf, ct, 16) || !eq(buf + 100, tag, 8))
+		return 0;
+	if (aes_ccm_open(&ccm, buf, buf, 108, nonce, 12, aad, 13) != 0)
+		return 0;
+	for (i = 0; i < 100; i++)
+		if (buf[i] != (u8)i)
+			return 0;
+	return 1;
+}
+
+/* Poly1305, RFC 7539 section 2.5.2 and the appendix A.3 reduction cases. */
+static int test_poly1305(void)
+{
+	static const u8 key[32] = {
+		0x85,0xd6,0xbe,0x78,0x57,0x55,0x6d,0x33,0x7f,0x44,0x52,0xfe,
+		0x42,0xd5,0x06,0xa8,0x01,0x03,0x80,0x8a,0xfb,0x0d,0xb2,0xfd,
+		0x4a,0xbf,0xf6,0xaf,0x41,0x49,0xf5,0x1b };
+	static const char msg[] = "Cryptographic Forum Research Group";
+	static const u8 want[16] = {
+		0xa8,0x06,0x1d,0xc1,0x30,0x51,0x36,0xc6,
+		0xc2,0x2b,0x8b,0xaf,0x0c,0x01,0x27,0xa9 };
+	/* A.3 #5-#9: r is 1 or 2, s is 0 or all ones */
+	static const struct {
+		u8 r, s, m[48];
+		unsigned int len;
+		u8 tag0, tag_rest;
+	} edge[] = {
+		{ 2, 0x00, { 0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+			     0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff }, 16, 0x03, 0x00 },
+		{ 2, 0xff, { 0x02 }, 16, 0x03, 0x00 },
+		{ 1, 0x00, { 0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+			     0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+			     0xf0,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+			     0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+			     0x11 }, 48, 0x05, 0x00 },
+		{ 1, 0x00, { 0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+			     0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+			     0xfb,0xfe,0xfe,0xfe,0xfe,0xfe,0xfe,0xfe,
+			     0xfe,0xfe,0xfe,0xfe,0xfe,0xfe,0xfe,0xfe,
+			     0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,
+			     0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01 }, 48, 0x00, 0x00 },
+		{ 2, 0x00, { 0xfd,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+			     0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff }, 16, 0xfa, 0xff },
+	};
+	u8 k[32], tag[16];
+
+	poly1305_auth(tag, (const u8 *)msg, 34, key);
+	if (!eq(tag, want, 16))
+		return 0;
+
+	for (unsigned int i = 0; i < sizeof(edge) / sizeof(edge[0]); i++) {
+		for (unsigned int j = 0; j < 32; j++)
+			k[j] = j < 16 ? 0 : edge[i].s;
+		k[0] = edge[i].r;
+		poly1305_auth(tag, edge[i].m, edge[i].len, k);
+		if (tag[0] != edge[i].tag0)
+			return 0;
+		for (unsigned int j = 1; j < 16; j++)
+			if (tag[j] != edge[i].tag_rest)
+				return 0;
+	}
+	return 1;
+}
+
+/*
+ * Every length 0..1023 one-shot and through uneven updates, so each
+ * implementation's split between SIMD strides and scalar blocks is crossed;
+ * the 1024 tags are then folded into one checked against a reference.
+ */
+static int test_poly1305_lengths(void)
+{
+	static u8 msg[1024], tags[1024 * 16];
+	static const unsigned int chunk[] = { 1, 15, 17, 64, 129, 250 };
+	static const u8 want[16] = {
+		0xae,0x8d,0x62,0x4e,0x44,0xeb,0x33,0x5b,
+		0xcb,0x05,0x57,0x72,0x1a,0xbf,0x8d,0x33 };
+	struct poly1305_context ctx;
+	unsigned int c, k, off;
+	u8 key[32], tag[16];
+
+	for (unsigned int i = 0; i < 32; i++)
+		key[i] = (u8)(0x40 + 3 * i);
+	for (unsigned int i = 0; i < sizeof(msg); i++)
+		msg[i] = (u8)(i * 13 + 5);
+
+	for (unsigned int n = 0; n < 1024; n++) {
+		poly1305_auth(tags + 16 * n, msg, n, key);
+
+		poly1305_init(&ctx, key);
+		for (off = 0, c = n % 6; off < n; off += k, c = (c + 1) % 6) {
+			k = chunk[c] < n - off ? chunk[c] : n - off;
+			poly1305_update(&ctx, msg + off, k);
+		}
+		poly1305_finish(&ctx, tag);
+		if (!eq(tag, tags + 16 * n, 16))
+			return 0;
+	}
+
+	for (unsigned int i = 0; i < 32; i++)
+		key[i] = (u8)(0xa5 ^ i);
+	poly1305_auth(tag, tags, sizeof(tags), key);
+	return eq(tag, want, 16);
+}
+
+/*
+ * Multi-message Poly1305 against one poly1305_auth per message: lengths from
+ * empty to several hundred bytes so the lanes run out at different times,
+ * contexts resumed mid-block, and a verify batch with two forged tags.
+ */
+static int test_poly1305_mb(void)
+{
+	static u8 msg[8192], keys[37][32], tags[37][16], want[37][16];
+	struct poly1305_mb job[37];
+	struct poly1305_context ctx[37], *cp[37];
+	const u8 *m[37];
+	size_t len[37], off;
+	unsigned int i, n = 37;
+
+	for (i = 0; i < sizeof(msg); i++)
+		msg[i] = (u8)(i * 7 + 3);
+	for (off = 0, i = 0; i < n; i++) {
+		for (unsigned int k = 0; k < 32; k++)
+			keys[i][k] = (u8)(i * 11 + k * 5 + 1);
+		job[i].key = keys[i];
+		job[i].msg = msg + off;
+		job[i].len = (i * 37) % 230 + (i == 5 ? 1000 : 0);
+		job[i].mac = tags[i];
+		poly1305_auth(want[i], job[i].msg, job[i].len, keys[i]);
+		off += job[i].len;
+	}
+
+	poly1305_auth_mb(job, n);
+	for (i = 0; i < n; i++)
+		if (!eq(tags[i], want[i], 16))
+			return 0;
+
+	/* resume contexts that already hold part of a block */
+	for (i = 0; i < n; i++) {
+		size_t head = job[i].len < 5 ? job[i].len : 5;
+
+		poly1305_init(&ctx[i], keys[i]);
+		poly1305_update(&ctx[i], job[i].msg, head);
+		cp[i] = &ctx[i];
+		m[i] = job[i].msg + head;
+		len[i] = job[i].len - head;
+	}
+	poly1305_update_mb(cp, m, len, n);
+	for (i = 0; i < n; i++) {
+		poly1305_finish(&ctx[i], tags[i]);
+		if (!eq(tags[i], want[i], 16))
+			return 0;
+	}
+
+	tags[3][0] ^= 1;
+	tags[30][15] ^= 0x80;
+	if (poly1305_verify_mb(job, n) != 2)
+		return 0;
+	for (i = 0; i < n; i++)
+		if ((job[i].status != 0) != (i == 3 || i == 30))
+			return 0;
+	return 1;
+}
+
+/*
+ * ChaCha20-Poly1305 over 4 KiB and a few odd lengths in one call, against
+ * the same record encrypted 64 bytes at a time: the bulk call runs the SIMD
+ * kernel the backend picked for this CPU, the small steps its scalar path.
+ */
+static int test_chacha20_bulk(void)
+{
+	static u8 pt[4096 + 77], ct[sizeof(pt)], ref[sizeof(pt)];
+	static const unsigned int lens[] = { 4096 + 77, 1024, 1000, 129, 65 };
+	struct chacha_ctx x;
+	u8 key[32], nonce[12], ctr[4] = { 1, 0, 0, 0 };
+
+	for (unsigned int i = 0; i < 32; i++)
+		key[i] = (u8)(7 * i + 1);
+	for (unsigned int i = 0; i < 12; i++)
+		nonce[i] = (u8)(0xa0 + i);
+	for (unsigned int i = 0; i < sizeof(pt); i++)
+		pt[i] = (u8)(i * 31 + 9);
+
+	for (unsigned int l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+		unsigned int len = lens[l];
+
+		chacha_keysetup(&x, key, 256);
+		chacha_ivsetup(&x, nonce, ctr);
+		chacha_encrypt_bytes(&x, pt, ct, len);
+
+		chacha_keysetup(&x, key, 256);
+		chacha_ivsetup(&x, nonce, ctr);
+		for (unsigned int off = 0; off < len; off += 64)
+			chacha_encrypt_bytes(&x, pt + off, ref + off,
+					     len - off < 64 ? len - off : 64);
+		if (!eq(ct, ref, len))
+			return 0;
+	}
+	return 1;
+}
+
 /* ChaCha20-Poly1305 AEAD, RFC 7539 section 2.8.2 (with AAD). */
 static int test_chacha20_poly1305(void)
 {
@@ -157,7 +1030,310 @@ static int test_chacha20_poly1305(void)
 	if (chachapoly_crypt(&ctx, nonce, aad, 12, ct, ptlen, dec,
 			     ct + ptlen, 16, 0) != 0)
 		return 0;
-	return eq(dec, (const u8 *)pt, ptlen);
+	if (!eq(dec, (const u8 *)pt, ptlen))
+		return 0;
+
+	/* one flipped ciphertext bit fails authentication */
+	ct[0] ^= 1;
+	return chachapoly_crypt(&ctx, nonce, aad, 12, ct, ptlen, dec,
+				ct + ptlen, 16, 0) == CHACHAPOLY_INVALID_MAC;
+}
+
+/* Batched records against one chachapoly_crypt each, two sharing a ctx. */
+static int test_chacha20_poly1305_mb(void)
+{
+	static u8 pt[4096], ct[4096], ref[4096], dec[4096];
+	static u8 tags[21][16], want[21][16];
+	struct chachapoly_ctx ctx[2];
+	struct chachapoly_mb rec[21];
+	u8 key[32], nonces[21][12], aad[21];
+	unsigned int i, n = 21, off;
+
+	for (i = 0; i < sizeof(pt); i++)
+		pt[i] = (u8)(i * 29 + 7);
+	for (i = 0; i < sizeof(aad); i++)
+		aad[i] = (u8)(0xe0 + i);
+	for (i = 0; i < 32; i++)
+		key[i] = (u8)(0x11 * i + 2);
+	chachapoly_init(&ctx[0], key, 256);
+	key[0] ^= 0xff;
+	chachapoly_init(&ctx[1], key, 256);
+
+	for (off = 0, i = 0; i < n; i++) {
+		for (unsigned int k = 0; k < 12; k++)
+			nonces[i][k] = (u8)(i + k);
+		rec[i].ctx = &ctx[i % 2];
+		rec[i].nonce = nonces[i];
+		rec[i].ad = aad;
+		rec[i].ad_len = (int)(i % 14);
+		rec[i].in = pt + off;
+		rec[i].out = ct + off;
+		rec[i].len = (int)((i * 23) % 200 + (i == 7 ? 300 : 0));
+		rec[i].tag = tags[i];
+		chachapoly_crypt(rec[i].ctx, nonces[i], aad, rec[i].ad_len,
+				 pt + off, rec[i].len, ref + off, want[i], 16, 1);
+		off += (unsigned int)rec[i].len;
+	}
+
+	if (chachapoly_crypt_mb(rec, n, 1) != 0 || !eq(ct, ref, off))
+		return 0;
+	for (i = 0; i < n; i++)
+		if (!eq(tags[i], want[i], 16))
+			return 0;
+
+	/* open in place, one forged record */
+	tags[9][4] ^= 1;
+	for (off = 0, i = 0; i < n; i++) {
+		rec[i].in = rec[i].out = dec + off;
+		for (int k = 0; k < rec[i].len; k++)
+			dec[off + k] = ct[off + k];
+		off += (unsigned int)rec[i].len;
+	}
+	if (chachapoly_crypt_mb(rec, n, 0) != 1)
+		return 0;
+	for (off = 0, i = 0; i < n; i++) {
+		if ((rec[i].status != CHACHAPOLY_OK) != (i == 9))
+			return 0;
+		if (!eq(dec + off, i == 9 ? ct + off : pt + off,
+			(unsigned int)rec[i].len))
+			return 0;
+		off += (unsigned int)rec[i].len;
+	}
+	return 1;
+}
+
+/* Sealing and opening with output == input, against the two-buffer result. */
+static int test_chacha20_poly1305_inplace(void)
+{
+	static u8 pt[1500], ref[sizeof(pt) + 16], buf[sizeof(pt) + 16];
+	static const unsigned int lens[] = { 1500, 77 };
+	struct chachapoly_ctx ctx;
+	u8 key[32], nonce[12];
+
+	for (unsigned int i = 0; i < 32; i++)
+		key[i] = (u8)(3 * i + 5);
+	for (unsigned int i = 0; i < 12; i++)
+		nonce[i] = (u8)(0x30 + i);
+	for (unsigned int i = 0; i < sizeof(pt); i++)
+		pt[i] = (u8)(i * 13 + 1);
+	chachapoly_init(&ctx, key, 256);
+
+	for (unsigned int l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+		int len = (int)lens[l];
+
+		chachapoly_crypt(&ctx, nonce, NULL, 0, pt, len, ref, ref + len,
+				 16, 1);
+		for (int i = 0; i < len; i++)
+			buf[i] = pt[i];
+		chachapoly_crypt(&ctx, nonce, NULL, 0, buf, len, buf, buf + len,
+				 16, 1);
+		if (!eq(buf, ref, (unsigned int)len + 16))
+			return 0;
+
+		if (chachapoly_crypt(&ctx, nonce, NULL, 0, buf, len, buf,
+				     buf + len, 16, 0) != 0 ||
+		    !eq(buf, pt, (unsigned int)len))
+			return 0;
+
+		/* a forged record leaves no plaintext behind */
+		for (int i = 0; i < len + 16; i++)
+			buf[i] = ref[i];
+		buf[len + 15] ^= 0x80;
+		if (chachapoly_crypt(&ctx, nonce, NULL, 0, buf, len, buf,
+				     buf + len, 16, 0) != CHACHAPOLY_INVALID_MAC ||
+		    eq(buf, pt, (unsigned int)len))
+			return 0;
+	}
+	return 1;
+}
+
+/* draft-irtf-cfrg-xchacha-03, section 2.2.1 */
+static int test_hchacha20(void)
+{
+	static const u8 nonce[16] = {
+		0x00,0x00,0x00,0x09,0x00,0x00,0x00,0x4a,0x00,0x00,0x00,0x00,
+		0x31,0x41,0x59,0x27 };
+	static const u8 want[32] = {
+		0x82,0x41,0x3b,0x42,0x27,0xb2,0x7b,0xfe,0xd3,0x0e,0x42,0x50,
+		0x8a,0x87,0x7d,0x73,0xa0,0xf9,0xe4,0xd5,0x8a,0x74,0xa8,0x53,
+		0xc1,0x2e,0xc4,0x13,0x26,0xd3,0xec,0xdc };
+	u8 key[32], out[32];
+
+	for (unsigned int i = 0; i < 32; i++)
+		key[i] = (u8)i;
+
+	hchacha20(out, key, nonce);
+	return eq(out, want, 32);
+}
+
+/* draft-irtf-cfrg-xchacha-03, appendix A.3.1 */
+static int test_xchacha20_poly1305(void)
+{
+	struct chachapoly_ctx ctx;
+	u8 key[32], nonce[XCHACHAPOLY_NONCE_LEN], nonce12[12];
+	static const u8 aad[12] = {
+		0x50,0x51,0x52,0x53,0xc0,0xc1,0xc2,0xc3,0xc4,0xc5,0xc6,0xc7 };
+	static const char pt[] =
+		"Ladies and Gentlemen of the class of '99: If I could offer you "
+		"only one tip for the future, sunscreen would be it.";
+	const int ptlen = 114;
+	static const u8 want_ct[114] = {
+		0xbd,0x6d,0x17,0x9d,0x3e,0x83,0xd4,0x3b,0x95,0x76,0x57,0x94,
+		0x93,0xc0,0xe9,0x39,0x57,0x2a,0x17,0x00,0x25,0x2b,0xfa,0xcc,
+		0xbe,0xd2,0x90,0x2c,0x21,0x39,0x6c,0xbb,0x73,0x1c,0x7f,0x1b,
+		0x0b,0x4a,0xa6,0x44,0x0b,0xf3,0xa8,0x2f,0x4e,0xda,0x7e,0x39,
+		0xae,0x64,0xc6,0x70,0x8c,0x54,0xc2,0x16,0xcb,0x96,0xb7,0x2e,
+		0x12,0x13,0xb4,0x52,0x2f,0x8c,0x9b,0xa4,0x0d,0xb5,0xd9,0x45,
+		0xb1,0x1b,0x69,0xb9,0x82,0xc1,0xbb,0x9e,0x3f,0x3f,0xac,0x2b,
+		0xc3,0x69,0x48,0x8f,0x76,0xb2,0x38,0x35,0x65,0xd3,0xff,0xf9,
+		0x21,0xf9,0x66,0x4c,0x97,0x63,0x7d,0xa9,0x76,0x88,0x12,0xf6,
+		0x15,0xc6,0x8b,0x13,0xb5,0x2e };
+	static const u8 want_tag[16] = {
+		0xc0,0x87,0x59,0x24,0xc1,0xc7,0x98,0x79,
+		0x47,0xde,0xaf,0xd8,0x78,0x0a,0xcf,0x49 };
+	u8 ct[114], dec[114], tag[16];
+
+	for (unsigned int i = 0; i < 32; i++)
+		key[i] = (u8)(0x80 + i);
+	for (unsigned int i = 0; i < XCHACHAPOLY_NONCE_LEN; i++)
+		nonce[i] = (u8)(0x40 + i);
+
+	xchachapoly_init(&ctx, key, nonce, nonce12);
+	chachapoly_crypt(&ctx, nonce12, aad, 12, (void *)pt, ptlen, ct, tag,
+			 16, 1);
+	if (!eq(ct, want_ct, ptlen) || !eq(tag, want_tag, 16))
+		return 0;
+
+	if (chachapoly_crypt(&ctx, nonce12, aad, 12, ct, ptlen, dec, tag, 16,
+			     0) != 0)
+		return 0;
+	if (!eq(dec, (const u8 *)pt, ptlen))
+		return 0;
+
+	/* a different nonce prefix derives a different subkey */
+	nonce[0] ^= 1;
+	xchachapoly_init(&ctx, key, nonce, nonce12);
+	return chachapoly_crypt(&ctx, nonce12, aad, 12, ct, ptlen, dec, tag,
+				16, 0) == CHACHAPOLY_INVALID_MAC;
+}
+
+static void
+gcm_iov_step(void *st, const u8 *in, u8 *out, unsigned int len)
+{
+	aes_gcm_stream_update((struct aes_gcm_stream *)st, in, out, len);
+}
+
+static void
+chachapoly_iov_step(void *st, const u8 *in, u8 *out, unsigned int len)
+{
+	chachapoly_stream_update((struct chachapoly_stream *)st, in, out, len);
+}
+
+/*
+ * NIST GCM Test Case 4 walked as the open_iov/seal_iov backends do: the
+ * plaintext and ciphertext chains are split at different offsets, neither
+ * on a block boundary, then the record is opened in place.
+ */
+static int test_aes128_gcm_iov(void)
+{
+	struct aes_gcm_key gcm;
+	struct aes_gcm_stream st;
+	static const u8 key[16] = {
+		0xfe,0xff,0xe9,0x92,0x86,0x65,0x73,0x1c,0x6d,0x6a,0x8f,0x94,
+		0x67,0x30,0x83,0x08 };
+	static const u8 iv[12] = {
+		0xca,0xfe,0xba,0xbe,0xfa,0xce,0xdb,0xad,0xde,0xca,0xf8,0x88 };
+	static const u8 aad[20] = {
+		0xfe,0xed,0xfa,0xce,0xde,0xad,0xbe,0xef,0xfe,0xed,0xfa,0xce,
+		0xde,0xad,0xbe,0xef,0xab,0xad,0xda,0xd2 };
+	static u8 pt[60] = {
+		0xd9,0x31,0x32,0x25,0xf8,0x84,0x06,0xe5,0xa5,0x59,0x09,0xc5,
+		0xaf,0xf5,0x26,0x9a,0x86,0xa7,0xa9,0x53,0x15,0x34,0xf7,0xda,
+		0x2e,0x4c,0x30,0x3d,0x8a,0x31,0x8a,0x72,0x1c,0x3c,0x0c,0x95,
+		0x95,0x68,0x09,0x53,0x2f,0xcf,0x0e,0x24,0x49,0xa6,0xb5,0x25,
+		0xb1,0x6a,0xed,0xf5,0xaa,0x0d,0xe6,0x57,0xba,0x63,0x7b,0x39 };
+	static const u8 ct[60] = {
+		0x42,0x83,0x1e,0xc2,0x21,0x77,0x74,0x24,0x4b,0x72,0x21,0xb7,
+		0x84,0xd0,0xd4,0x9c,0xe3,0xaa,0x21,0x2f,0x2c,0x02,0xa4,0xe0,
+		0x35,0xc1,0x7e,0x23,0x29,0xac,0xa1,0x2e,0x21,0xd5,0x14,0xb2,
+		0x54,0x66,0x93,0x1c,0x7d,0x8f,0x6a,0x5a,0xac,0x84,0xaa,0x05,
+		0x1b,0xa3,0x0b,0x39,0x6a,0x0a,0xac,0x97,0x3d,0x58,0xe0,0x91 };
+	static const u8 want[16] = {
+		0x5b,0xc9,0x4f,0xbc,0x32,0x21,0xa5,0xdb,0x94,0xfa,0xe9,0x5a,
+		0xe7,0x12,0x1a,0x47 };
+	u8 a[32], b[28], tag[16];
+	struct cipher_iovec src[3] = {
+		{ pt, 13 }, { pt + 13, 0 }, { pt + 13, 47 } };
+	struct cipher_iovec dst[2] = { { a, 32 }, { b, 28 } };
+
+	aes_init_keygen_tables();
+	if (aes_gcm_setkey(&gcm, key, 16) != 0)
+		return 0;
+	aes_gcm_stream_init(&st, &gcm, 1, iv, 12, aad, 20);
+	if (cipher_iov_walk(src, 3, dst, 2, gcm_iov_step, &st) != 60)
+		return 0;
+	aes_gcm_stream_final(&st, tag);
+	if (!eq(a, ct, 32) || !eq(b, ct + 32, 28) || !eq(tag, want, 16))
+		return 0;
+
+	/* open in place over the ciphertext chain */
+	aes_gcm_stream_init(&st, &gcm, 0, iv, 12, aad, 20);
+	if (cipher_iov_walk(dst, 2, dst, 2, gcm_iov_step, &st) != 60 ||
+	    aes_gcm_stream_final(&st, tag) != 0)
+		return 0;
+	if (!eq(a, pt, 32) || !eq(b, pt + 32, 28))
+		return 0;
+
+	/* chains of different total length are refused */
+	dst[1].len = 27;
+	aes_gcm_stream_init(&st, &gcm, 0, iv, 12, aad, 20);
+	return cipher_iov_walk(src, 3, dst, 2, gcm_iov_step, &st) < 0;
+}
+
+/* RFC 7539 2.8.2 again, over chains split mid-block (64-byte blocks). */
+static int test_chacha20_poly1305_iov(void)
+{
+	struct chachapoly_ctx ctx;
+	struct chachapoly_stream st;
+	u8 key[32];
+	static const u8 nonce[12] = {
+		0x07,0x00,0x00,0x00,0x40,0x41,0x42,0x43,0x44,0x45,0x46,0x47 };
+	static const u8 aad[12] = {
+		0x50,0x51,0x52,0x53,0xc0,0xc1,0xc2,0xc3,0xc4,0xc5,0xc6,0xc7 };
+	static char pt[] =
+		"Ladies and Gentlemen of the class of '99: If I could offer you "
+		"only one tip for the future, sunscreen would be it.";
+	static const u8 want_tag[16] = {
+		0x1a,0xe1,0x0b,0x59,0x4f,0x09,0xe2,0x6a,
+		0x7e,0x90,0x2e,0xcb,0xd0,0x60,0x06,0x91 };
+	u8 ref[114], ref_tag[16], a[70], b[44], tag[16];
+	struct cipher_iovec src[3] = {
+		{ (u8 *)pt, 5 }, { (u8 *)pt + 5, 60 }, { (u8 *)pt + 65, 49 } };
+	struct cipher_iovec dst[2] = { { a, 70 }, { b, 44 } };
+
+	for (unsigned int i = 0; i < 32; i++)
+		key[i] = (u8)(0x80 + i);
+	chachapoly_init(&ctx, key, 256);
+	chachapoly_crypt(&ctx, nonce, aad, 12, pt, 114, ref, ref_tag, 16, 1);
+
+	chachapoly_stream_init(&st, &ctx, nonce, aad, 12, 1);
+	if (cipher_iov_walk(src, 3, dst, 2, chachapoly_iov_step, &st) != 114)
+		return 0;
+	chachapoly_stream_final(&st, tag, 16);
+	if (!eq(a, ref, 70) || !eq(b, ref + 70, 44) || !eq(tag, want_tag, 16))
+		return 0;
+
+	chachapoly_stream_init(&st, &ctx, nonce, aad, 12, 0);
+	if (cipher_iov_walk(dst, 2, dst, 2, chachapoly_iov_step, &st) != 114 ||
+	    chachapoly_stream_final(&st, tag, 16) != 0)
+		return 0;
+	if (!eq(a, (const u8 *)pt, 70) || !eq(b, (const u8 *)pt + 70, 44))
+		return 0;
+
+	tag[15] ^= 1;
+	chachapoly_stream_init(&st, &ctx, nonce, aad, 12, 0);
+	cipher_iov_walk(src, 3, dst, 2, chachapoly_iov_step, &st);
+	return chachapoly_stream_final(&st, tag, 16) != 0;
 }
 
 int
@@ -167,8 +1343,34 @@ main(int argc, char *argv[])
 
 	(void)argc; (void)argv;
 	rc |= report("aes-128-gcm", test_aes128_gcm());
+	rc |= report("aes-128-gcm-keyed", test_aes128_gcm_keyed());
+	rc |= report("aes-128-gcm-aad", test_aes128_gcm_aad());
+	rc |= report("aes-128-gcm-bulk", test_aes128_gcm_bulk());
+	rc |= report("aes-128-gcm-explicit", test_aes128_gcm_explicit());
+	rc |= report("aes-128-gcm-compact", test_aes128_gcm_compact());
+	rc |= report("aes-gcm-setkey-batch", test_aes_gcm_setkey_batch());
+	rc |= report("aes-gcm-setkey-bulk", test_aes_gcm_setkey_bulk());
+	rc |= report("aes-128-gcm-stream", test_aes128_gcm_stream());
+	rc |= report("aes-128-gcm-iov", test_aes128_gcm_iov());
+	rc |= report("aes-gcm-open-mb", test_aes_gcm_open_mb());
+	rc |= report("aes-128-gcm-inplace", test_aes128_gcm_inplace());
 	rc |= report("aes-256-gcm", test_aes256_gcm());
 	rc |= report("aes-128-cbc", test_aes128_cbc());
+	rc |= report("aes-256-cbc-keyed", test_aes256_cbc_keyed());
+	rc |= report("aes-128-ctr", test_aes128_ctr());
+	rc |= report("aes-256-ctr", test_aes256_ctr());
+	rc |= report("aes-128-ccm", test_aes128_ccm());
+	rc |= report("aes-256-ccm-8", test_aes256_ccm8());
+	rc |= report("poly1305-kat", test_poly1305());
+	rc |= report("poly1305-lengths", test_poly1305_lengths());
+	rc |= report("poly1305-mb", test_poly1305_mb());
 	rc |= report("chacha20-poly1305", test_chacha20_poly1305());
+	rc |= report("chacha20-poly1305-iov", test_chacha20_poly1305_iov());
+	rc |= report("chacha20-poly1305-inplace",
+		     test_chacha20_poly1305_inplace());
+	rc |= report("chachapoly-crypt-mb", test_chacha20_poly1305_mb());
+	rc |= report("chacha20-bulk", test_chacha20_bulk());
+	rc |= report("hchacha20", test_hchacha20());
+	rc |= report("xchacha20-poly1305-kat", test_xchacha20_poly1305());
 	return rc;
 }
@@ -1,5 +1,12 @@
 #include <hpc/compiler.h>
 #include <crypto/digest.h>
+#if defined(CONFIG_CRYPTO_SHA2_MB)
+#include <crypto/digest/sha256-mb.h>
+#endif
+#if defined(CONFIG_CRYPTO_SHA3_MB)
+#include <crypto/digest/sha3-mb.h>
+#endif
+#include <crypto/digest/shake.h>
 
 #ifdef CONFIG_CC_CLIB
 #include <unistd.h>
@@ -37,6 +44,281 @@ test_sha3_256(void)
 	return 0;
 }
 
+static const u8 sha256_abc[SHA256_DIGEST_SIZE] = {
+	0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde,
+	0x5d, 0xae, 0x22, 0x23, 0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+	0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+};
+
+static const u8 sha512_abc[SHA512_DIGEST_SIZE] = {
+	0xdd, 0xaf, 0x35, 0xa1, 0x93, 0x61, 0x7a, 0xba, 0xcc, 0x41, 0x73, 0x49,
+	0xae, 0x20, 0x41, 0x31, 0x12, 0xe6, 0xfa, 0x4e, 0x89, 0xa9, 0x7e, 0xa2,
+	0x0a, 0x9e, 0xee, 0xe6, 0x4b, 0x55, 0xd3, 0x9a, 0x21, 0x92, 0x99, 0x2a,
+	0x27, 0x4f, 0xc1, 0xa8, 0x36, 0xba, 0x3c, 0x23, 0xa3, 0xfe, 0xeb, 0xbd,
+	0x45, 0x4d, 0x44, 0x23, 0x64, 0x3c, 0xe8, 0x0e, 0x2a, 0x9a, 0xc9, 0x4f,
+	0xa5, 0x4c, 0xa4, 0x9f
+};
+
+/* hash |msg| in one call, or in 37-byte pieces */
+static void
+hash_msg(enum algorithm_digest algo, const u8 *msg, unsigned int len,
+	 int split, u8 *out)
+{
+	struct digest d;
+	unsigned int i, n;
+
+	digest_init(&d, algo);
+	for (i = 0; i < len; i += n) {
+		n = split && len - i > 37 ? 37 : len - i;
+		digest_update(&d, msg + i, n);
+	}
+	digest_final(&d, out);
+}
+
+/*
+ * SHA-256/SHA-512 of "abc", and a 1000-byte message hashed whole and in
+ * pieces, through whichever block function the backend runs.
+ */
+static int
+test_sha2(void)
+{
+	static const enum algorithm_digest algo[2] = {
+		ALGORITHM_SHA2_256, ALGORITHM_SHA2_512 };
+	static const u8 *const abc[2] = { sha256_abc, sha512_abc };
+	static const unsigned int len[2] = {
+		SHA256_DIGEST_SIZE, SHA512_DIGEST_SIZE };
+	static u8 msg[1000];
+	u8 a[SHA512_DIGEST_SIZE], b[SHA512_DIGEST_SIZE];
+	unsigned int i, k;
+
+	for (i = 0; i < sizeof(msg); i++)
+		msg[i] = (u8)(i * 7 + 3);
+
+	for (k = 0; k < 2; k++) {
+		hash_msg(algo[k], (const u8 *)"abc", 3, 0, a);
+		for (i = 0; i < len[k]; i++)
+			if (a[i] != abc[k][i])
+				return -1;
+
+		hash_msg(algo[k], msg, sizeof(msg), 0, a);
+		hash_msg(algo[k], msg, sizeof(msg), 1, b);
+		for (i = 0; i < len[k]; i++)
+			if (a[i] != b[i])
+				return -1;
+	}
+	return 0;
+}
+
+#if defined(CONFIG_CRYPTO_SHA2_MB)
+/*
+ * Multi-buffer SHA-256 against the one-stream digest: "abc", then 70 jobs
+ * of 0..207 bytes (both padding shapes, whole blocks, more jobs than any
+ * kernel has lanes) through submit/flush, each coming back exactly once.
+ */
+static int
+test_sha256_mb(void)
+{
+	static struct sha256_mb_job job[70];
+	static u8 msg[256], seen[70];
+	struct sha256_mb_mgr mgr;
+	struct sha256_mb_job *done;
+	u8 a[SHA256_DIGEST_SIZE];
+	unsigned int i, k;
+
+	for (i = 0; i < sizeof(msg); i++)
+		msg[i] = (u8)(i * 5 + 1);
+
+	job[0].msg = (const u8 *)"abc";
+	job[0].len = 3;
+	sha256_mb(job, 1);
+	for (i = 0; i < SHA256_DIGEST_SIZE; i++)
+		if (job[0].digest[i] != sha256_abc[i])
+			return -1;
+
+	sha256_mb_init(&mgr);
+	for (k = 0; k < 70; k++) {
+		job[k].msg = msg + k % 7;
+		job[k].len = k * 3;
+		job[k].user = &seen[k];
+		if ((done = sha256_mb_submit(&mgr, &job[k])))
+			(*(u8 *)done->user)++;
+	}
+	while ((done = sha256_mb_flush(&mgr)))
+		(*(u8 *)done->user)++;
+
+	for (k = 0; k < 70; k++) {
+		if (seen[k] != 1)
+			return -1;
+		hash_msg(ALGORITHM_SHA2_256, job[k].msg, job[k].len, 0, a);
+		for (i = 0; i < SHA256_DIGEST_SIZE; i++)
+			if (a[i] != job[k].digest[i])
+				return -1;
+	}
+	return 0;
+}
+#endif
+
+#if defined(HAVE_DIGEST_SHA3_BUILT_IN) || defined(CONFIG_CRYPTO_SHA3_MB)
+static const u8 shake128_empty[32] = {
+	0x7f, 0x9c, 0x2b, 0xa4, 0xe8, 0x8f, 0x82, 0x7d, 0x61, 0x60, 0x45, 0x50,
+	0x76, 0x05, 0x85, 0x3e, 0xd7, 0x3b, 0x80, 0x93, 0xf6, 0xef, 0xbc, 0x88,
+	0xeb, 0x1a, 0x6e, 0xac, 0xfa, 0x66, 0xef, 0x26
+};
+#endif
+
+#ifdef HAVE_DIGEST_SHA3_BUILT_IN
+static const u8 shake256_empty[32] = {
+	0x46, 0xb9, 0xdd, 0x2b, 0x0b, 0xa8, 0x8d, 0x13, 0x23, 0x3b, 0x3f, 0xeb,
+	0x74, 0x3e, 0xeb, 0x24, 0x3f, 0xcd, 0x52, 0xea, 0x62, 0xb8, 0x1b, 0x82,
+	0xb5, 0x0c, 0x27, 0x64, 0x6e, 0xd5, 0x76, 0x2f
+};
+
+/* SP 800-185 samples: cSHAKE128 #1, KMAC128 #1, KMAC256 #4 */
+static const u8 cshake128_sample1[32] = {
+	0xc1, 0xc3, 0x69, 0x25, 0xb6, 0x40, 0x9a, 0x04, 0xf1, 0xb5, 0x04, 0xfc,
+	0xbc, 0xa9, 0xd8, 0x2b, 0x40, 0x17, 0x27, 0x7c, 0xb5, 0xed, 0x2b, 0x20,
+	0x65, 0xfc, 0x1d, 0x38, 0x14, 0xd5, 0xaa, 0xf5
+};
+
+static const u8 kmac128_sample1[32] = {
+	0xe5, 0x78, 0x0b, 0x0d, 0x3e, 0xa6, 0xf7, 0xd3, 0xa4, 0x29, 0xc5, 0x70,
+	0x6a, 0xa4, 0x3a, 0x00, 0xfa, 0xdb, 0xd7, 0xd4, 0x96, 0x28, 0x83, 0x9e,
+	0x31, 0x87, 0x24, 0x3f, 0x45, 0x6e, 0xe1, 0x4e
+};
+
+static const u8 kmac256_sample4[64] = {
+	0x20, 0xc5, 0x70, 0xc3, 0x13, 0x46, 0xf7, 0x03, 0xc9, 0xac, 0x36, 0xc6,
+	0x1c, 0x03, 0xcb, 0x64, 0xc3, 0x97, 0x0d, 0x0c, 0xfc, 0x78, 0x7e, 0x9b,
+	0x79, 0x59, 0x9d, 0x27, 0x3a, 0x68, 0xd2, 0xf7, 0xf6, 0x9d, 0x4c, 0xc3,
+	0xde, 0x9d, 0x10, 0x4a, 0x35, 0x16, 0x89, 0xf2, 0x7c, 0xf6, 0xf5, 0x95,
+	0x1f, 0x01, 0x03, 0xf3, 0x3f, 0x4f, 0x24, 0x87, 0x10, 0x24, 0xd9, 0xc2,
+	0x77, 0x73, 0xa8, 0xdd
+};
+
+static int
+memeq(const u8 *a, const u8 *b, size_t len)
+{
+	for (size_t i = 0; i < len; i++)
+		if (a[i] != b[i])
+			return 0;
+	return 1;
+}
+
+/*
+ * SHAKE128/256 of "", 500 bytes absorbed whole and in 37-byte pieces and
+ * squeezed whole and in odd pieces across block boundaries, then the
+ * SP 800-185 cSHAKE and KMAC samples.
+ */
+static int
+test_shake(void)
+{
+	static const u8 data[4] = { 0x00, 0x01, 0x02, 0x03 };
+	static u8 msg[500], a[3 * SHAKE128_RATE + 5], b[sizeof(a)];
+	static const char tag[] = "My Tagged Application";
+	u8 key[32];
+	struct sha3 x;
+	size_t i, n;
+
+	shake128(a, 32, msg, 0);
+	shake256(b, 32, msg, 0);
+	if (!memeq(a, shake128_empty, 32) || !memeq(b, shake256_empty, 32))
+		return -1;
+
+	for (i = 0; i < sizeof(msg); i++)
+		msg[i] = (u8)(i * 3 + 1);
+	shake128(a, sizeof(a), msg, sizeof(msg));
+	shake128_init(&x);
+	for (i = 0; i < sizeof(msg); i += n) {
+		n = sizeof(msg) - i > 37 ? 37 : sizeof(msg) - i;
+		shake_absorb(&x, msg + i, n);
+	}
+	for (i = 0, n = 1; i < sizeof(b); i += n, n = n * 5 + 2) {
+		n = sizeof(b) - i < n ? sizeof(b) - i : n;
+		shake_squeeze(&x, b + i, n);
+	}
+	if (!memeq(a, b, sizeof(a)))
+		return -1;
+
+	cshake128_init(&x, NULL, 0, (const u8 *)"Email Signature", 15);
+	shake_absorb(&x, data, sizeof(data));
+	shake_squeeze(&x, a, 32);
+	if (!memeq(a, cshake128_sample1, 32))
+		return -1;
+
+	for (i = 0; i < sizeof(key); i++)
+		key[i] = (u8)(0x40 + i);
+	kmac128_init(&x, key, sizeof(key), NULL, 0);
+	shake_absorb(&x, data, sizeof(data));
+	kmac_final(&x, a, 32);
+	if (!memeq(a, kmac128_sample1, 32))
+		return -1;
+
+	kmac256_init(&x, key, sizeof(key), (const u8 *)tag, sizeof(tag) - 1);
+	shake_absorb(&x, data, sizeof(data));
+	kmac_final(&x, a, 64);
+	if (!memeq(a, kmac256_sample4, 64))
+		return -1;
+	return 0;
+}
+#endif
+
+#if defined(CONFIG_CRYPTO_SHA3_MB)
+
+/*
+ * Batched SHA-3 over 11 states (more than any kernel has lanes, so a short
+ * last group too): SHA3-256 of 200 bytes against the one-stream digest,
+ * SHAKE128 of "" against the FIPS 202 value, and absorb + two squeezeblocks
+ * calls against one long shake128_mb output.
+ */
+static int
+test_sha3_mb(void)
+{
+	static u64 buf[40];
+	static u8 a[11][3 * SHAKE128_RATE], b[11][3 * SHAKE128_RATE];
+	u8 *msg = (u8 *)buf;
+	struct sha3 st[11], *sp[11];
+	const u8 *in[11];
+	u8 *out[11], *out2[11], d[SHA3_256_DIGEST_SIZE];
+	unsigned int i, k;
+
+	for (i = 0; i < sizeof(buf); i++)
+		msg[i] = (u8)(i * 7 + 3);
+	/* word-aligned: the SHA-3 backends load the message as u64 */
+	for (k = 0; k < 11; k++) {
+		in[k] = msg + 8 * k;
+		out[k] = a[k];
+		out2[k] = b[k];
+		sp[k] = &st[k];
+	}
+
+	sha3_256_mb(out, in, 200, 11);
+	for (k = 0; k < 11; k++) {
+		hash_msg(ALGORITHM_SHA3_256, in[k], 200, 0, d);
+		for (i = 0; i < SHA3_256_DIGEST_SIZE; i++)
+			if (a[k][i] != d[i])
+				return -1;
+	}
+
+	shake128_mb(out, 32, in, 0, 11);
+	for (k = 0; k < 11; k++)
+		for (i = 0; i < 32; i++)
+			if (a[k][i] != shake128_empty[i])
+				return -1;
+
+	shake128_mb(out, sizeof(a[0]), in, 34, 11);
+	shake128_mb_absorb(sp, in, 34, 11);
+	shake_mb_squeezeblocks(sp, out2, 1, 11);
+	for (k = 0; k < 11; k++)
+		out2[k] += SHAKE128_RATE;
+	shake_mb_squeezeblocks(sp, out2, 2, 11);
+	for (k = 0; k < 11; k++)
+		for (i = 0; i < sizeof(a[0]); i++)
+			if (a[k][i] != b[k][i])
+				return -1;
+	return 0;
+}
+#endif
+
 int
 main(int argc, char *argv[])
 {
@@ -46,5 +328,35 @@ main(int argc, char *argv[])
 		if (write(1, "sha3-256: FAIL\n", 15)) {}
 	}
 
+	if (test_sha2() == 0) {
+		if (write(1, "sha2: ok\n", 9)) {}
+	} else {
+		if (write(1, "sha2: FAIL\n", 11)) {}
+	}
+
+#if defined(CONFIG_CRYPTO_SHA2_MB)
+	if (test_sha256_mb() == 0) {
+		if (write(1, "sha256-mb: ok\n", 14)) {}
+	} else {
+		if (write(1, "sha256-mb: FAIL\n", 16)) {}
+	}
+#endif
+
+#ifdef HAVE_DIGEST_SHA3_BUILT_IN
+	if (test_shake() == 0) {
+		if (write(1, "shake: ok\n", 10)) {}
+	} else {
+		if (write(1, "shake: FAIL\n", 12)) {}
+	}
+#endif
+
+#if defined(CONFIG_CRYPTO_SHA3_MB)
+	if (test_sha3_mb() == 0) {
+		if (write(1, "sha3-mb: ok\n", 12)) {}
+	} else {
+		if (write(1, "sha3-mb: FAIL\n", 14)) {}
+	}
+#endif
+
 	return 0;
 }
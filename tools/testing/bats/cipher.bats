@@ -23,14 +23,39 @@ setup_file() {
     export CIPHER_BIN="${CIPHER_BIN:-}"
 }
 
-@test "cipher: standalone vectors (aes cbc/gcm, chacha20-poly1305)" {
+@test "cipher: standalone vectors (aes cbc/ctr/ccm/gcm, chacha20-poly1305)" {
     [ -n "${CIPHER_BIN}" ] || skip "cipher binary not built (run: make test)"
     run "${CIPHER_BIN}"
     [ "${status}" -eq 0 ]
     [[ "${output}" == *"aes-128-gcm: ok"* ]]
+    [[ "${output}" == *"aes-128-gcm-keyed: ok"* ]]
+    [[ "${output}" == *"aes-128-gcm-aad: ok"* ]]
+    [[ "${output}" == *"aes-128-gcm-bulk: ok"* ]]
+    [[ "${output}" == *"aes-128-gcm-explicit: ok"* ]]
+    [[ "${output}" == *"aes-128-gcm-compact: ok"* ]]
+    [[ "${output}" == *"aes-gcm-setkey-batch: ok"* ]]
+    [[ "${output}" == *"aes-gcm-setkey-bulk: ok"* ]]
+    [[ "${output}" == *"aes-128-gcm-stream: ok"* ]]
+    [[ "${output}" == *"aes-128-gcm-iov: ok"* ]]
+    [[ "${output}" == *"aes-gcm-open-mb: ok"* ]]
+    [[ "${output}" == *"aes-128-gcm-inplace: ok"* ]]
     [[ "${output}" == *"aes-256-gcm: ok"* ]]
     [[ "${output}" == *"aes-128-cbc: ok"* ]]
+    [[ "${output}" == *"aes-256-cbc-keyed: ok"* ]]
+    [[ "${output}" == *"aes-128-ctr: ok"* ]]
+    [[ "${output}" == *"aes-256-ctr: ok"* ]]
+    [[ "${output}" == *"aes-128-ccm: ok"* ]]
+    [[ "${output}" == *"aes-256-ccm-8: ok"* ]]
+    [[ "${output}" == *"poly1305-kat: ok"* ]]
+    [[ "${output}" == *"poly1305-lengths: ok"* ]]
+    [[ "${output}" == *"poly1305-mb: ok"* ]]
     [[ "${output}" == *"chacha20-poly1305: ok"* ]]
+    [[ "${output}" == *"chacha20-poly1305-iov: ok"* ]]
+    [[ "${output}" == *"chacha20-poly1305-inplace: ok"* ]]
+    [[ "${output}" == *"chachapoly-crypt-mb: ok"* ]]
+    [[ "${output}" == *"chacha20-bulk: ok"* ]]
+    [[ "${output}" == *"hchacha20: ok"* ]]
+    [[ "${output}" == *"xchacha20-poly1305-kat: ok"* ]]
     [[ "${output}" != *"FAIL"* ]]
 }
 
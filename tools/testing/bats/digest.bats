@@ -26,7 +26,13 @@ setup_file() {
     [ -n "${DIGEST_BIN}" ] || skip "digest binary not built (run: make test)"
     run "${DIGEST_BIN}"
     [ "${status}" -eq 0 ]
-    [[ "${output}" == "sha3-256: ok" ]]
+    [[ "${output}" == *"sha3-256: ok"* ]]
+    [[ "${output}" == *"sha2: ok"* ]]
+    # sha256-mb, shake and sha3-mb only run when their options are built in
+    [[ "${output}" != *"sha256-mb:"* || "${output}" == *"sha256-mb: ok"* ]]
+    [[ "${output}" != *"shake:"* || "${output}" == *"shake: ok"* ]]
+    [[ "${output}" != *"sha3-mb:"* || "${output}" == *"sha3-mb: ok"* ]]
+    [[ "${output}" != *"FAIL"* ]]
 }
 
 @test "digest: sha3-256 empty vs openssl" {
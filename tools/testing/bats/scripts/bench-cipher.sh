@@ -0,0 +1,233 @@
+#!/bin/bash
+#
+# bench-cipher.sh - Benchmark table-based, constant-time bitsliced and aws-lc
+#                   AES implementations
+#
+# Configures each built-in AES variant, builds, runs the cipher perf test,
+# collects results into a table and generates a bar chart (PNG). The aws-lc
+# variant is picked for the host architecture and skipped elsewhere.
+#
+# Usage: scripts/bench-cipher.sh [output_dir]
+
+set -e
+
+# scripts/ -> bats/ -> testing/ -> tools/ -> crypto package root.
+SRCDIR="$(cd "$(dirname "$0")/../../../.." && pwd)"
+OBJDIR="$SRCDIR/obj"
+OUTDIR="${1:-$OBJDIR/bench}"
+PERF_BIN="tools/testing/perf/cipher"
+# Single 64 KiB chunk per algorithm keeps one comparable row per variant.
+PERF_ARGS="-b 65536"
+
+mkdir -p "$OUTDIR"
+
+# Bootstrap a default config if none exists (e.g. after make distclean)
+if [ ! -f "$OBJDIR/.config" ]; then
+	make -C "$SRCDIR" -s defconfig 2>/dev/null
+fi
+
+cp "$OBJDIR/.config" "$OBJDIR/.config.bench-save"
+trap 'mv -f "$OBJDIR/.config.bench-save" "$OBJDIR/.config"; \
+      make -C "$SRCDIR" -s olddefconfig 2>/dev/null || true' EXIT
+
+case "$(uname -m)" in
+x86_64)		AWS_SEL=CONFIG_CRYPTO_CIPHER_AES_SEL_AWS_X86_64 ;;
+aarch64|arm64)	AWS_SEL=CONFIG_CRYPTO_CIPHER_AES_SEL_AWS_ARMV8 ;;
+*)		AWS_SEL= ;;
+esac
+
+write_config() {
+	local variant="$1"
+
+	grep -v \
+		-e CONFIG_MODULES \
+		-e CONFIG_CRYPTO_VERIFIED \
+		-e CONFIG_CRYPTO_CIPHER_AES_SEL \
+		-e CONFIG_CRYPTO_CIPHER_AES_GENERIC \
+		-e CONFIG_CRYPTO_CIPHER_AES_CT \
+		-e CONFIG_CRYPTO_CIPHER_AES_AWS \
+		-e CONFIG_CRYPTO_CIPHER_AES_DYN \
+		"$OBJDIR/.config.bench-save" > "$OBJDIR/.config" || true
+
+	cat >> "$OBJDIR/.config" <<-EOF
+	# CONFIG_MODULES is not set
+	# CONFIG_CRYPTO_VERIFIED is not set
+	EOF
+
+	case "$variant" in
+	generic)
+		echo "CONFIG_CRYPTO_CIPHER_AES_SEL_GENERIC=y" >> "$OBJDIR/.config"
+		;;
+	ct)
+		echo "CONFIG_CRYPTO_CIPHER_AES_SEL_CT=y" >> "$OBJDIR/.config"
+		;;
+	aws)
+		echo "$AWS_SEL=y" >> "$OBJDIR/.config"
+		;;
+	esac
+}
+
+build_variant() {
+	local variant="$1"
+
+	printf "==> %-8s configuring... " "$variant"
+	write_config "$variant"
+	make -C "$SRCDIR" -s olddefconfig
+	printf "building... "
+	make -C "$SRCDIR" -s clean 2>/dev/null || true
+	if ! make -C "$SRCDIR" -j"$(nproc)" tools/testing/perf/ 2>&1; then
+		printf "FAILED\n"
+		echo "ERROR: build failed for variant '$variant'" >&2
+		return 1
+	fi
+	printf "done\n"
+}
+
+run_variant() {
+	local variant="$1"
+	local out="$OUTDIR/cipher-$variant.txt"
+
+	printf "==> %-8s benchmarking...\n" "$variant"
+	"$OBJDIR/$PERF_BIN" $PERF_ARGS > "$out" 2>&1
+	cat "$out"
+	echo
+}
+
+# ---------- main ----------
+
+BUILT_VARIANTS=""
+
+for v in generic ct ${AWS_SEL:+aws}; do
+	if build_variant "$v"; then
+		run_variant "$v"
+		BUILT_VARIANTS="$BUILT_VARIANTS $v"
+	fi
+done
+
+VARIANTS="${BUILT_VARIANTS# }"
+
+# ---------- Display labels ----------
+
+display_name() {
+	case "$1" in
+	generic)  echo "aes-table"     ;;
+	ct)       echo "aes-bitsliced" ;;
+	aws)      echo "aes-aws"       ;;
+	*)        echo "$1"            ;;
+	esac
+}
+
+# ---------- Combined table ----------
+
+echo "=========================================="
+echo "           Combined Results"
+echo "=========================================="
+printf "%-18s" "Algorithm"
+for v in $VARIANTS; do
+	printf "  %14s" "$(display_name "$v")"
+done
+printf "\n"
+printf "%-18s" "---------"
+for v in $VARIANTS; do
+	printf "  %14s" "--------------"
+done
+printf "\n"
+
+# Collect algo list from the table-based run
+algos=$(grep "Gbps" "$OUTDIR/cipher-generic.txt" | awk '{print $1}')
+
+for algo in $algos; do
+	printf "%-18s" "$algo"
+	for v in $VARIANTS; do
+		gbps=$(grep "^  $algo " "$OUTDIR/cipher-$v.txt" | \
+		       grep -o '[0-9.]*  *Gbps' | awk '{print $1}')
+		printf "  %11s Gbps" "${gbps:-n/a}"
+	done
+	printf "\n"
+done
+
+RESULTS="$OUTDIR/cipher-results.tsv"
+{
+	printf "Algorithm"
+	for v in $VARIANTS; do printf "\t%s" "$(display_name "$v")"; done
+	printf "\n"
+	for algo in $algos; do
+		printf "%s" "$algo"
+		for v in $VARIANTS; do
+			gbps=$(grep "^  $algo " "$OUTDIR/cipher-$v.txt" | \
+			       grep -o '[0-9.]*  *Gbps' | awk '{print $1}')
+			printf "\t%s" "${gbps:-0}"
+		done
+		printf "\n"
+	done
+} > "$RESULTS"
+
+echo
+echo "Table saved to $RESULTS"
+
+# ---------- Generate graph ----------
+
+GRAPH="$OUTDIR/bench-cipher.png"
+
+python3 - "$OUTDIR" "$GRAPH" "$VARIANTS" <<'PYEOF'
+import sys, os, re
+from collections import OrderedDict
+
+outdir   = sys.argv[1]
+graph    = sys.argv[2]
+variants = sys.argv[3].split()
+
+data = OrderedDict()
+for v in variants:
+    path = os.path.join(outdir, "cipher-" + v + ".txt")
+    with open(path) as f:
+        for line in f:
+            m = re.search(
+                r'^\s+(\S+)\s+\d+\s+(?:KiB|B)\s+\d+\s+[\d.]+\s+MB/s\s+([\d.]+)\s+Gbps',
+                line)
+            if m:
+                algo, gbps = m.group(1), float(m.group(2))
+                data.setdefault(algo, OrderedDict())[v] = gbps
+
+if not data:
+    print("No data to plot.")
+    sys.exit(0)
+
+try:
+    import matplotlib
+    matplotlib.use('Agg')
+    import matplotlib.pyplot as plt
+    import numpy as np
+except ImportError:
+    print("matplotlib not available — install with: pip3 install matplotlib")
+    sys.exit(0)
+
+algos = list(data.keys())
+n = len(algos)
+x = np.arange(n)
+width = 0.8 / max(len(variants), 1)
+labels = {'generic': 'aes-table', 'ct': 'aes-bitsliced', 'aws': 'aes-aws'}
+colors = {'generic': '#5b9bd5', 'ct': '#ed7d31', 'aws': '#70ad47'}
+
+fig, ax = plt.subplots(figsize=(max(10, n * 1.2), 6))
+
+for i, v in enumerate(variants):
+    vals = [data[a].get(v, 0) for a in algos]
+    bars = ax.bar(x + i * width, vals, width, label=labels.get(v, v), color=colors.get(v))
+    for bar, val in zip(bars, vals):
+        if val > 0:
+            ax.text(bar.get_x() + bar.get_width() / 2,
+                    bar.get_height() + 0.3,
+                    f'{val:.1f}', ha='center', va='bottom', fontsize=7)
+
+ax.set_xlabel('Algorithm')
+ax.set_ylabel('Throughput (Gbps)')
+ax.set_title('AES Performance: table-based vs constant-time bitsliced vs aws-lc')
+ax.set_xticks(x + width * (len(variants) - 1) / 2)
+ax.set_xticklabels(algos, rotation=30, ha='right')
+ax.legend()
+ax.grid(axis='y', alpha=0.3)
+fig.tight_layout()
+fig.savefig(graph, dpi=150)
+print(f"\nGraph saved to {graph}")
+PYEOF
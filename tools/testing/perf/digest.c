@@ -4,10 +4,17 @@
  * update + final), against whichever backend the crypto build selected. Run
  * with -b <bytes> for a single fixed size, -t <secs> to change the per-point
  * budget.
+ *
+ * -m instead compares multi-buffer SHA-256 (sha256_mb) with hashing the same
+ * batch one message at a time, in messages per second for 64 B .. 1 KiB
+ * messages (or the -b size).
  */
 #include <hpc/compiler.h>
 #include <crypto/digest.h>
 #include <crypto/init.h>
+#if defined(CONFIG_CRYPTO_SHA2_MB)
+#include <crypto/digest/sha256-mb.h>
+#endif
 #include "bench.h"
 
 struct algo_info {
@@ -74,6 +81,60 @@ bench(const struct algo_info *a, unsigned int size)
 	bench_row(a->name, size, iters, t1 - t0, bytes);
 }
 
+#if defined(CONFIG_CRYPTO_SHA2_MB)
+/* messages per batch, enough to keep 16 lanes busy between flushes */
+#define MB_BATCH 256
+
+static void
+bench_sha256_mb(void)
+{
+	static const unsigned int lens[] = { 64, 128, 256, 512, 1024 };
+	static struct sha256_mb_job job[MB_BATCH];
+	unsigned int nlens = bench_fixed ? 1 : sizeof(lens) / sizeof(*lens);
+
+	printf("SHA2-256 multi-buffer, %s, %u messages per batch\n",
+	       sha256_mb_desc(), MB_BATCH);
+	printf("  %-7s %14s %14s %8s\n",
+	       "bytes", "one-by-one", "multi-buffer", "speedup");
+	for (unsigned int l = 0; l < nlens; l++) {
+		unsigned int len = bench_fixed ? bench_fixed : lens[l];
+		unsigned long iters = 0, mbiters = 0;
+		double t0, t1, a, b;
+		struct digest ctx;
+
+		if ((unsigned long)len * MB_BATCH > BENCH_MAX_SIZE)
+			break;
+		for (unsigned int i = 0; i < MB_BATCH; i++) {
+			job[i].msg = bench_data + (size_t)i * len;
+			job[i].len = len;
+		}
+
+		t0 = bench_now();
+		do {
+			for (unsigned int i = 0; i < MB_BATCH; i++) {
+				digest_init(&ctx, ALGORITHM_SHA2_256);
+				digest_update(&ctx, job[i].msg, len);
+				digest_final(&ctx, job[i].digest);
+			}
+			iters++;
+			t1 = bench_now();
+		} while (t1 - t0 < bench_secs);
+		a = (double)iters * MB_BATCH / (t1 - t0);
+
+		t0 = bench_now();
+		do {
+			sha256_mb(job, MB_BATCH);
+			mbiters++;
+			t1 = bench_now();
+		} while (t1 - t0 < bench_secs);
+		b = (double)mbiters * MB_BATCH / (t1 - t0);
+
+		printf("  %-7u %10.3f M/s %10.3f M/s %7.2fx\n",
+		       len, a / 1e6, b / 1e6, b / a);
+	}
+}
+#endif
+
 int
 main(int argc, char *argv[])
 {
@@ -85,6 +146,17 @@ main(int argc, char *argv[])
 	crypto_init();
 	memset(bench_data, 0x5a, sizeof(bench_data));
 
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-m"))
+			continue;
+#if defined(CONFIG_CRYPTO_SHA2_MB)
+		bench_sha256_mb();
+#else
+		printf("multi-buffer SHA-256 not configured\n");
+#endif
+		return 0;
+	}
+
 	nsizes = bench_chunks(BENCH_MAX_SIZE, sizes);
 	bench_header("Digest");
 